@@ -2,12 +2,16 @@
 //======= Breadth-first Search =======//
 //
 // Usage: ./bfs.exe --dataset <dataset path> --root <root vertex id>
+//                  --mode <topdown|bottomup|hybrid>
+//                  --roots <root list file> --lanes <64|256>
 
 #include "common.h"
 #include "def.h"
 #include "perf.h"
 
 #include "openG.h"
+#include "frontier.h"
+#include "msbfs.h"
 #include <queue>
 #include "omp.h"
 
@@ -22,6 +26,11 @@
 using namespace std;
 
 #define MY_INFINITY 0xfff0
+// direction switch heuristic of the hybrid mode. go bottom-up when the
+// frontier's edges exceed 1/ALPHA of the unexplored edges, back to
+// top-down when the frontier drops below 1/BETA of the vertices
+#define DO_ALPHA 15
+#define DO_BETA 18
 size_t beginiter = 0;
 size_t enditer = 0;
 
@@ -52,6 +61,10 @@ typedef graph_t::edge_iterator      edge_iterator;
 void arg_init(argument_parser & arg)
 {
     arg.add_arg("root","0","root/starting vertex");
+    arg.add_arg("mode","topdown","topdown: push only, bottomup: pull from unvisited vertices, hybrid: direction-optimizing");
+    arg.add_arg("snapshot","","graph snapshot file. opened if it exists, otherwise written after csv loading");
+    arg.add_arg("roots","","file of root vertex ids. runs a multi-source bfs from all of them instead of --root");
+    arg.add_arg("lanes","64","sources per multi-source traversal, 64 or 256");
 }
 //==============================================================//
 
@@ -74,10 +87,6 @@ public:
         black_access=0;
     }
 };
-inline unsigned vertex_distributor(uint64_t vid, unsigned threadnum)
-{
-    return vid%threadnum;
-}
 void parallel_bfs(graph_t& g, size_t root, unsigned threadnum, gBenchPerf_multi & perf, int perf_group)
 {
     // initializzation
@@ -86,35 +95,31 @@ void parallel_bfs(graph_t& g, size_t root, unsigned threadnum, gBenchPerf_multi
 
     rootvit->property().level = 0;
 
-    vector<vector<uint64_t> > global_input_tasks(threadnum);
-    global_input_tasks[vertex_distributor(root, threadnum)].push_back(root);
-    
-    vector<vector<uint64_t> > global_output_tasks(threadnum*threadnum);
+    frontier front(g.vid_bound(), threadnum);
+    front.push(0, root);
+    front.advance();
 
-    bool stop = false;
-    #pragma omp parallel num_threads(threadnum) shared(stop,global_input_tasks,global_output_tasks,perf) 
+    #pragma omp parallel num_threads(threadnum) shared(front,perf) 
     {
         unsigned tid = omp_get_thread_num();
-        vector<uint64_t> & input_tasks = global_input_tasks[tid];
       
         perf.open(tid, perf_group);
         perf.start(tid, perf_group); 
 #ifdef SIM
         unsigned iter = 0;
 #endif       
-        while(!stop)
+        while(!front.empty())
         {
-            #pragma omp barrier
-            // process local queue
-            stop = true;
+            // process local share of the frontier
 #ifdef SIM
             SIM_BEGIN(iter==beginiter);
             iter++;
 #endif            
-        
-            for (unsigned i=0;i<input_tasks.size();i++)
+            uint64_t begin, end;
+            front.range(tid, begin, end);
+            for (uint64_t i=begin;i<end;i++)
             {
-                uint64_t vid=input_tasks[i];
+                uint64_t vid=front[i];
                 vertex_iterator vit = g.find_vertex(vid);
                 uint16_t curr_level = vit->property().level;
                 
@@ -130,7 +135,7 @@ void parallel_bfs(graph_t& g, size_t root, unsigned threadnum, gBenchPerf_multi
                                 MY_INFINITY,curr_level+1))
 #endif
                     {
-                        global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                        front.push(tid, dest_vid);
                     }
                 }
             }
@@ -138,18 +143,10 @@ void parallel_bfs(graph_t& g, size_t root, unsigned threadnum, gBenchPerf_multi
             SIM_END(iter==enditer);
 #endif            
             #pragma omp barrier
-            input_tasks.clear();
-            for (unsigned i=0;i<threadnum;i++)
-            {
-                if (global_output_tasks[i*threadnum+tid].size()!=0)
-                {
-                    stop = false;
-                    input_tasks.insert(input_tasks.end(),
-                            global_output_tasks[i*threadnum+tid].begin(),
-                            global_output_tasks[i*threadnum+tid].end());
-                    global_output_tasks[i*threadnum+tid].clear();
-                }
-            }
+            #pragma omp master
+            front.plan();
+            #pragma omp barrier
+            front.build(tid);
             #pragma omp barrier
         }
 #ifdef SIM
@@ -160,6 +157,187 @@ void parallel_bfs(graph_t& g, size_t root, unsigned threadnum, gBenchPerf_multi
 
 }
 
+//==============================================================//
+// direction-optimizing bfs. a top-down step pushes from a sparse queue
+// of frontier vertices. a bottom-up step lets every unvisited vertex
+// scan its predecessors for a parent in a frontier bitmap, and stops at
+// the first one found.
+
+class level_stat
+{
+public:
+    level_stat(bool b, uint64_t f, uint64_t e, double t)
+        :bottomup(b),frontier(f),edges(e),time(t){}
+
+    bool bottomup;
+    uint64_t frontier;  // # of vertices visited at this level
+    uint64_t edges;     // # of edges inspected
+    double time;
+};
+
+inline bool bitmap_test(const vector<uint64_t>& bm, uint64_t vid)
+{
+    return (bm[vid>>6] & (1ULL<<(vid&63))) != 0;
+}
+
+// a bottom-up step scans in edges, undirected graphs keep them as out edges
+inline edge_iterator preds_begin(graph_t& g, vertex_iterator vit)
+{
+    return (g.get_directness()==openG::DIRECTED) ? vit->preds_begin() : vit->edges_begin();
+}
+inline edge_iterator preds_end(graph_t& g, vertex_iterator vit)
+{
+    return (g.get_directness()==openG::DIRECTED) ? vit->preds_end() : vit->edges_end();
+}
+
+void hybrid_bfs(graph_t& g, size_t root, unsigned threadnum, string mode,
+        vector<level_stat>& stats, gBenchPerf_event & perf, int perf_group)
+{
+    vertex_iterator rootvit=g.find_vertex(root);
+    if (rootvit==g.vertices_end()) return;
+
+    perf.open(perf_group);
+    perf.start(perf_group);
+
+    uint64_t bound = g.vid_bound();
+    uint64_t words = (bound+63)/64;
+    vector<uint64_t> curr_bm(words, 0), next_bm(words, 0);
+    vector<uint64_t> queue;
+    vector<vector<uint64_t> > next_queues(threadnum);
+
+    rootvit->property().level = 0;
+    queue.push_back(root);
+
+    // frontier size, its out degree and out degree of unvisited vertices
+    uint64_t nf = 1;
+    uint64_t mf = rootvit->edges_size();
+    uint64_t mu = g.num_edges() - mf;
+    bool bottomup = (mode=="bottomup");
+    bool in_bitmap = false;
+    uint64_t prev_nf = 0;
+    uint16_t level = 0;
+#ifdef SIM
+    SIM_BEGIN(true);
+#endif
+    while (nf > 0)
+    {
+        double t1 = timer::get_usec();
+        if (mode=="hybrid")
+        {
+            if (!bottomup && mf > mu/DO_ALPHA) bottomup = true;
+            else if (bottomup && nf < prev_nf && nf < bound/DO_BETA) bottomup = false;
+        }
+
+        uint64_t edges=0, new_nf=0, new_mf=0;
+        if (bottomup)
+        {
+            if (!in_bitmap)
+            {
+                std::fill(curr_bm.begin(), curr_bm.end(), 0);
+                #pragma omp parallel for num_threads(threadnum)
+                for (size_t i=0;i<queue.size();i++)
+                    __sync_fetch_and_or(&(curr_bm[queue[i]>>6]), 1ULL<<(queue[i]&63));
+                in_bitmap = true;
+            }
+
+            // a word of the next bitmap is owned by one thread
+            #pragma omp parallel for num_threads(threadnum) schedule(dynamic,64) reduction(+:edges,new_nf,new_mf)
+            for (uint64_t w=0;w<words;w++)
+            {
+                uint64_t word=0;
+                uint64_t end = std::min(w*64+64, bound);
+                for (uint64_t vid=w*64;vid<end;vid++)
+                {
+                    vertex_iterator vit = g.find_vertex(vid);
+                    if (vit==g.vertices_end() || vit->property().level!=MY_INFINITY) continue;
+
+                    for (edge_iterator eit=preds_begin(g,vit);eit!=preds_end(g,vit);eit++)
+                    {
+                        edges++;
+                        if (bitmap_test(curr_bm, eit->target()))
+                        {
+                            vit->property().level = level+1;
+                            word |= 1ULL<<(vid&63);
+                            new_nf++;
+                            new_mf += vit->edges_size();
+                            break;
+                        }
+                    }
+                }
+                next_bm[w] = word;
+            }
+            curr_bm.swap(next_bm);
+        }
+        else
+        {
+            if (in_bitmap)
+            {
+                // bitmap to queue, in vertex order
+                queue.clear();
+                for (uint64_t w=0;w<words;w++)
+                {
+                    uint64_t word = curr_bm[w];
+                    for (unsigned b=0;word!=0;b++,word>>=1)
+                        if (word & 1) queue.push_back(w*64+b);
+                }
+                in_bitmap = false;
+            }
+
+            #pragma omp parallel num_threads(threadnum) reduction(+:edges,new_nf,new_mf)
+            {
+                vector<uint64_t> & next = next_queues[omp_get_thread_num()];
+                next.clear();
+                #pragma omp for schedule(dynamic,64)
+                for (size_t i=0;i<queue.size();i++)
+                {
+                    vertex_iterator vit = g.find_vertex(queue[i]);
+                    for (edge_iterator eit=vit->edges_begin();eit!=vit->edges_end();eit++)
+                    {
+                        edges++;
+                        uint64_t dest_vid = eit->target();
+                        vertex_iterator destvit = g.find_vertex(dest_vid);
+                        if (destvit->property().level == MY_INFINITY &&
+                            __sync_bool_compare_and_swap(&(destvit->property().level),
+                                MY_INFINITY,level+1))
+                        {
+                            next.push_back(dest_vid);
+                            new_nf++;
+                            new_mf += destvit->edges_size();
+                        }
+                    }
+                }
+            }
+            queue.clear();
+            for (unsigned i=0;i<threadnum;i++)
+                queue.insert(queue.end(), next_queues[i].begin(), next_queues[i].end());
+        }
+
+        stats.push_back(level_stat(bottomup, nf, edges, timer::get_usec()-t1));
+        prev_nf = nf;
+        nf = new_nf;
+        mf = new_mf;
+        mu = (mu > mf) ? mu-mf : 0;
+        level++;
+    }
+#ifdef SIM
+    SIM_END(true);
+#endif
+    perf.stop(perf_group);
+}
+
+void print_level_stats(vector<level_stat>& stats)
+{
+    uint64_t total=0;
+    for (size_t i=0;i<stats.size();i++)
+    {
+        cout<<"== level "<<i<<": "<<(stats[i].bottomup?"bottom-up":"top-down ")
+            <<"  frontier "<<stats[i].frontier<<"  edges "<<stats[i].edges
+            <<"  time "<<stats[i].time<<" sec\n";
+        total += stats[i].edges;
+    }
+    cout<<"== edges inspected: "<<total<<"\n";
+}
+
 void bfs(graph_t& g, size_t root, BFSVisitor& vis, gBenchPerf_event & perf, int perf_group) 
 {
     perf.open(perf_group);
@@ -225,6 +403,186 @@ void bfs(graph_t& g, size_t root, BFSVisitor& vis, gBenchPerf_event & perf, int
     perf.stop(perf_group);
 
 }  // end bfs
+//==============================================================//
+// multi-source bfs from a list of roots, "lanes" roots per traversal.
+// the out edges are copied once into a csr that all traversals share.
+// per root, the vertices reached, the eccentricity, the sum of the
+// distances (closeness) and the out edges of the reached vertices are
+// collected. the latter sum is what a single-source bfs would traverse.
+
+class root_stat
+{
+public:
+    root_stat():root(0),reached(0),depth(0),distance(0),edges(0){}
+
+    uint64_t root;
+    uint64_t reached;
+    uint64_t depth;
+    uint64_t distance;
+    uint64_t edges;
+};
+
+class bfs_csr
+{
+public:
+    vector<uint64_t> offsets;
+    vector<uint64_t> adj;
+};
+
+void build_csr(graph_t& g, bfs_csr& csr)
+{
+    uint64_t bound = g.vid_bound();
+    csr.offsets.assign(bound+1, 0);
+    for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++) 
+        csr.offsets[vit->id()+1] = vit->edges_size();
+    for (uint64_t i=0;i<bound;i++)
+        csr.offsets[i+1] += csr.offsets[i];
+
+    csr.adj.resize(csr.offsets[bound]);
+    for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++) 
+    {
+        uint64_t pos = csr.offsets[vit->id()];
+        for (edge_iterator eit=vit->edges_begin(); eit!=vit->edges_end(); eit++)
+            csr.adj[pos++] = eit->target();
+    }
+}
+
+template <unsigned WORDS>
+void multi_bfs(bfs_csr& csr, vector<uint64_t>& roots, unsigned threadnum,
+        vector<root_stat>& stats, uint64_t& scanned, 
+        gBenchPerf_event & perf, int perf_group)
+{
+    typedef multi_source_bfs<WORDS> engine_t;
+    typedef typename engine_t::mask_t mask_t;
+    const unsigned lanes = engine_t::LANES;
+
+    perf.open(perf_group);
+    perf.start(perf_group);
+
+    uint64_t bound = csr.offsets.size()-1;
+    const uint64_t * adj = csr.adj.empty() ? NULL : &(csr.adj[0]);
+    engine_t ms(bound);
+    // per thread lane counters: reached, distance, edges
+    vector<vector<uint64_t> > counters(threadnum, vector<uint64_t>(3*lanes));
+
+    stats.assign(roots.size(), root_stat());
+    scanned = 0;
+#ifdef SIM
+    SIM_BEGIN(true);
+#endif
+    for (size_t first=0;first<roots.size();first+=lanes)
+    {
+        unsigned n = std::min<size_t>(lanes, roots.size()-first);
+        ms.start(&(roots[first]), n);
+        for (unsigned t=0;t<threadnum;t++)
+            std::fill(counters[t].begin(), counters[t].end(), 0);
+        for (unsigned i=0;i<n;i++)
+        {
+            uint64_t r = roots[first+i];
+            stats[first+i].root = r;
+            stats[first+i].reached = 1;
+            counters[0][i] = 1;
+            counters[0][2*lanes+i] = csr.offsets[r+1]-csr.offsets[r];
+        }
+
+        uint64_t level = 0;
+        bool active = true;
+        while (active)
+        {
+            uint64_t edges = 0;
+            #pragma omp parallel for num_threads(threadnum) schedule(dynamic,256) reduction(+:edges)
+            for (uint64_t v=0;v<bound;v++)
+                edges += ms.expand(v, adj+csr.offsets[v], adj+csr.offsets[v+1]);
+            scanned += edges;
+            level++;
+
+            uint64_t fresh_cnt = 0;
+            #pragma omp parallel num_threads(threadnum) reduction(+:fresh_cnt)
+            {
+                vector<uint64_t> & cnt = counters[omp_get_thread_num()];
+                mask_t fresh;
+                #pragma omp for schedule(dynamic,256)
+                for (uint64_t v=0;v<bound;v++)
+                {
+                    if (!ms.settle(v, fresh)) continue;
+                    fresh_cnt++;
+                    uint64_t degree = csr.offsets[v+1]-csr.offsets[v];
+                    for (unsigned k=0;k<WORDS;k++)
+                    {
+                        for (uint64_t word=fresh.w[k];word!=0;word&=word-1)
+                        {
+                            unsigned lane = k*64 + __builtin_ctzll(word);
+                            cnt[lane]++;
+                            cnt[lanes+lane] += level;
+                            cnt[2*lanes+lane] += degree;
+                        }
+                    }
+                }
+            }
+            active = (fresh_cnt!=0);
+
+            // eccentricity of the lanes that still advance
+            if (active)
+            {
+                for (unsigned i=0;i<n;i++)
+                {
+                    uint64_t reached=0;
+                    for (unsigned t=0;t<threadnum;t++) reached += counters[t][i];
+                    if (reached > stats[first+i].reached)
+                    {
+                        stats[first+i].reached = reached;
+                        stats[first+i].depth = level;
+                    }
+                }
+            }
+        }
+
+        for (unsigned i=0;i<n;i++)
+        {
+            root_stat & st = stats[first+i];
+            st.reached = st.distance = st.edges = 0;
+            for (unsigned t=0;t<threadnum;t++)
+            {
+                st.reached += counters[t][i];
+                st.distance += counters[t][lanes+i];
+                st.edges += counters[t][2*lanes+i];
+            }
+        }
+    }
+#ifdef SIM
+    SIM_END(true);
+#endif
+    perf.stop(perf_group);
+}
+
+bool load_roots(string file, graph_t& g, vector<uint64_t>& roots)
+{
+    ifstream ifs(file.c_str());
+    if (!ifs.good())
+    {
+        cerr<<"cannot open root file: "<<file<<endl;
+        return false;
+    }
+    uint64_t vid;
+    while (ifs >> vid)
+    {
+        if (g.find_vertex(vid)==g.vertices_end())
+            cerr<<"wrong root vertex: "<<vid<<", skipped"<<endl;
+        else
+            roots.push_back(vid);
+    }
+    return true;
+}
+
+void print_root_stats(vector<root_stat>& stats)
+{
+    for (size_t i=0;i<stats.size();i++)
+    {
+        cout<<"== root "<<stats[i].root<<": reached "<<stats[i].reached
+            <<"  depth "<<stats[i].depth<<"  distance sum "<<stats[i].distance<<"\n";
+    }
+}
+
 //==============================================================//
 
 void output(graph_t& g)
@@ -267,9 +625,24 @@ int main(int argc, char * argv[])
     arg.get_value("dataset",path);
     arg.get_value("separator",separator);
 
+    string snapshot;
+    arg.get_value("snapshot",snapshot);
+
     size_t root,threadnum;
     arg.get_value("root",root);
     arg.get_value("threadnum",threadnum);
+    string mode;
+    arg.get_value("mode",mode);
+    string rootfile;
+    arg.get_value("roots",rootfile);
+    size_t lanes;
+    arg.get_value("lanes",lanes);
+    if ((mode!="topdown" && mode!="bottomup" && mode!="hybrid") ||
+        (lanes!=64 && lanes!=256))
+    {
+        arg.help();
+        return -1;
+    }
 #ifdef SIM
     arg.get_value("beginiter",beginiter);
     arg.get_value("enditer",enditer);
@@ -284,15 +657,22 @@ int main(int argc, char * argv[])
     string vfile = path + "/vertex.csv";
     string efile = path + "/edge.csv";
 
+    if (!snapshot.empty() && ifstream(snapshot.c_str()).good())
+    {
+        if (graph.open_snapshot(snapshot, threadnum) == false)
+            return -1;
+    }
+    else
+    {
 #ifndef EDGES_ONLY
-    if (graph.load_csv_vertices(vfile, true, separator, 0) == -1)
-        return -1;
-    if (graph.load_csv_edges(efile, true, separator, 0, 1) == -1) 
-        return -1;
-#else
-    if (graph.load_csv_edges(efile, true, separator, 0, 1) == -1)
-        return -1;
+        if (graph.load_csv_vertices(vfile, true, separator, 0) == -1)
+            return -1;
 #endif
+        if (graph.load_csv_edges_parallel(efile, true, separator, 0, 1, threadnum) == -1) 
+            return -1;
+        if (!snapshot.empty() && graph.save_snapshot(snapshot) == false)
+            return -1;
+    }
 
     size_t vertex_num = graph.vertex_num();
     size_t edge_num = graph.edge_num();
@@ -303,6 +683,63 @@ int main(int argc, char * argv[])
     cout<<"== time: "<<t2-t1<<" sec\n";
 #endif
 
+    if (!rootfile.empty())
+    {
+        vector<uint64_t> roots;
+        if (load_roots(rootfile, graph, roots) == false)
+            return -1;
+
+        cout<<"\npreparing csr...\n";
+        t1 = timer::get_usec();
+        bfs_csr csr;
+        build_csr(graph, csr);
+        t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+        cout<<"== time: "<<t2-t1<<" sec\n";
+#endif
+
+        cout<<"\nmulti-source BFS: "<<roots.size()<<" roots, "<<lanes<<" lanes\n";
+
+        unsigned run_num = ceil(perf.get_event_cnt() /(double) DEFAULT_PERF_GRP_SZ);
+        if (run_num==0) run_num = 1;
+        double elapse_time = 0;
+        vector<root_stat> stats;
+        uint64_t scanned = 0;
+
+        for (unsigned i=0;i<run_num;i++)
+        {
+            t1 = timer::get_usec();
+            if (lanes==64)
+                multi_bfs<1>(csr, roots, threadnum, stats, scanned, perf, i);
+            else
+                multi_bfs<4>(csr, roots, threadnum, stats, scanned, perf, i);
+            t2 = timer::get_usec();
+            elapse_time += t2-t1;
+        }
+        cout<<"BFS finish: \n";
+
+        // edges a separate bfs per root would traverse
+        uint64_t traversed = 0;
+        for (size_t i=0;i<stats.size();i++)
+            traversed += stats[i].edges;
+        cout<<"== edges scanned: "<<scanned<<"  traversed by the roots: "<<traversed<<"\n";
+
+#ifndef ENABLE_VERIFY
+        elapse_time /= run_num;
+        cout<<"== time: "<<elapse_time<<" sec\n";
+        cout<<"== aggregate TEPS: "<<traversed/elapse_time<<"\n";
+        perf.print();
+#endif
+
+#ifdef ENABLE_OUTPUT
+        cout<<"\n";
+        print_root_stats(stats);
+#endif
+
+        cout<<"=================================================================="<<endl;
+        return 0;
+    }
+
     BFSVisitor vis;
 
     cout<<"\nBFS root: "<<root<<"\n";
@@ -311,12 +748,16 @@ int main(int argc, char * argv[])
     unsigned run_num = ceil(perf.get_event_cnt() /(double) DEFAULT_PERF_GRP_SZ);
     if (run_num==0) run_num = 1;
     double elapse_time = 0;
+    vector<level_stat> stats;
     
     for (unsigned i=0;i<run_num;i++)
     {
         t1 = timer::get_usec();
 
-        if (threadnum==1)
+        stats.clear();
+        if (mode!="topdown")
+            hybrid_bfs(graph, root, threadnum, mode, stats, perf, i);
+        else if (threadnum==1)
             bfs(graph, root, vis, perf, i);
         else
             parallel_bfs(graph, root, threadnum, perf_multi, i);
@@ -329,7 +770,9 @@ int main(int argc, char * argv[])
 
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<elapse_time/run_num<<" sec\n";
-    if (threadnum == 1)
+    if (mode!="topdown")
+        print_level_stats(stats);
+    if (threadnum == 1 || mode!="topdown")
         perf.print();
     else
         perf_multi.print();
@@ -2,12 +2,14 @@
 //======= Graph Moralization =======//
 //
 // Usage: ./moralization --dataset <dataset path>
+//                       --bulk <emit/dedup/bulk-build pipeline>
 
 #include "common.h"
 #include "def.h"
 #include "perf.h"
 #include "openG.h"
 #include "omp.h"
+#include <algorithm>
 #ifdef SIM
 #include "SIM.h"
 #endif
@@ -39,7 +41,10 @@ typedef graph_t::edge_iterator      edge_iterator;
 
 
 //==============================================================//
-
+void arg_init(argument_parser & arg)
+{
+    arg.add_arg("bulk","0","emit, sort and dedup the moral edges per thread, then bulk-build the moral graph", false);
+}
 //==============================================================//
 
 void moralize(graph_t & dag, graph_t & ug)
@@ -138,6 +143,151 @@ void parallel_moralize(graph_t & dag, graph_t & ug)
     }
 }
 //==============================================================//
+// moralization in three phases without locks or edge lookups. threads
+// emit the dag edges and the parent pairs of every vertex into their
+// own buffers, as (smaller id, larger id). the edges are bucketed by
+// the smaller end point, each bucket is sorted and deduplicated, and
+// the moral graph is built with build_from_edge_list(). a dag edge
+// keeps its property, an edge only from a parent pair gets the default
+
+class moral_edge
+{
+public:
+    moral_edge(){}
+    moral_edge(uint64_t u, uint64_t v, bool d, const edge_property& p)
+        :src(std::min(u,v)),dest(std::max(u,v)),dag(d),prop(p){}
+
+    uint64_t src;
+    uint64_t dest;
+    bool dag;
+    edge_property prop;
+};
+
+// by dest, dag edges first
+class moral_edge_less
+{
+public:
+    bool operator()(const moral_edge& a, const moral_edge& b)
+    {
+        return (a.dest!=b.dest) ? (a.dest<b.dest) : (a.dag && !b.dag);
+    }
+};
+
+class moral_timing
+{
+public:
+    moral_timing():emit(0),dedup(0),build(0),edges(0){}
+
+    double emit;
+    double dedup;
+    double build;
+    uint64_t edges;     // undirected edges of the moral graph
+};
+
+void bulk_moralize(graph_t & dag, graph_t & ug, moral_timing & tm)
+{
+    double t1, t2;
+    t1 = timer::get_usec();
+
+    uint64_t bound = dag.vid_bound();
+    vector<uint64_t> vids;
+    for (vertex_iterator vit=dag.vertices_begin(); vit!=dag.vertices_end(); vit++)
+        vids.push_back(vit->id());
+
+    // phase 1: emit candidate edges
+    vector<vector<moral_edge> > buffers(threadnum);
+    #pragma omp parallel num_threads(threadnum)
+    {
+        vector<moral_edge> & buf = buffers[omp_get_thread_num()];
+#ifdef SIM
+        SIM_BEGIN(true);
+#endif 
+        #pragma omp for schedule(dynamic,64)
+        for (size_t i=0;i<vids.size();i++)
+        {
+            vertex_iterator vit = dag.find_vertex(vids[i]);
+            for (edge_iterator eit=vit->edges_begin(); eit!=vit->edges_end(); eit++)
+                buf.push_back(moral_edge(vit->id(), eit->target(), true, eit->property()));
+
+            for (edge_iterator pit=vit->preds_begin(); pit!=vit->preds_end(); pit++)
+            {
+                edge_iterator pit2 = pit;
+                pit2++;
+                for (; pit2!=vit->preds_end(); pit2++)
+                {
+                    if (pit->target() == pit2->target()) continue;
+                    buf.push_back(moral_edge(pit->target(), pit2->target(), false, edge_property()));
+                }
+            }
+        }
+#ifdef SIM
+        SIM_END(true);
+#endif 
+    }
+    t2 = timer::get_usec();
+    tm.emit = t2-t1;
+
+    // phase 2: bucket by the smaller end point, sort and dedup
+    t1 = timer::get_usec();
+    vector<uint64_t> offsets(bound+1, 0);
+    #pragma omp parallel for num_threads(threadnum) schedule(dynamic,1)
+    for (unsigned t=0;t<threadnum;t++)
+        for (size_t i=0;i<buffers[t].size();i++)
+            __sync_fetch_and_add(&(offsets[buffers[t][i].src+1]), 1);
+    for (uint64_t v=0;v<bound;v++)
+        offsets[v+1] += offsets[v];
+
+    vector<moral_edge> bucketed(offsets[bound]);
+    vector<uint64_t> pos(offsets.begin(), offsets.end()-1);
+    #pragma omp parallel for num_threads(threadnum) schedule(dynamic,1)
+    for (unsigned t=0;t<threadnum;t++)
+    {
+        for (size_t i=0;i<buffers[t].size();i++)
+            bucketed[__sync_fetch_and_add(&(pos[buffers[t][i].src]), 1)] = buffers[t][i];
+        vector<moral_edge>().swap(buffers[t]);
+    }
+
+    vector<uint64_t> uniq(bound+1, 0);
+    #pragma omp parallel for num_threads(threadnum) schedule(dynamic,64)
+    for (uint64_t v=0;v<bound;v++)
+    {
+        vector<moral_edge>::iterator first = bucketed.begin()+offsets[v];
+        vector<moral_edge>::iterator last = bucketed.begin()+offsets[v+1];
+        if (first==last) continue;
+        std::sort(first, last, moral_edge_less());
+        uint64_t cnt = 1;
+        for (vector<moral_edge>::iterator it=first+1;it!=last;it++)
+            if (it->dest != (first+cnt-1)->dest) *(first+(cnt++)) = *it;
+        uniq[v+1] = cnt;
+    }
+    for (uint64_t v=0;v<bound;v++)
+        uniq[v+1] += uniq[v];
+
+    vector<pair<uint64_t,uint64_t> > edges(uniq[bound]);
+    vector<edge_property> props(uniq[bound]);
+    #pragma omp parallel for num_threads(threadnum) schedule(dynamic,64)
+    for (uint64_t v=0;v<bound;v++)
+    {
+        for (uint64_t k=0;k<uniq[v+1]-uniq[v];k++)
+        {
+            moral_edge & e = bucketed[offsets[v]+k];
+            edges[uniq[v]+k] = make_pair(e.src, e.dest);
+            props[uniq[v]+k] = e.prop;
+        }
+    }
+    vector<moral_edge>().swap(bucketed);
+    t2 = timer::get_usec();
+    tm.dedup = t2-t1;
+
+    // phase 3: bulk build
+    t1 = timer::get_usec();
+    for (size_t i=0;i<vids.size();i++)
+        ug.add_vertex(dag.find_vertex(vids[i])->property());
+    tm.edges = ug.build_from_edge_list(edges.begin(), edges.end(), props, threadnum);
+    t2 = timer::get_usec();
+    tm.build = t2-t1;
+}
+//==============================================================//
 
 void output(graph_t& ug, std::string path)
 {
@@ -160,6 +310,7 @@ int main(int argc, char * argv[])
 
     argument_parser arg;
     gBenchPerf_event perf;
+    arg_init(arg);
     if (arg.parse(argc,argv,perf,false)==false)
     {
         arg.help();
@@ -170,6 +321,8 @@ int main(int argc, char * argv[])
     arg.get_value("separator",separator);
 
     arg.get_value("threadnum",threadnum);
+    bool bulk;
+    arg.get_value("bulk",bulk);
 
     graph_t dag(openG::DIRECTED);
     double t1, t2;
@@ -201,6 +354,7 @@ int main(int argc, char * argv[])
      unsigned run_num = ceil(perf.get_event_cnt() /(double) DEFAULT_PERF_GRP_SZ);
     if (run_num==0) run_num = 1;
     double elapse_time = 0;
+    moral_timing tm;
     
     for (unsigned i=0;i<run_num;i++)
     {
@@ -210,7 +364,9 @@ int main(int argc, char * argv[])
         t1 = timer::get_usec();
         perf.open(i);
         perf.start(i);
-        if (threadnum==1)
+        if (bulk)
+            bulk_moralize(dag, *ug, tm);
+        else if (threadnum==1)
             moralize(dag, *ug);
         else
             parallel_moralize(dag, *ug);
@@ -220,8 +376,16 @@ int main(int argc, char * argv[])
     }
     cout<<"\nMoralization finish: \n";
 
+    if (bulk)
+        cout<<"== "<<tm.edges<<" moral edges\n";
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<elapse_time/run_num<<" sec\n";
+    if (bulk)
+    {
+        cout<<"== emit time: "<<tm.emit<<" sec\n";
+        cout<<"== sort and dedup time: "<<tm.dedup<<" sec\n";
+        cout<<"== build time: "<<tm.build<<" sec\n";
+    }
     perf.print();
 #endif
 
@@ -4,6 +4,8 @@
 // BC for unweighted graph
 // Brandes' algorithm 
 // Usage: ./bc.exe --dataset <dataset path>
+//                 --batch <sources per traversal, predecessor-free mode>
+//                 --samples <sampled sources, approximate BC>
 
 #include "common.h"
 #include "def.h"
@@ -23,6 +25,10 @@
 #endif
 
 #define MY_INFINITY 0xfff0
+// unvisited depth of the predecessor-free mode
+#define BC_INFINITY 0xffffffff
+// sources per traversal when only --samples is given
+#define BC_DEFAULT_BATCH 8
 
 using namespace std;
 
@@ -56,6 +62,8 @@ void arg_init(argument_parser & arg)
 {
     arg.add_arg("undirected","1","graph directness", false);
     arg.add_arg("maxiter","0","maximum loop iteration (0-unlimited, only set for simulation purpose)");
+    arg.add_arg("batch","0","sources per traversal of the predecessor-free implementation (0-original implementation)");
+    arg.add_arg("samples","0","number of sampled sources for approximate BC (0-all vertices)");
 }
 //==============================================================//
 
@@ -280,6 +288,237 @@ void parallel_bc(graph_t& g, unsigned threadnum, bool undirected,
     }
     return;
 }
+//==============================================================//
+// predecessor-free brandes. a traversal runs "batch" sources at once,
+// every vertex keeps one depth/sigma/delta slot per source. the vertices
+// are recorded per bfs level, so the back-propagation walks the levels
+// backwards and finds the predecessors of w again as the neighbors v
+// with depth[v]+1==depth[w]. only visited vertices are reset between
+// traversals. each thread adds to its own score buffer, the buffers are
+// reduced into the vertex property at the end.
+// out edges, indexed by vertex id. both passes walk every edge, the
+// graph's edge lists are copied once into this compact form
+class bc_csr
+{
+public:
+    vector<uint64_t> offsets;
+    vector<uint64_t> adj;
+};
+
+void build_csr(graph_t& g, bc_csr& csr)
+{
+    uint64_t bound = g.vid_bound();
+    csr.offsets.assign(bound+1, 0);
+    for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++) 
+        csr.offsets[vit->id()+1] = vit->edges_size();
+    for (uint64_t i=0;i<bound;i++)
+        csr.offsets[i+1] += csr.offsets[i];
+
+    csr.adj.resize(csr.offsets[bound]);
+    for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++) 
+    {
+        uint64_t pos = csr.offsets[vit->id()];
+        for (edge_iterator eit=vit->edges_begin(); eit!=vit->edges_end(); eit++)
+            csr.adj[pos++] = eit->target();
+    }
+}
+
+class brandes_state
+{
+public:
+    brandes_state(uint64_t bound, unsigned batch):
+        depth(bound*batch, BC_INFINITY),sigma(bound*batch, 0),delta(bound*batch, 0),
+        mark(bound, BC_INFINITY),score(bound, 0){}
+
+    vector<uint32_t> depth;
+    vector<double> sigma;       // shortest path counts
+    vector<double> delta;       // dependencies, see brandes_traverse()
+    vector<uint32_t> mark;      // last level a vertex was recorded at
+    vector<double> score;
+
+    vector<uint64_t> order;     // visited vertices, level by level
+    vector<size_t> level_start;
+    vector<unsigned> active;    // sources of the current vertex and level
+};
+
+void brandes_traverse(bc_csr& csr, const uint64_t * src, unsigned nsrc, unsigned batch,
+        brandes_state& st)
+{
+    st.order.clear();
+    st.level_start.clear();
+    st.level_start.push_back(0);
+    for (unsigned j=0;j<nsrc;j++)
+    {
+        st.depth[src[j]*batch+j] = 0;
+        st.sigma[src[j]*batch+j] = 1;
+        if (st.mark[src[j]] != 0)
+        {
+            st.mark[src[j]] = 0;
+            st.order.push_back(src[j]);
+        }
+    }
+
+    // forward bfs. a vertex is recorded once per level it is reached at
+    uint32_t level = 0;
+    while (st.level_start.back() < st.order.size())
+    {
+        size_t begin = st.level_start.back();
+        size_t end = st.order.size();
+        st.level_start.push_back(end);
+        for (size_t i=begin;i<end;i++)
+        {
+            uint64_t u = st.order[i];
+            // sources that reach u at this level
+            st.active.clear();
+            for (unsigned j=0;j<nsrc;j++)
+                if (st.depth[u*batch+j] == level) st.active.push_back(j);
+
+            for (uint64_t e=csr.offsets[u];e<csr.offsets[u+1];e++)
+            {
+                uint64_t w = csr.adj[e];
+                for (size_t k=0;k<st.active.size();k++)
+                {
+                    unsigned j = st.active[k];
+                    uint32_t & dw = st.depth[w*batch+j];
+                    if (dw == BC_INFINITY)
+                    {
+                        dw = level+1;
+                        if (st.mark[w] != level+1)
+                        {
+                            st.mark[w] = level+1;
+                            st.order.push_back(w);
+                        }
+                    }
+                    if (dw == level+1)
+                        st.sigma[w*batch+j] += st.sigma[u*batch+j];
+                }
+            }
+        }
+        level++;
+    }
+
+    // back-propagation, deepest level first. the dependencies of level+1
+    // are final once a level starts. a finished vertex w keeps
+    // (1+delta[w])/sigma[w] in its delta slot, so that a predecessor v
+    // only sums them up: delta[v] = sigma[v] * sum (1+delta[w])/sigma[w]
+    for (size_t l=st.level_start.size()-1;l>0;l--)
+    {
+        level = l-1;
+        for (size_t i=st.level_start[l-1];i<st.level_start[l];i++)
+        {
+            uint64_t v = st.order[i];
+            st.active.clear();
+            for (unsigned j=0;j<nsrc;j++)
+                if (st.depth[v*batch+j] == level) st.active.push_back(j);
+
+            for (uint64_t e=csr.offsets[v];e<csr.offsets[v+1];e++)
+            {
+                uint64_t w = csr.adj[e];
+                for (size_t k=0;k<st.active.size();k++)
+                {
+                    unsigned j = st.active[k];
+                    if (st.depth[w*batch+j] != level+1) continue;
+                    st.delta[v*batch+j] += st.delta[w*batch+j];
+                }
+            }
+            for (size_t k=0;k<st.active.size();k++)
+            {
+                unsigned j = st.active[k];
+                double d = st.sigma[v*batch+j] * st.delta[v*batch+j];
+                if (v != src[j])
+                    st.score[v] += d;
+                st.delta[v*batch+j] = (1 + d) / st.sigma[v*batch+j];
+            }
+        }
+    }
+
+    // reset the visited slots only
+    for (size_t i=0;i<st.order.size();i++)
+    {
+        uint64_t v = st.order[i];
+        st.mark[v] = BC_INFINITY;
+        for (unsigned j=0;j<batch;j++)
+        {
+            st.depth[v*batch+j] = BC_INFINITY;
+            st.sigma[v*batch+j] = 0;
+            st.delta[v*batch+j] = 0;
+        }
+    }
+}
+
+// sources are all vertices, or "samples" of them drawn without
+// replacement. sampled scores are scaled by vertices/samples
+void brandes_bc(graph_t& g, unsigned threadnum, bool undirected, 
+        size_t samples, unsigned batch,
+        gBenchPerf_multi & perf, int perf_group)
+{
+    uint64_t bound = g.vid_bound();
+    vector<uint64_t> sources;
+    for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++) 
+        sources.push_back(vit->id());
+    uint64_t vnum = sources.size();
+
+    double scale = 1.0;
+    if (samples != 0 && samples < vnum)
+    {
+        // partial fisher-yates shuffle with a fixed seed
+        unsigned seed = 27491095;
+        for (size_t i=0;i<samples;i++)
+        {
+            uint64_t r = ((uint64_t)rand_r(&seed) << 31) ^ (uint64_t)rand_r(&seed);
+            std::swap(sources[i], sources[i + r%(vnum-i)]);
+        }
+        sources.resize(samples);
+        scale = vnum / (double)samples;
+    }
+    if (maxiter != 0 && sources.size() > maxiter) 
+        sources.resize(maxiter);
+
+    bc_csr csr;
+    build_csr(g, csr);
+
+    double normalizer = (undirected)? 2.0 : 1.0;
+    size_t batch_num = (sources.size() + batch - 1) / batch;
+    vector<vector<double> > scores(threadnum);
+
+    #pragma omp parallel num_threads(threadnum)
+    {
+        unsigned tid = omp_get_thread_num();
+
+        perf.open(tid, perf_group);
+        perf.start(tid, perf_group);  
+#ifdef SIM
+        SIM_BEGIN(true);
+#endif
+        brandes_state st(bound, batch);
+
+        #pragma omp for schedule(dynamic,1)
+        for (size_t b=0;b<batch_num;b++)
+        {
+            size_t begin = b*batch;
+            unsigned nsrc = (unsigned)std::min<size_t>(batch, sources.size()-begin);
+            brandes_traverse(csr, &(sources[begin]), nsrc, batch, st);
+        }
+        scores[tid].swap(st.score);
+#ifdef SIM
+        SIM_END(true);
+#endif
+        perf.stop(tid, perf_group);
+    }
+
+    // single reduction of the per-thread buffers
+    #pragma omp parallel for num_threads(threadnum)
+    for (uint64_t i=0;i<bound;i++)
+    {
+        vertex_iterator vit = g.find_vertex(i);
+        if (vit == g.vertices_end()) continue;
+        double sum = 0;
+        for (unsigned t=0;t<threadnum;t++)
+            sum += scores[t][i];
+        vit->property().BC += sum * scale / normalizer;
+    }
+}
+
 //==============================================================//
 void output(graph_t& g)
 {
@@ -330,6 +569,11 @@ int main(int argc, char * argv[])
     bool undirected;
     arg.get_value("undirected",undirected);
 
+    size_t batch, samples;
+    arg.get_value("batch",batch);
+    arg.get_value("samples",samples);
+    if (samples!=0 && batch==0) batch = BC_DEFAULT_BATCH;
+
 
     graph_t graph;
     double t1, t2;
@@ -367,7 +611,12 @@ int main(int argc, char * argv[])
     if (maxiter != 0 && threadnum != 1) 
         cout<<"\nenable maxiter: "<<maxiter<<" per thread";
     //processing
-    cout<<"\ncomputing BC for all vertices...\n";
+    if (samples!=0)
+        cout<<"\ncomputing BC from "<<samples<<" sampled sources...\n";
+    else
+        cout<<"\ncomputing BC for all vertices...\n";
+    if (batch!=0)
+        cout<<"== "<<batch<<" sources per traversal\n";
  
     gBenchPerf_multi perf_multi(threadnum, perf);
     unsigned run_num = ceil(perf.get_event_cnt() / (double)DEFAULT_PERF_GRP_SZ);
@@ -378,7 +627,9 @@ int main(int argc, char * argv[])
     {
         t1 = timer::get_usec();
 
-        if (threadnum==1)
+        if (batch!=0)
+            brandes_bc(graph,threadnum,undirected,samples,batch,perf_multi,i);
+        else if (threadnum==1)
             bc(graph,undirected,perf,i);
         else
             parallel_bc(graph,threadnum,undirected,perf_multi,i);
@@ -391,7 +642,7 @@ int main(int argc, char * argv[])
 
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<elapse_time/run_num<<" sec\n";
-    if (threadnum == 1)
+    if (threadnum == 1 && batch == 0)
         perf.print();
     else
         perf_multi.print();
@@ -2,10 +2,13 @@
 //======== Connected Component =======//
 //
 // Usage: ./connectedcomponent.exe --dataset <dataset path>
+//                                  --unionfind
 
 #include "common.h"
 #include "def.h"
 #include "openG.h"
+#include "frontier.h"
+#include "union_find.h"
 #include "omp.h"
 #include <queue>
 
@@ -22,7 +25,7 @@
 
 using namespace std;
 
-uint16_t global_label=0;
+uint64_t global_label=0;
 size_t beginiter = 0;
 size_t enditer = 0;
 
@@ -32,7 +35,7 @@ public:
     vertex_property():level(MY_INFINITY),label(MY_INFINITY){}
 
     uint16_t level;
-    uint16_t label;
+    uint64_t label;
 };
 class edge_property
 {
@@ -48,25 +51,21 @@ typedef graph_t::vertex_iterator    vertex_iterator;
 typedef graph_t::edge_iterator      edge_iterator;
 
 //==============================================================//
-
-//==============================================================//
-inline unsigned vertex_distributor(size_t vid, unsigned threadnum)
+void arg_init(argument_parser & arg)
 {
-    return vid%threadnum;
+    arg.add_arg("unionfind","0","lock-free union-find with neighbor sampling instead of bfs", false);
 }
+//==============================================================//
 unsigned parallel_cc(graph_t& g, unsigned threadnum, gBenchPerf_multi & perf, int perf_group)
 {
     unsigned ret=0;
     // initializzation
-    vector<vector<uint64_t> > global_input_tasks(threadnum);
-    vector<vector<uint64_t> > global_output_tasks(threadnum*threadnum);
+    frontier front(g.vid_bound(), threadnum);
 
     uint64_t root = 0;
-    bool stop = false;
-    #pragma omp parallel num_threads(threadnum) shared(stop,global_input_tasks,global_output_tasks) 
+    #pragma omp parallel num_threads(threadnum) shared(front) 
     {
         unsigned tid = omp_get_thread_num();
-        vector<uint64_t> & input_tasks = global_input_tasks[tid];
         
         perf.open(tid, perf_group);
         perf.start(tid, perf_group); 
@@ -81,23 +80,22 @@ unsigned parallel_cc(graph_t& g, unsigned threadnum, gBenchPerf_multi & perf, in
 
                 rootvit->property().level = 0;
                 rootvit->property().label = global_label;
-                global_input_tasks[vertex_distributor(root, threadnum)].push_back(root);
-                stop = false;
+                front.push(0, root);
+                front.advance();
             }
             #pragma omp barrier
-            while(!stop)
+            while(!front.empty())
             {
-                #pragma omp barrier
-                // process local queue
-                stop = true;
+                // process local share of the frontier
 #ifdef SIM
                 SIM_BEGIN(iter==beginiter);
                 iter++;
 #endif              
-            
-                for (unsigned i=0;i<input_tasks.size();i++)
+                uint64_t begin, end;
+                front.range(tid, begin, end);
+                for (uint64_t i=begin;i<end;i++)
                 {
-                    uint64_t vid=input_tasks[i];
+                    uint64_t vid=front[i];
                     vertex_iterator vit = g.find_vertex(vid);
                     uint16_t curr_level = vit->property().level;
                     
@@ -110,14 +108,14 @@ unsigned parallel_cc(graph_t& g, unsigned threadnum, gBenchPerf_multi & perf, in
                     if (HMC_CAS_equal_16B(&(destvit->property().level),
                                 MY_INFINITY,curr_level+1) == MY_INFINITY)
                     {
-                        HMC_CAS_equal_16B(&(destvit->property().label), MY_INFINITY, global_label);
+                        destvit->property().label = global_label;
 #else
                         if (__sync_bool_compare_and_swap(&(destvit->property().level), 
                                     MY_INFINITY,curr_level+1))
                         {
                             destvit->property().label = global_label;
 #endif                            
-                            global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                            front.push(tid, dest_vid);
                         }
                     }
                 }
@@ -125,18 +123,10 @@ unsigned parallel_cc(graph_t& g, unsigned threadnum, gBenchPerf_multi & perf, in
                 SIM_END(iter==enditer);
 #endif
                 #pragma omp barrier
-                input_tasks.clear();
-                for (unsigned i=0;i<threadnum;i++)
-                {
-                    if (global_output_tasks[i*threadnum+tid].size()!=0)
-                    {
-                        stop = false;
-                        input_tasks.insert(input_tasks.end(),
-                                global_output_tasks[i*threadnum+tid].begin(),
-                                global_output_tasks[i*threadnum+tid].end());
-                        global_output_tasks[i*threadnum+tid].clear();
-                    }
-                }
+                #pragma omp master
+                front.plan();
+                #pragma omp barrier
+                front.build(tid);
                 #pragma omp barrier
 
             }
@@ -162,6 +152,87 @@ unsigned parallel_cc(graph_t& g, unsigned threadnum, gBenchPerf_multi & perf, in
 
     return ret;
 }
+// union-find over the out edges, and the in edges of directed graphs so
+// that the vertices of the largest component can be skipped. labels are
+// the smallest vertex id of each component
+size_t unionfind_cc(graph_t& g, unsigned threadnum, gBenchPerf_multi & perf, int perf_group)
+{
+    uint64_t bound = g.vid_bound();
+    vector<uint64_t> comp(bound);
+    uint64_t * c = &(comp[0]);
+    bool directed = (g.get_directness()==openG::DIRECTED);
+    uint64_t largest = 0;
+
+    #pragma omp parallel num_threads(threadnum)
+    {
+        unsigned tid = omp_get_thread_num();
+
+        perf.open(tid, perf_group);
+        perf.start(tid, perf_group); 
+#ifdef SIM
+        SIM_BEGIN(true);
+#endif 
+        #pragma omp for
+        for (uint64_t vid=0;vid<bound;vid++)
+            c[vid] = vid;
+
+        // link a sample of the edges: the r-th neighbor of every vertex
+        for (unsigned r=0;r<UF_NEIGHBOR_ROUNDS;r++)
+        {
+            #pragma omp for schedule(dynamic,64)
+            for (uint64_t vid=0;vid<bound;vid++)
+            {
+                vertex_iterator vit = g.find_vertex(vid);
+                if (vit == g.vertices_end() || vit->edges_size() <= r) continue;
+
+                edge_iterator eit = vit->edges_begin();
+                for (unsigned i=0;i<r;i++) eit++;
+                uf_link(c, vid, eit->target());
+            }
+            #pragma omp for
+            for (uint64_t vid=0;vid<bound;vid++)
+                uf_compress(c, vid);
+        }
+
+        #pragma omp single
+        largest = uf_sample_frequent(c, bound, UF_SAMPLES);
+
+        // the rest, except for the vertices already in the largest component
+        #pragma omp for schedule(dynamic,64)
+        for (uint64_t vid=0;vid<bound;vid++)
+        {
+            if (c[vid] == largest) continue;
+            vertex_iterator vit = g.find_vertex(vid);
+            if (vit == g.vertices_end()) continue;
+
+            edge_iterator eit = vit->edges_begin();
+            for (unsigned i=0;i<UF_NEIGHBOR_ROUNDS && eit!=vit->edges_end();i++) eit++;
+            for (;eit!=vit->edges_end();eit++)
+                uf_link(c, vid, eit->target());
+            if (directed)
+            {
+                for (eit=vit->preds_begin();eit!=vit->preds_end();eit++)
+                    uf_link(c, vid, eit->target());
+            }
+        }
+        #pragma omp for
+        for (uint64_t vid=0;vid<bound;vid++)
+            uf_compress(c, vid);
+#ifdef SIM
+        SIM_END(true);
+#endif  
+        perf.stop(tid, perf_group);
+    }
+
+    size_t ret=0;
+    for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++) 
+    {
+        vit->property().label = comp[vit->id()];
+        if (comp[vit->id()] == vit->id()) ret++;
+    }
+    return ret;
+}
+
 void bfs_component(graph_t& g, size_t root) 
 {
     std::queue<vertex_iterator> vertex_queue;
@@ -245,6 +316,7 @@ int main(int argc, char * argv[])
 
     argument_parser arg;
     gBenchPerf_event perf;
+    arg_init(arg);
     if (arg.parse(argc,argv,perf,false)==false)
     {
         arg.help();
@@ -256,6 +328,8 @@ int main(int argc, char * argv[])
 
     size_t threadnum;
     arg.get_value("threadnum",threadnum);
+    bool unionfind;
+    arg.get_value("unionfind",unionfind);
 #ifdef SIM
     arg.get_value("beginiter",beginiter);
     arg.get_value("enditer",enditer);
@@ -287,6 +361,7 @@ int main(int argc, char * argv[])
     cout<<"== time: "<<t2-t1<<" sec\n";
 #endif
 
+    if (unionfind) cout<<"union-find"<<endl;
     cout<<"\ncomputing connected component...\n";
     size_t component_num;
     
@@ -300,7 +375,9 @@ int main(int argc, char * argv[])
         global_label=0;
         t1 = timer::get_usec();
 
-        if (threadnum == 1)
+        if (unionfind)
+            component_num = unionfind_cc(graph, threadnum, perf_multi, i);
+        else if (threadnum == 1)
             component_num = connected_component(graph, perf, i);
         else
             component_num = parallel_cc(graph, threadnum, perf_multi, i);
@@ -312,7 +389,7 @@ int main(int argc, char * argv[])
     cout<<"== total component num: "<<component_num<<endl;
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<elapse_time/run_num<<" sec\n";
-    if (threadnum == 1)
+    if (threadnum == 1 && !unionfind)
         perf.print();
     else
         perf_multi.print();
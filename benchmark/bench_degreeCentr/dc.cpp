@@ -4,6 +4,7 @@
 #include "common.h"
 #include "def.h"
 #include "openG.h"
+#include "degree_stat.h"
 #include <math.h>
 #include <stack>
 #include "omp.h"
@@ -41,7 +42,10 @@ typedef graph_t::vertex_iterator    vertex_iterator;
 typedef graph_t::edge_iterator      edge_iterator;
 
 //==============================================================//
-
+void arg_init(argument_parser & arg)
+{
+    arg.add_arg("topk","0","k>0: in degrees from per-thread counts, degree histograms and the k vertices of largest in degree");
+}
 //==============================================================//
 void dc(graph_t& g, gBenchPerf_event & perf, int perf_group) 
 {
@@ -117,6 +121,70 @@ void parallel_dc(graph_t& g, unsigned threadnum, gBenchPerf_multi & perf, int pe
         perf.stop(tid, perf_group);
     }
 }
+// in degrees without a shared counter per edge. every thread counts the
+// targets of its own vertices into a private array, then each thread
+// sums the arrays over its range of vertices, where it also collects the
+// histograms and the hubs of that range
+void partial_dc(graph_t& g, unsigned threadnum, size_t k, 
+        gBenchPerf_multi & perf, int perf_group,
+        degree_stat& in_stat, degree_stat& out_stat, degree_topk& hubs)
+{
+    uint64_t vertex_cnt = g.num_vertices();
+    uint64_t chunk = (unsigned)ceil(vertex_cnt/(double)threadnum);
+    vector<vector<uint32_t> > partial(threadnum);
+    vector<degree_stat> in_local(threadnum), out_local(threadnum);
+    vector<degree_topk> hubs_local(threadnum);
+
+    #pragma omp parallel num_threads(threadnum)
+    {
+        unsigned tid = omp_get_thread_num();
+
+        perf.open(tid, perf_group);
+        perf.start(tid, perf_group); 
+
+        uint64_t start = tid*chunk;
+        uint64_t end = start + chunk;
+        if (end > vertex_cnt) end = vertex_cnt;
+        if (start > end) start = end;
+
+        // first touch by the owner
+        vector<uint32_t> & cnt = partial[tid];
+        cnt.assign(vertex_cnt, 0);
+        for (uint64_t vid=start;vid<end;vid++)
+        {
+            vertex_iterator vit = g.find_vertex(vid);
+            vit->property().outdegree = vit->edges_size();
+            for (edge_iterator eit=vit->edges_begin(); eit!=vit->edges_end(); eit++) 
+                cnt[eit->target()]++;
+        }
+        #pragma omp barrier
+
+        hubs_local[tid].init(k);
+        for (uint64_t vid=start;vid<end;vid++)
+        {
+            uint64_t indegree = 0;
+            for (unsigned t=0;t<threadnum;t++)
+                indegree += partial[t][vid];
+
+            vertex_iterator vit = g.find_vertex(vid);
+            vit->property().indegree = indegree;
+            in_local[tid].add(indegree);
+            out_local[tid].add(vit->edges_size());
+            hubs_local[tid].push(vid, indegree);
+        }
+        perf.stop(tid, perf_group);
+    }
+
+    in_stat.clear();
+    out_stat.clear();
+    hubs.init(k);
+    for (unsigned t=0;t<threadnum;t++)
+    {
+        in_stat.merge(in_local[t]);
+        out_stat.merge(out_local[t]);
+        hubs.merge(hubs_local[t]);
+    }
+}
 void degree_analyze(graph_t& g, 
                     uint64_t& indegree_max, uint64_t& indegree_min,
                     uint64_t& outdegree_max, uint64_t& outdegree_min)
@@ -153,6 +221,26 @@ void output(graph_t& g)
             <<" out-"<<vit->property().outdegree<<"\n";
     }
 }
+void print_histogram(string name, degree_stat& stat)
+{
+    cout<<"== "<<name<<" histogram:\n";
+    for (unsigned b=0;b<DEGREE_BUCKETS;b++)
+    {
+        if (stat.hist[b]==0) continue;
+        if (b==0)
+            cout<<"==   0: "<<stat.hist[b]<<"\n";
+        else
+            cout<<"==   ["<<(1ULL<<(b-1))<<", "<<(b<64 ? (1ULL<<b)-1 : stat.max)<<"]: "<<stat.hist[b]<<"\n";
+    }
+}
+void print_hubs(degree_topk& hubs)
+{
+    vector<degree_topk::entry_t> top;
+    hubs.sorted(top);
+    cout<<"== top "<<top.size()<<" hubs by inDegree:\n";
+    for (size_t i=0;i<top.size();i++)
+        cout<<"==   vertex "<<top[i].second<<": in-"<<top[i].first<<"\n";
+}
 void reset_graph(graph_t & g)
 {
     vertex_iterator vit;
@@ -171,6 +259,7 @@ int main(int argc, char * argv[])
 
     argument_parser arg;
     gBenchPerf_event perf;
+    arg_init(arg);
     if (arg.parse(argc,argv,perf,false)==false)
     {
         arg.help();
@@ -182,6 +271,8 @@ int main(int argc, char * argv[])
 
     size_t threadnum;
     arg.get_value("threadnum",threadnum);
+    size_t topk;
+    arg.get_value("topk",topk);
 #ifdef SIM
     arg.get_value("beginiter",beginiter);
     arg.get_value("enditer",enditer);
@@ -218,13 +309,17 @@ int main(int argc, char * argv[])
     unsigned run_num = ceil(perf.get_event_cnt() / (double)DEFAULT_PERF_GRP_SZ);
     if (run_num==0) run_num = 1;
     double elapse_time = 0;
+    degree_stat in_stat, out_stat;
+    degree_topk hubs;
     
     for (unsigned i=0;i<run_num;i++)
     {
         // Degree Centrality
         t1 = timer::get_usec();
         
-        if (threadnum==1)
+        if (topk>0)
+            partial_dc(graph, threadnum, topk, perf_multi, i, in_stat, out_stat, hubs);
+        else if (threadnum==1)
             dc(graph, perf, i);
         else
             parallel_dc(graph, threadnum, perf_multi, i);
@@ -235,15 +330,29 @@ int main(int argc, char * argv[])
     }
 
     uint64_t indegree_max, indegree_min, outdegree_max, outdegree_min;
-    degree_analyze(graph, indegree_max, indegree_min, outdegree_max, outdegree_min);
+    if (topk>0)
+    {
+        indegree_max = in_stat.max;
+        indegree_min = in_stat.min;
+        outdegree_max = out_stat.max;
+        outdegree_min = out_stat.min;
+    }
+    else
+        degree_analyze(graph, indegree_max, indegree_min, outdegree_max, outdegree_min);
 
     cout<<"DC finish: \n";
     cout<<"== inDegree[Max-"<<indegree_max<<" Min-"<<indegree_min
         <<"]  outDegree[Max-"<<outdegree_max<<" Min-"<<outdegree_min
         <<"]"<<endl;
+    if (topk>0)
+    {
+        print_histogram("inDegree", in_stat);
+        print_histogram("outDegree", out_stat);
+        print_hubs(hubs);
+    }
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<elapse_time/run_num<<" sec\n";
-    if (threadnum == 1)
+    if (threadnum == 1 && topk == 0)
         perf.print();
     else
         perf_multi.print();
@@ -18,6 +18,7 @@
 #include "common.h"
 #include "def.h"
 #include "openG.h"
+#include "omp.h"
 #ifdef SIM
 #include "SIM.h"
 #endif
@@ -109,6 +110,10 @@ void arg_init(argument_parser & arg)
     arg.add_arg("root","0","root/starting vertex");
     arg.add_arg("val","1","estimate value");
     arg.add_arg("iter","1000","iteration number");
+    arg.add_arg("chromatic","0","chromatic parallel sampler: vertices of one color of the moral graph are sampled concurrently", false);
+    arg.add_arg("chains","0","number of independent chains estimating the marginals of all vertices (0-single query)");
+    arg.add_arg("burnin","0","sweeps of each chain before samples are kept");
+    arg.add_arg("thin","1","keep every n-th sweep after the burn-in");
 }
 //==============================================================//
 
@@ -194,6 +199,276 @@ double gibbs_estimate(graph_t *g, set<vid_t> & evidence_nodes, uint64_t node, un
     return (double)cnt/(double)m;
 }
 
+//==============================================================//
+// chromatic gibbs sampling. the network is flattened into arrays: every
+// vertex has its cpt, the strides of its parents in it and, for every
+// child, the stride of the vertex in the child's cpt. changing a value
+// then moves a cpt index by value*stride instead of rebuilding a parent
+// value vector. two vertices whose variables share a cpt (parent and
+// child, or two parents of one child) are adjacent in the moral graph.
+// a greedy coloring of it gives independent sets that are sampled
+// concurrently, one color after another, so that a sweep samples every
+// vertex from its current markov blanket. the random number of a vertex
+// in a sweep is a hash of (seed, chain, sweep, vertex), results are the same
+// for any thread number.
+
+class flat_net
+{
+public:
+    vector<unsigned> num_values;
+    vector<unsigned> value;
+    vector<uint64_t> cpt_offset;
+    vector<double> cpt;
+
+    // parents of v: [parent_offset[v],parent_offset[v+1])
+    vector<uint64_t> parent_offset;
+    vector<uint32_t> parent;
+    vector<uint32_t> parent_stride;
+    // children of v and the stride of v in their cpt
+    vector<uint64_t> child_offset;
+    vector<uint32_t> child;
+    vector<uint32_t> child_stride;
+
+    // non-evidence vertices of each color
+    vector<vector<uint32_t> > colors;
+    unsigned max_values;
+
+    // cpt index of v for its own value i, with the parent values of the
+    // state "value" (net.value or the state of a chain)
+    uint64_t cpt_index(const unsigned * value, uint32_t v, unsigned i)
+    {
+        uint64_t idx = cpt_offset[v] + i;
+        for (uint64_t j=parent_offset[v];j<parent_offset[v+1];j++)
+            idx += value[parent[j]] * parent_stride[j];
+        return idx;
+    }
+};
+
+void build_flat_net(graph_t& g, vector<uint8_t>& evidence, flat_net& net)
+{
+    uint64_t n = g.vertex_num();
+    net.num_values.resize(n);
+    net.value.resize(n);
+    net.cpt_offset.resize(n+1, 0);
+    net.parent_offset.assign(n+1, 0);
+    net.child_offset.assign(n+1, 0);
+    net.max_values = 0;
+    for (uint64_t v=0;v<n;v++)
+    {
+        vit_t vit = g.find_vertex(v);
+        net.num_values[v] = vit->property().num_values;
+        net.value[v] = vit->property().value;
+        net.max_values = max(net.max_values, net.num_values[v]);
+        net.cpt_offset[v+1] = net.cpt_offset[v] + vit->property().cpt.size();
+        net.parent_offset[v+1] = net.parent_offset[v] + vit->preds_size();
+        net.child_offset[v+1] = net.child_offset[v] + vit->edges_size();
+    }
+    net.cpt.resize(net.cpt_offset[n]);
+    net.parent.resize(net.parent_offset[n]);
+    net.parent_stride.resize(net.parent_offset[n]);
+    net.child.resize(net.child_offset[n]);
+    net.child_stride.resize(net.child_offset[n]);
+
+    // same layout as index_gen()
+    vector<uint64_t> child_pos(net.child_offset.begin(), net.child_offset.end()-1);
+    for (uint64_t v=0;v<n;v++)
+    {
+        vit_t vit = g.find_vertex(v);
+        copy(vit->property().cpt.begin(), vit->property().cpt.end(), 
+                net.cpt.begin()+net.cpt_offset[v]);
+        uint64_t pos = net.parent_offset[v];
+        uint32_t stride = net.num_values[v];
+        for (peit_t peit=vit->preds_begin(); peit!=vit->preds_end(); peit++,pos++)
+        {
+            uint32_t p = peit->target();
+            net.parent[pos] = p;
+            net.parent_stride[pos] = stride;
+            net.child[child_pos[p]] = v;
+            net.child_stride[child_pos[p]] = stride;
+            child_pos[p]++;
+            stride *= net.num_values[p];
+        }
+    }
+
+    // greedy coloring of the moral graph in vertex order
+    vector<int> color(n, -1);
+    vector<uint64_t> mark;
+    for (uint64_t v=0;v<n;v++)
+    {
+        mark.clear();
+        for (uint64_t j=net.parent_offset[v];j<net.parent_offset[v+1];j++)
+            mark.push_back(net.parent[j]);
+        for (uint64_t j=net.child_offset[v];j<net.child_offset[v+1];j++)
+        {
+            uint32_t c = net.child[j];
+            mark.push_back(c);
+            for (uint64_t k=net.parent_offset[c];k<net.parent_offset[c+1];k++)
+                mark.push_back(net.parent[k]);
+        }
+        vector<bool> used(mark.size()+1, false);
+        for (size_t j=0;j<mark.size();j++)
+            if (color[mark[j]] >= 0 && color[mark[j]] <= (int)mark.size()) 
+                used[color[mark[j]]] = true;
+        int c = 0;
+        while (used[c]) c++;
+        color[v] = c;
+
+        if ((size_t)c >= net.colors.size()) net.colors.resize(c+1);
+        if (!evidence[v]) net.colors[c].push_back(v);
+    }
+}
+
+inline uint64_t splitmix64(uint64_t z)
+{
+    z *= 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// key of the random stream of one sweep of one chain. chain and sweep
+// are hashed in separate rounds, so no (chain, sweep) pair reaches the
+// counter values of another one
+inline uint64_t stream_key(uint64_t seed, uint64_t chain, uint64_t sweep)
+{
+    return splitmix64(splitmix64(seed + chain) + sweep);
+}
+
+// counter-based random number in [0,1) of vertex vid in a stream
+inline double counter_rand(uint64_t stream, uint64_t vid)
+{
+    return (splitmix64(stream + vid + 1) >> 11) * (1.0/9007199254740992.0);
+}
+
+// p(x_v=i|blanket) for all i, then draw the new value
+inline void chromatic_sample(flat_net& net, unsigned * value, uint32_t v, 
+        uint64_t stream, double * prob)
+{
+    unsigned num = net.num_values[v];
+    unsigned cur = value[v];
+    uint64_t base = net.cpt_index(value, v, 0);
+    for (unsigned i=0;i<num;i++)
+        prob[i] = net.cpt[base+i];
+
+    for (uint64_t j=net.child_offset[v];j<net.child_offset[v+1];j++)
+    {
+        uint32_t c = net.child[j];
+        uint64_t stride = net.child_stride[j];
+        // child index with x_v=0
+        uint64_t cbase = net.cpt_index(value, c, value[c]) - cur*stride;
+        for (unsigned i=0;i<num;i++)
+            prob[i] *= net.cpt[cbase + i*stride];
+    }
+
+    double norm = 0;
+    for (unsigned i=0;i<num;i++)
+        norm += prob[i];
+    double p = counter_rand(stream, v) * norm;
+    double acc = 0;
+    for (unsigned i=0;i<num;i++)
+    {
+        acc += prob[i];
+        if (p < acc)
+        {
+            value[v] = i;
+            break;
+        }
+    }
+}
+
+double chromatic_estimate(flat_net& net, uint64_t node, unsigned val, size_t m, 
+        unsigned threadnum)
+{
+    size_t cnt = 0;
+    #pragma omp parallel num_threads(threadnum)
+    {
+        vector<double> prob(net.max_values);
+        for (size_t s=0;s<m;s++)
+        {
+            uint64_t stream = stream_key(SEED, 0, s);
+            for (size_t c=0;c<net.colors.size();c++)
+            {
+                vector<uint32_t> & vertices = net.colors[c];
+                #pragma omp for schedule(static)
+                for (size_t i=0;i<vertices.size();i++)
+                    chromatic_sample(net, &(net.value[0]), vertices[i], stream, &(prob[0]));
+            }
+            // the next sweep waits for the check
+            #pragma omp single
+            if (net.value[node] == val) cnt++;
+        }
+    }
+    return (double)cnt/(double)m;
+}
+
+// multi-chain estimation. "chains" independent chains run on the
+// threads, each sweeps the colors one after another on its own state.
+// a chain starts from the loaded values with the non-evidence values
+// redrawn, and has its own random stream. after "burnin" sweeps, every
+// "thin"-th sweep adds the value of every vertex to the chain's
+// histogram. the histograms of all chains give the marginals of all
+// vertices in one run. hist[hist_offset[v]+i] counts x_v=i
+size_t multichain_marginals(flat_net& net, size_t m, unsigned chains, 
+        size_t burnin, size_t thin, unsigned threadnum, 
+        vector<uint64_t>& hist_offset, vector<double>& marginal)
+{
+    uint64_t n = net.num_values.size();
+    hist_offset.assign(n+1, 0);
+    for (uint64_t v=0;v<n;v++)
+        hist_offset[v+1] = hist_offset[v] + net.num_values[v];
+    vector<uint64_t> hist(hist_offset[n], 0);
+    if (thin==0) thin = 1;
+    size_t kept = 0;
+
+    #pragma omp parallel num_threads(threadnum) reduction(+:kept)
+    {
+        vector<double> prob(net.max_values);
+        vector<uint64_t> local(hist_offset[n], 0);
+        vector<unsigned> value;
+
+        #pragma omp for schedule(dynamic,1)
+        for (unsigned k=0;k<chains;k++)
+        {
+            value = net.value;
+            if (k>0)
+            {
+                // the initial draw has its own sweep id past the last sweep
+                uint64_t stream = stream_key(SEED, k, ~0ULL);
+                for (size_t c=0;c<net.colors.size();c++)
+                    for (size_t i=0;i<net.colors[c].size();i++)
+                    {
+                        uint32_t v = net.colors[c][i];
+                        value[v] = counter_rand(stream, v) * net.num_values[v];
+                    }
+            }
+
+            for (size_t s=0;s<m;s++)
+            {
+                uint64_t stream = stream_key(SEED, k, s);
+                for (size_t c=0;c<net.colors.size();c++)
+                {
+                    vector<uint32_t> & vertices = net.colors[c];
+                    for (size_t i=0;i<vertices.size();i++)
+                        chromatic_sample(net, &(value[0]), vertices[i], stream, &(prob[0]));
+                }
+                if (s < burnin || (s-burnin)%thin != 0) continue;
+                for (uint64_t v=0;v<n;v++)
+                    local[hist_offset[v]+value[v]]++;
+                kept++;
+            }
+        }
+
+        #pragma omp critical
+        for (size_t i=0;i<local.size();i++)
+            hist[i] += local[i];
+    }
+
+    marginal.assign(hist.size(), 0);
+    for (size_t i=0;i<hist.size() && kept>0;i++)
+        marginal[i] = hist[i] / (double)kept;
+    return kept;
+}
+
 void dsc_parser(
     string fname,
     map<string, unsigned>&  node2vid,
@@ -433,14 +708,25 @@ int main(int argc, char* argv[])
     string path;
     arg.get_value("dataset",path);
 
-    size_t root,value,iteration;
+    size_t root,value,iteration,threadnum;
     arg.get_value("root",root);
     arg.get_value("val",value);
     arg.get_value("iter",iteration);
+    arg.get_value("threadnum",threadnum);
+    bool chromatic;
+    arg.get_value("chromatic",chromatic);
+    size_t chains,burnin,thin;
+    arg.get_value("chains",chains);
+    arg.get_value("burnin",burnin);
+    arg.get_value("thin",thin);
 
     set<vid_t> evidence_nodes;
     vector<string> vid2node;
     double result;
+    vector<uint8_t> evidence;
+    vector<uint64_t> hist_offset;
+    vector<double> marginal;
+    size_t kept = 0;
 
     unsigned run_num = ceil(perf.get_event_cnt() /(double) DEFAULT_PERF_GRP_SZ);
     if (run_num==0) run_num = 1;
@@ -474,13 +760,32 @@ int main(int argc, char* argv[])
         for (unsigned i=0; i<evidnum; i++)
             evidence_nodes.insert(rand()%vertex_num);
 
+        flat_net net;
+        if (chromatic || chains>0)
+        {
+            evidence.assign(vertex_num, 0);
+            for (set<vid_t>::iterator iter=evidence_nodes.begin(); iter!=evidence_nodes.end(); iter++)
+                evidence[*iter] = 1;
+            build_flat_net(g, evidence, net);
+            cout<<"== "<<net.colors.size()<<" colors of the moral graph\n";
+        }
+
         t1 = timer::get_usec();
         perf.open(i);
         perf.start(i);
 #ifdef SIM
     SIM_BEGIN(true);
 #endif
-        result = gibbs_estimate(&g, evidence_nodes, root, value, iteration);
+        if (chains>0)
+        {
+            kept = multichain_marginals(net, iteration, chains, burnin, thin, 
+                    threadnum, hist_offset, marginal);
+            result = (value < net.num_values[root]) ? marginal[hist_offset[root]+value] : 0;
+        }
+        else if (chromatic)
+            result = chromatic_estimate(net, root, value, iteration, threadnum);
+        else
+            result = gibbs_estimate(&g, evidence_nodes, root, value, iteration);
 #ifdef SIM
     SIM_END(true);
 #endif
@@ -491,6 +796,10 @@ int main(int argc, char* argv[])
 
 #ifndef ENABLE_VERIFY
         cout<<"== time: "<<t2-t1<<" sec\n";
+        // one sample per non-evidence vertex and sweep
+        size_t samples = (vertex_num - evidence_nodes.size()) * iteration;
+        if (chains>0) samples *= chains;
+        cout<<"== samples/s: "<<samples/(t2-t1)<<"\n";
 #endif
     }
     // perform Gibbs sampling for 2000 steps
@@ -503,6 +812,19 @@ int main(int argc, char* argv[])
         cout<<vid2node[*iter];
     }
     cout <<") = "<< result << endl;
+
+    if (chains>0)
+    {
+        cout<<"\nMarginals by "<<chains<<" chains, "<<kept<<" kept sweeps:\n";
+        for (size_t v=0;v<vid2node.size();v++)
+        {
+            if (evidence[v]) continue;
+            cout<<"== "<<vid2node[v]<<":";
+            for (uint64_t j=hist_offset[v];j<hist_offset[v+1];j++)
+                cout<<" "<<marginal[j];
+            cout<<"\n";
+        }
+    }
 #ifndef ENABLE_VERIFY
     perf.print();
 #endif
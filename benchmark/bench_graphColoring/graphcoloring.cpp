@@ -6,6 +6,7 @@
 #include "common.h"
 #include "def.h"
 #include "openG.h"
+#include "frontier.h"
 #include <queue>
 #include "omp.h"
 
@@ -47,53 +48,44 @@ typedef graph_t::edge_iterator      edge_iterator;
 //==============================================================//
 void arg_init(argument_parser & arg)
 {
+    arg.add_arg("mode","rounds","rounds: one color per round, speculative: greedy with conflict repair, ldf: jones-plassmann with largest-degree-first priority");
 }
 //==============================================================//
-inline unsigned vertex_distributor(uint64_t vid, unsigned threadnum)
-{
-    return vid%threadnum;
-}
-
-void init_graphcoloring(graph_t& g, unsigned threadnum,
-        vector<vector<uint64_t> >& global_input_tasks)
+void init_graphcoloring(graph_t& g, unsigned threadnum, frontier& front)
 {
     srand(SEED);
-    global_input_tasks.resize(threadnum);
+    front.init(g.vid_bound(), threadnum);
     for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++) 
     {
         vit->property().rand = rand();
-        global_input_tasks[vertex_distributor(vit->id(), threadnum)].push_back(vit->id());
+        front.push(0, vit->id());
     }
+    front.advance();
 }
-void parallel_graphcoloring(graph_t& g, unsigned threadnum,
-        vector<vector<uint64_t> >& global_input_tasks,
+void parallel_graphcoloring(graph_t& g, unsigned threadnum, frontier& front,
         gBenchPerf_multi & perf, int perf_group)
 {
-    vector<vector<uint64_t> > global_output_tasks(threadnum*threadnum);
-    bool stop = false;
-    #pragma omp parallel num_threads(threadnum) shared(stop,global_input_tasks,global_output_tasks) 
+    #pragma omp parallel num_threads(threadnum) shared(front) 
     {
         unsigned tid = omp_get_thread_num();
-        vector<uint64_t> & input_tasks = global_input_tasks[tid];
         uint16_t color = 0; 
         perf.open(tid, perf_group);
         perf.start(tid, perf_group);  
 #ifdef SIM
         unsigned iter = 0;
 #endif    
-        while(!stop)
+        while(!front.empty())
         {
-            #pragma omp barrier
-            // process local queue
-            stop = true;
-            
+            // process local share of the frontier
 #ifdef SIM
             SIM_BEGIN(iter==beginiter);
             iter++;
 #endif       
-            for (unsigned i=0;i<input_tasks.size();i++)
+            uint64_t begin, end;
+            front.range(tid, begin, end);
+            for (uint64_t i=begin;i<end;i++)
             {
-                uint64_t vid=input_tasks[i];
+                uint64_t vid=front[i];
                 vertex_iterator vit = g.find_vertex(vid);
                 uint16_t local_rand = vit->property().rand;
                 bool found_larger = false;
@@ -130,35 +122,207 @@ void parallel_graphcoloring(graph_t& g, unsigned threadnum,
                 if (found_larger == false)
                     vit->property().color = color;
                 else
-                    global_output_tasks[vertex_distributor(vid,threadnum)+tid*threadnum].push_back(vid);
+                    front.push(tid, vid);
             }
 #ifdef SIM
             SIM_END(iter==enditer);
 #endif
             #pragma omp barrier
-            input_tasks.clear();
-            for (unsigned i=0;i<threadnum;i++)
+            #pragma omp master
+            front.plan();
+            #pragma omp barrier
+            front.build(tid);
+            color++;
+            #pragma omp barrier
+
+        }
+#ifdef SIM
+        SIM_END(enditer==0);
+#endif
+        perf.stop(tid, perf_group);
+    }
+
+}
+//==============================================================//
+// speculative and priority based coloring. both give a vertex the
+// smallest color that none of its neighbors has. edges are taken as
+// symmetric, as in the rounds mode.
+
+// smallest color not used by a neighbor of vit. mark is a per thread
+// scratch array, color c is taken if mark[c]==stamp. a vertex of degree
+// d always finds a color <= d, larger neighbor colors are not marked
+inline uint16_t smallest_free_color(graph_t& g, vertex_iterator vit,
+        vector<uint64_t>& mark, uint64_t stamp)
+{
+    uint64_t degree = vit->edges_size();
+    if (mark.size() < degree+1) mark.resize(degree+1, 0);
+    for (edge_iterator eit=vit->edges_begin();eit!=vit->edges_end();eit++)
+    {
+        uint16_t c = g.find_vertex(eit->target())->property().color;
+        if (c <= degree) mark[c] = stamp;
+    }
+    uint16_t c = 0;
+    while (mark[c]==stamp) c++;
+    return c;
+}
+
+// gebremedhin-manne. every vertex of the worklist is colored greedily
+// from the colors its neighbors have at that moment. neighbors colored
+// concurrently may pick the same color, the one with the larger id is
+// then queued for the next round
+void speculative_graphcoloring(graph_t& g, unsigned threadnum, frontier& front,
+        size_t& rounds, gBenchPerf_multi & perf, int perf_group)
+{
+    rounds = 0;
+    #pragma omp parallel num_threads(threadnum) shared(front) 
+    {
+        unsigned tid = omp_get_thread_num();
+        vector<uint64_t> mark;
+        uint64_t stamp = 0;
+        perf.open(tid, perf_group);
+        perf.start(tid, perf_group);  
+#ifdef SIM
+        unsigned iter = 0;
+#endif    
+        while(!front.empty())
+        {
+#ifdef SIM
+            SIM_BEGIN(iter==beginiter);
+            iter++;
+#endif       
+            uint64_t begin, end;
+            front.range(tid, begin, end);
+            for (uint64_t i=begin;i<end;i++)
             {
-                if (global_output_tasks[i*threadnum+tid].size()!=0)
+                vertex_iterator vit = g.find_vertex(front[i]);
+                vit->property().color = smallest_free_color(g, vit, mark, ++stamp);
+            }
+            #pragma omp barrier
+
+            // conflict detection
+            for (uint64_t i=begin;i<end;i++)
+            {
+                uint64_t vid = front[i];
+                vertex_iterator vit = g.find_vertex(vid);
+                uint16_t color = vit->property().color;
+                for (edge_iterator eit=vit->edges_begin();eit!=vit->edges_end();eit++)
                 {
-                    stop = false;
-                    input_tasks.insert(input_tasks.end(),
-                            global_output_tasks[i*threadnum+tid].begin(),
-                            global_output_tasks[i*threadnum+tid].end());
-                    global_output_tasks[i*threadnum+tid].clear();
+                    uint64_t dest_vid = eit->target();
+                    if (dest_vid < vid && 
+                        g.find_vertex(dest_vid)->property().color == color)
+                    {
+                        front.push(tid, vid);
+                        break;
+                    }
                 }
             }
-            color++;
+#ifdef SIM
+            SIM_END(iter==enditer);
+#endif
+            #pragma omp barrier
+            #pragma omp master
+            {
+                front.plan();
+                rounds++;
+            }
+            #pragma omp barrier
+            front.build(tid);
             #pragma omp barrier
-
         }
 #ifdef SIM
         SIM_END(enditer==0);
 #endif
         perf.stop(tid, perf_group);
     }
+}
 
+// largest-degree-first priority, ties by rand and then by lower id
+inline bool higher_priority(vertex_iterator u, vertex_iterator v)
+{
+    if (u->edges_size() != v->edges_size()) 
+        return u->edges_size() > v->edges_size();
+    if (u->property().rand != v->property().rand)
+        return u->property().rand > v->property().rand;
+    return u->id() < v->id();
+}
+
+// jones-plassmann. pending[v] counts the uncolored neighbors of higher
+// priority, a vertex joins the worklist once they are all colored. a
+// round colors the whole worklist, so the rounds are the longest chain
+// of decreasing priority instead of the number of colors
+void ldf_graphcoloring(graph_t& g, unsigned threadnum, frontier& front,
+        size_t& rounds, gBenchPerf_multi & perf, int perf_group)
+{
+    vector<uint32_t> pending(g.vid_bound(), 0);
+    rounds = 0;
+    #pragma omp parallel num_threads(threadnum) shared(front) 
+    {
+        unsigned tid = omp_get_thread_num();
+        vector<uint64_t> mark;
+        uint64_t stamp = 0;
+        perf.open(tid, perf_group);
+        perf.start(tid, perf_group);  
+
+        // front holds all vertices, keep the ones without pending neighbors
+        uint64_t begin, end;
+        front.range(tid, begin, end);
+        for (uint64_t i=begin;i<end;i++)
+        {
+            vertex_iterator vit = g.find_vertex(front[i]);
+            uint32_t cnt = 0;
+            for (edge_iterator eit=vit->edges_begin();eit!=vit->edges_end();eit++)
+                if (higher_priority(g.find_vertex(eit->target()), vit)) cnt++;
+            pending[vit->id()] = cnt;
+            if (cnt==0) front.push(tid, vit->id());
+        }
+        #pragma omp barrier
+        #pragma omp master
+        front.plan();
+        #pragma omp barrier
+        front.build(tid);
+        #pragma omp barrier
+#ifdef SIM
+        unsigned iter = 0;
+#endif    
+        while(!front.empty())
+        {
+#ifdef SIM
+            SIM_BEGIN(iter==beginiter);
+            iter++;
+#endif       
+            front.range(tid, begin, end);
+            for (uint64_t i=begin;i<end;i++)
+            {
+                vertex_iterator vit = g.find_vertex(front[i]);
+                vit->property().color = smallest_free_color(g, vit, mark, ++stamp);
+                for (edge_iterator eit=vit->edges_begin();eit!=vit->edges_end();eit++)
+                {
+                    vertex_iterator destvit = g.find_vertex(eit->target());
+                    if (higher_priority(vit, destvit) &&
+                        __sync_sub_and_fetch(&(pending[destvit->id()]), 1) == 0)
+                        front.push(tid, destvit->id());
+                }
+            }
+#ifdef SIM
+            SIM_END(iter==enditer);
+#endif
+            #pragma omp barrier
+            #pragma omp master
+            {
+                front.plan();
+                rounds++;
+            }
+            #pragma omp barrier
+            front.build(tid);
+            #pragma omp barrier
+        }
+#ifdef SIM
+        SIM_END(enditer==0);
+#endif
+        perf.stop(tid, perf_group);
+    }
 }
+
 //==============================================================//
 void output(graph_t& g)
 {
@@ -202,6 +366,13 @@ int main(int argc, char * argv[])
     size_t k,threadnum;
     arg.get_value("kcore",k);
     arg.get_value("threadnum",threadnum);
+    string mode;
+    arg.get_value("mode",mode);
+    if (mode!="rounds" && mode!="speculative" && mode!="ldf")
+    {
+        arg.help();
+        return -1;
+    }
 #ifdef SIM
     arg.get_value("beginiter",beginiter);
     arg.get_value("enditer",enditer);
@@ -240,20 +411,33 @@ int main(int argc, char * argv[])
     unsigned run_num = ceil(perf.get_event_cnt() /(double) DEFAULT_PERF_GRP_SZ);
     if (run_num==0) run_num = 1;
     double elapse_time = 0;
+    size_t rounds = 0;
     
     for (unsigned i=0;i<run_num;i++)
     {
-        vector<vector<uint64_t> > global_input_tasks(threadnum);
+        frontier front;
 
-        init_graphcoloring(graph,threadnum,global_input_tasks);
+        init_graphcoloring(graph,threadnum,front);
 
         t1 = timer::get_usec();
 
-        parallel_graphcoloring(graph,threadnum,global_input_tasks,perf_multi,i);
+        if (mode=="speculative")
+            speculative_graphcoloring(graph,threadnum,front,rounds,perf_multi,i);
+        else if (mode=="ldf")
+            ldf_graphcoloring(graph,threadnum,front,rounds,perf_multi,i);
+        else
+            parallel_graphcoloring(graph,threadnum,front,perf_multi,i);
         t2 = timer::get_usec();
         elapse_time += t2-t1;
         if ((i+1)<run_num) reset_graph(graph);
     }
+    if (mode!="rounds")
+    {
+        uint16_t colors = 0;
+        for (vertex_iterator vit=graph.vertices_begin(); vit!=graph.vertices_end(); vit++)
+            colors = std::max<uint16_t>(colors, vit->property().color+1);
+        cout<<"== colors: "<<colors<<"  rounds: "<<rounds<<"\n";
+    }
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<elapse_time/run_num<<" sec\n";
     if (threadnum == 1)
@@ -2,6 +2,7 @@
 //======= RandomGraph Construction =======//
 //
 // Usage: ./randomgraph --vertex <vertex #> --edge <edge #>
+//                      --mode <incremental|bulk|compare>
 
 #include "common.h"
 #include "def.h"
@@ -42,6 +43,7 @@ void arg_init(argument_parser & arg)
 {
     arg.add_arg("vertex","100","vertex #");
     arg.add_arg("edge","1000","edge #");
+    arg.add_arg("mode","incremental","incremental: add_edge per edge, bulk: build_from_edge_list, compare: edges/s of both");
 }
 //==============================================================//
 
@@ -88,6 +90,7 @@ void parallel_randomgraph_construction(graph_t &g, size_t vertex_num, size_t edg
         vertex_iterator vit = g.add_vertex();
         vit->set_property(vertex_property(i));
     }
+    g.set_concurrent(true);
     uint64_t chunk = (unsigned)ceil(edge_num/(double)threadnum);
     #pragma omp parallel num_threads(threadnum)
     {
@@ -102,16 +105,86 @@ void parallel_randomgraph_construction(graph_t &g, size_t vertex_num, size_t edg
         for (size_t i=start;i<end;i++) 
         {
             edge_iterator eit;
-            g.add_edge(edges[i].first, edges[i].second, eit);
-#ifndef SIM
-            eit->set_property(edge_property(i));
-#endif
+            g.add_edge(edges[i].first, edges[i].second, edge_property(i), eit);
         }
 #ifdef SIM
         SIM_END(true);
 #endif 
 
     }
+    g.set_concurrent(false);
+}
+
+void generate_edges(vector<pair<uint64_t,uint64_t> > & edges, size_t vertex_num, size_t edge_num)
+{
+    edges.clear();
+    for (size_t i=0;i<edge_num;i++) 
+    {
+        edges.push_back(make_pair(rand()%vertex_num, rand()%vertex_num));
+    }
+}
+
+void add_vertices(graph_t &g, size_t vertex_num)
+{
+    for (size_t i=0;i<vertex_num;i++) 
+    {
+        vertex_iterator vit = g.add_vertex();
+        vit->set_property(vertex_property(i));
+    }
+}
+
+void bulk_edges(graph_t &g, vector<pair<uint64_t,uint64_t> > & edges)
+{
+    vector<edge_property> props(edges.size());
+    for (size_t i=0;i<edges.size();i++)
+        props[i] = edge_property(i);
+
+    g.build_from_edge_list(edges.begin(), edges.end(), props, threadnum);
+}
+
+void bulk_randomgraph_construction(graph_t &g, size_t vertex_num, size_t edge_num, gBenchPerf_event & perf, int perf_group)
+{
+    vector<pair<uint64_t,uint64_t> > edges;
+    generate_edges(edges, vertex_num, edge_num);
+
+    perf.open(perf_group);
+    perf.start(perf_group);
+    add_vertices(g, vertex_num);
+    bulk_edges(g, edges);
+    perf.stop(perf_group);
+}
+
+// edge insertion rate of add_edge and build_from_edge_list
+void compare_construction(size_t vertex_num, size_t edge_num)
+{
+    double t1, t2;
+    vector<pair<uint64_t,uint64_t> > edges;
+    srand(SEED);
+    generate_edges(edges, vertex_num, edge_num);
+
+    graph_t g1;
+    add_vertices(g1, vertex_num);
+    t1 = timer::get_usec();
+    for (size_t i=0;i<edges.size();i++) 
+    {
+        edge_iterator eit;
+        g1.add_edge(edges[i].first, edges[i].second, eit);
+        eit->set_property(edge_property(i));
+    }
+    t2 = timer::get_usec();
+    double incr_time = t2-t1;
+
+    graph_t g2;
+    add_vertices(g2, vertex_num);
+    t1 = timer::get_usec();
+    bulk_edges(g2, edges);
+    t2 = timer::get_usec();
+    double bulk_time = t2-t1;
+
+    cout<<"\nedge insertion ("<<threadnum<<" threads for bulk): \n";
+    cout<<"== incremental: "<<edge_num/incr_time<<" edges/sec  time: "<<incr_time<<" sec\n";
+    cout<<"== bulk:        "<<edge_num/bulk_time<<" edges/sec  time: "<<bulk_time<<" sec\n";
+    cout<<"== speedup:     "<<incr_time/bulk_time<<"\n";
 }
 
 //==============================================================//
@@ -146,6 +219,13 @@ int main(int argc, char * argv[])
     arg.get_value("edge",edge_num);
     
     arg.get_value("threadnum",threadnum);
+    string mode;
+    arg.get_value("mode",mode);
+    if (mode!="incremental" && mode!="bulk" && mode!="compare")
+    {
+        arg.help();
+        return -1;
+    }
     
     double t1, t2;
     
@@ -161,7 +241,9 @@ int main(int argc, char * argv[])
 
         t1 = timer::get_usec();
         graph_t g;
-        if (threadnum==1)
+        if (mode=="bulk")
+            bulk_randomgraph_construction(g, vertex_num, edge_num, perf, i);
+        else if (threadnum==1)
             randomgraph_construction(g, vertex_num, edge_num, perf, i);
         else
             parallel_randomgraph_construction(g, vertex_num, edge_num);
@@ -176,6 +258,8 @@ int main(int argc, char * argv[])
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<elapse_time/run_num<<" sec\n";
     perf.print();
+    if (mode=="compare")
+        compare_construction(vertex_num, edge_num);
 #endif
 
     cout<<"==================================================================\n";
@@ -2,6 +2,7 @@
 //======= RandomGraph Construction =======//
 //
 // Usage: ./graphupdate --delete <vertex #> --dataset <dataset path>
+//                      --mode <single|batch|compare>
 
 #include "common.h"
 #include "def.h"
@@ -41,6 +42,7 @@ typedef graph_t::edge_iterator      edge_iterator;
 void arg_init(argument_parser & arg)
 {
     arg.add_arg("delete","10","delete vertex #");
+    arg.add_arg("mode","single","single: delete_vertex per vertex, batch: delete_vertices, compare: vertices/s of both");
 }
 //==============================================================//
 
@@ -76,6 +78,7 @@ size_t input(string path, size_t num, vector<uint64_t> & q)
 
 void graph_update(graph_t &g, vector<uint64_t>& IDs)
 {
+    g.set_concurrent(threadnum > 1);
     unsigned chunk = (unsigned)ceil(IDs.size()/(double)threadnum);
     #pragma omp parallel num_threads(threadnum)
     {
@@ -97,6 +100,60 @@ void graph_update(graph_t &g, vector<uint64_t>& IDs)
         SIM_END(true);
 #endif 
     }
+    g.set_concurrent(false);
+}
+
+void graph_update_batch(graph_t &g, vector<uint64_t>& IDs)
+{
+#ifdef SIM
+    SIM_BEGIN(true);
+#endif 
+    g.delete_vertices(IDs, threadnum);
+#ifdef SIM
+    SIM_END(true);
+#endif 
+}
+
+bool load_graph(graph_t &g, string path, string separator)
+{
+    string vfile = path + "/vertex.csv";
+    string efile = path + "/edge.csv";
+
+#ifndef EDGES_ONLY
+    if (g.load_csv_vertices(vfile, true, separator, 0) == -1)
+        return false;
+    if (g.load_csv_edges(efile, true, separator, 0, 1) == -1) 
+        return false;
+#else
+    if (g.load_csv_edges(path, true, separator, 0, 1) == -1)
+        return false;
+#endif
+    return true;
+}
+
+// deletion rate of delete_vertex and delete_vertices
+void compare_update(string path, string separator, vector<uint64_t>& IDs)
+{
+    double t1, t2;
+
+    graph_t g1;
+    if (!load_graph(g1, path, separator)) return;
+    t1 = timer::get_usec();
+    graph_update(g1, IDs);
+    t2 = timer::get_usec();
+    double single_time = t2-t1;
+
+    graph_t g2;
+    if (!load_graph(g2, path, separator)) return;
+    t1 = timer::get_usec();
+    graph_update_batch(g2, IDs);
+    t2 = timer::get_usec();
+    double batch_time = t2-t1;
+
+    cout<<"\nvertex deletion ("<<threadnum<<" threads): \n";
+    cout<<"== single: "<<IDs.size()/single_time<<" vertices/sec  time: "<<single_time<<" sec\n";
+    cout<<"== batch:  "<<IDs.size()/batch_time<<" vertices/sec  time: "<<batch_time<<" sec\n";
+    cout<<"== speedup: "<<single_time/batch_time<<"\n";
 }
 
 //==============================================================//
@@ -131,6 +188,13 @@ int main(int argc, char * argv[])
     arg.get_value("threadnum",threadnum);
     size_t delete_num;
     arg.get_value("delete",delete_num);
+    string mode;
+    arg.get_value("mode",mode);
+    if (mode!="single" && mode!="batch" && mode!="compare")
+    {
+        arg.help();
+        return -1;
+    }
 
     unsigned run_num = ceil(perf.get_event_cnt() / (double)DEFAULT_PERF_GRP_SZ);
     if (run_num==0) run_num = 1;
@@ -146,18 +210,8 @@ int main(int argc, char * argv[])
         graph_t g;
         
         t1 = timer::get_usec();
-        string vfile = path + "/vertex.csv";
-        string efile = path + "/edge.csv";
-
-#ifndef EDGES_ONLY
-        if (g.load_csv_vertices(vfile, true, separator, 0) == -1)
-            return -1;
-        if (g.load_csv_edges(efile, true, separator, 0, 1) == -1) 
+        if (!load_graph(g, path, separator))
             return -1;
-#else
-        if (g.load_csv_edges(path, true, separator, 0, 1) == -1)
-            return -1;
-#endif
         t2 = timer::get_usec();
 
         if (i==0)
@@ -178,7 +232,10 @@ int main(int argc, char * argv[])
         perf.open(i);
         perf.start(i);
 
-        graph_update(g, IDs);
+        if (mode=="batch")
+            graph_update_batch(g, IDs);
+        else
+            graph_update(g, IDs);
 
         perf.stop(i);
         t2 = timer::get_usec();
@@ -189,6 +246,9 @@ int main(int argc, char * argv[])
         }
 #ifndef ENABLE_VERIFY
         cout<<"== time: "<<t2-t1<<" sec\n";
+        cout<<"== throughput: "<<IDs.size()/(t2-t1)<<" vertices/sec\n";
+        if (mode=="compare" && i==(run_num-1))
+            compare_update(path, separator, IDs);
 #else
         (void)t1;
         (void)t2;
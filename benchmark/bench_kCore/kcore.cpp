@@ -2,10 +2,12 @@
 //======== kCore Decomposition =======//
 //
 // Usage: ./kcore.exe --dataset <dataset path> --kcore <k value>
+//                    --coreness
 
 #include "common.h"
 #include "def.h"
 #include "openG.h"
+#include "frontier.h"
 #include <queue>
 #include "omp.h"
 
@@ -24,8 +26,8 @@ class vertex_property
 public:
     vertex_property():degree(0),core(0){}
 
-    int16_t degree;
-    uint16_t core;
+    int64_t degree;
+    uint32_t core;
 };
 class edge_property
 {
@@ -43,6 +45,7 @@ typedef graph_t::edge_iterator      edge_iterator;
 void arg_init(argument_parser & arg)
 {
     arg.add_arg("kcore","3","kCore k value");
+    arg.add_arg("coreness","0","full coreness of every vertex instead of peeling up to k", false);
 }
 //==============================================================//
 inline unsigned vertex_distributor(uint64_t vid, unsigned threadnum)
@@ -56,7 +59,7 @@ void seq_init(graph_t& g)
     for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++) 
     {
         size_t degree = vit->edges_size();
-        vit->property().degree = (int16_t)degree;
+        vit->property().degree = (int64_t)degree;
     }
 }
 void kcore(graph_t& g, size_t k,
@@ -71,7 +74,7 @@ void kcore(graph_t& g, size_t k,
         for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++)
         {
             if (vit->property().core != 0) continue;
-            if (vit->property().degree > (int16_t)iter) continue;
+            if (vit->property().degree > (int64_t)iter) continue;
 
             vit->property().core = iter;
             for (edge_iterator eit=vit->edges_begin(); eit!=vit->edges_end(); eit++) 
@@ -111,7 +114,7 @@ void parallel_kcore(graph_t& g, size_t k, unsigned threadnum,
             {
                 vertex_iterator vit = g.find_vertex(vid);
                 if (vit->property().core != 0) continue;
-                if (vit->property().degree > (int16_t)iter) continue;
+                if (vit->property().degree > (int64_t)iter) continue;
 
                 vit->property().core = iter;
 
@@ -119,11 +122,7 @@ void parallel_kcore(graph_t& g, size_t k, unsigned threadnum,
                 {
                     uint64_t dest_vid = eit->target();
                     vertex_iterator destvit = g.find_vertex(dest_vid);
-#ifdef HMC
-                    HMC_ADD_16B(&(destvit->property().degree), -1); 
-#else
                     __sync_fetch_and_sub(&(destvit->property().degree), 1);
-#endif                        
                 }
             }
         }
@@ -135,6 +134,216 @@ void parallel_kcore(graph_t& g, size_t k, unsigned threadnum,
 
 }
 //==============================================================//
+// full coreness. edge lists are taken as the adjacency, like above, and
+// every vertex gets the largest k of a k-core it belongs to.
+// return the max core
+
+#define NO_CORE 0xffffffff
+
+// batagelj-zaversnik. vertices are kept sorted by current degree in
+// "vert", with "bin" pointing at the first vertex of each degree. the
+// vertex of lowest degree is removed and each neighbor of higher degree
+// is swapped to the front of its bin and moves down one degree, O(m)
+uint32_t bz_coreness(graph_t& g, vector<uint32_t>& core,
+        gBenchPerf_event & perf, int perf_group)
+{
+    uint64_t bound = g.vid_bound();
+    vector<uint64_t> deg(bound, 0), pos(bound, 0);
+    vector<uint64_t> vert(g.num_vertices());
+    uint64_t maxdeg = 0;
+    for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++)
+    {
+        deg[vit->id()] = vit->edges_size();
+        maxdeg = max(maxdeg, deg[vit->id()]);
+    }
+
+    // counting sort by degree
+    vector<uint64_t> bin(maxdeg+1, 0);
+    for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++)
+        bin[deg[vit->id()]]++;
+    uint64_t start = 0;
+    for (uint64_t d=0;d<=maxdeg;d++)
+    {
+        uint64_t num = bin[d];
+        bin[d] = start;
+        start += num;
+    }
+    for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++)
+    {
+        uint64_t vid = vit->id();
+        pos[vid] = bin[deg[vid]]++;
+        vert[pos[vid]] = vid;
+    }
+    for (uint64_t d=maxdeg;d>0;d--)
+        bin[d] = bin[d-1];
+    bin[0] = 0;
+
+    perf.open(perf_group);
+    perf.start(perf_group);
+#ifdef SIM
+    SIM_BEGIN(true);
+#endif
+    core.assign(bound, NO_CORE);
+    uint32_t maxcore = 0;
+    for (uint64_t i=0;i<vert.size();i++)
+    {
+        uint64_t vid = vert[i];
+        core[vid] = deg[vid];
+        maxcore = max(maxcore, core[vid]);
+
+        vertex_iterator vit = g.find_vertex(vid);
+        for (edge_iterator eit=vit->edges_begin(); eit!=vit->edges_end(); eit++) 
+        {
+            uint64_t u = eit->target();
+            if (deg[u] <= deg[vid]) continue;
+
+            uint64_t du = deg[u];
+            uint64_t pu = pos[u];
+            uint64_t pw = bin[du];
+            uint64_t w = vert[pw];
+            if (u != w)
+            {
+                pos[u] = pw;
+                vert[pu] = w;
+                pos[w] = pu;
+                vert[pw] = u;
+            }
+            bin[du]++;
+            deg[u]--;
+        }
+    }
+#ifdef SIM
+    SIM_END(true);
+#endif
+    perf.stop(perf_group);
+    return maxcore;
+}
+
+// parallel peeling. level k removes the remaining vertices of degree
+// <= k in sub-rounds. only the neighbors whose degree just dropped to k
+// join the next sub-round, so a level does not rescan the graph. each
+// level starts with one scan of the remaining vertices, which also finds
+// their minimum degree: k jumps to it, so levels without vertices cost
+// nothing. the list of remaining vertices is compacted when half of it
+// is removed
+uint32_t parallel_coreness(graph_t& g, unsigned threadnum, vector<uint32_t>& core,
+        gBenchPerf_multi & perf, int perf_group)
+{
+    uint64_t bound = g.vid_bound();
+    vector<int64_t> deg(bound, 0);
+    vector<uint64_t> remaining;
+    for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++)
+    {
+        deg[vit->id()] = vit->edges_size();
+        remaining.push_back(vit->id());
+    }
+    core.assign(bound, NO_CORE);
+
+    frontier front(bound, threadnum);
+    uint64_t left = remaining.size();
+    uint32_t k = 0;
+    // per thread: minimum degree of its remaining vertices and the
+    // vertices of that degree
+    vector<int64_t> min_deg(threadnum);
+    vector<vector<uint64_t> > min_vids(threadnum);
+    #pragma omp parallel num_threads(threadnum)
+    {
+        unsigned tid = omp_get_thread_num();
+
+        perf.open(tid, perf_group);
+        perf.start(tid, perf_group);  
+#ifdef SIM
+        SIM_BEGIN(true);
+#endif   
+        while (left > 0)
+        {
+            uint64_t begin = remaining.size()*tid/threadnum;
+            uint64_t end = remaining.size()*(tid+1)/threadnum;
+            int64_t & local_min = min_deg[tid];
+            vector<uint64_t> & local_vids = min_vids[tid];
+            local_min = numeric_limits<int64_t>::max();
+            local_vids.clear();
+            for (uint64_t i=begin;i<end;i++)
+            {
+                uint64_t vid = remaining[i];
+                if (core[vid]!=NO_CORE || deg[vid] > local_min) continue;
+                if (deg[vid] < local_min)
+                {
+                    local_min = deg[vid];
+                    local_vids.clear();
+                }
+                local_vids.push_back(vid);
+            }
+            #pragma omp barrier
+            #pragma omp master
+            {
+                // remaining degrees are all above the previous level
+                int64_t m = *min_element(min_deg.begin(), min_deg.end());
+                if (m > (int64_t)k) k = m;
+            }
+            #pragma omp barrier
+            if (local_min <= (int64_t)k)
+            {
+                for (size_t i=0;i<local_vids.size();i++)
+                    front.push(tid, local_vids[i]);
+            }
+            #pragma omp barrier
+            #pragma omp master
+            front.plan();
+            #pragma omp barrier
+            front.build(tid);
+            #pragma omp barrier
+
+            while (!front.empty())
+            {
+                front.range(tid, begin, end);
+                for (uint64_t i=begin;i<end;i++)
+                {
+                    uint64_t vid = front[i];
+                    core[vid] = k;
+
+                    vertex_iterator vit = g.find_vertex(vid);
+                    for (edge_iterator eit=vit->edges_begin();eit!=vit->edges_end();eit++)
+                    {
+                        uint64_t u = eit->target();
+                        if (core[u] != NO_CORE) continue;
+                        // a vertex of this level may still be counted down
+                        if (__sync_fetch_and_sub(&(deg[u]), 1) == (int64_t)k+1)
+                            front.push(tid, u);
+                    }
+                }
+                #pragma omp barrier
+                #pragma omp master
+                {
+                    left -= front.size();   // processed
+                    front.plan();
+                }
+                #pragma omp barrier
+                front.build(tid);
+                #pragma omp barrier
+            }
+
+            #pragma omp master
+            {
+                k++;
+                if (remaining.size() > 2*left)
+                {
+                    size_t cnt = 0;
+                    for (size_t i=0;i<remaining.size();i++)
+                        if (core[remaining[i]]==NO_CORE) remaining[cnt++] = remaining[i];
+                    remaining.resize(cnt);
+                }
+            }
+            #pragma omp barrier
+        }
+#ifdef SIM
+        SIM_END(true);
+#endif
+        perf.stop(tid, perf_group);
+    }
+    return (k>0) ? k-1 : 0;
+}
+//==============================================================//
 void output(graph_t& g)
 {
     cout<<"kCore Results: \n";
@@ -177,6 +386,8 @@ int main(int argc, char * argv[])
     size_t k,threadnum;
     arg.get_value("kcore",k);
     arg.get_value("threadnum",threadnum);
+    bool coreness;
+    arg.get_value("coreness",coreness);
     
     graph_t graph;
     cout<<"loading data... \n";
@@ -206,11 +417,14 @@ int main(int argc, char * argv[])
 #endif
 
     cout<<"computing kCore: k="<<k<<"\n";
+    if (coreness) cout<<"full coreness"<<endl;
 
     gBenchPerf_multi perf_multi(threadnum, perf);
     unsigned run_num = ceil(perf.get_event_cnt() /(double) DEFAULT_PERF_GRP_SZ);
     if (run_num==0) run_num = 1;
     double elapse_time = 0;
+    uint32_t maxcore = 0;
+    vector<uint32_t> core;
     
     for (unsigned i=0;i<run_num;i++)
     {
@@ -218,7 +432,11 @@ int main(int argc, char * argv[])
 
         t1 = timer::get_usec();
 
-        if (threadnum==1)
+        if (coreness && threadnum==1)
+            maxcore = bz_coreness(graph, core, perf, i);
+        else if (coreness)
+            maxcore = parallel_coreness(graph, threadnum, core, perf_multi, i);
+        else if (threadnum==1)
             kcore(graph, k, perf, i);
         else
             parallel_kcore(graph, k, threadnum, perf_multi, i);
@@ -226,6 +444,17 @@ int main(int argc, char * argv[])
         elapse_time += t2-t1;
         if ((i+1)<run_num) reset_graph(graph);
     }
+    if (coreness)
+    {
+        size_t cnt = 0;
+        for (vertex_iterator vit=graph.vertices_begin(); vit!=graph.vertices_end(); vit++)
+        {
+            vit->property().core = core[vit->id()];
+            if (core[vit->id()] >= k) cnt++;
+        }
+        cout<<"== max core: "<<maxcore<<"\n";
+        cout<<"== vertices in the "<<k<<"-core: "<<cnt<<"\n";
+    }
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<elapse_time/run_num<<" sec\n";
     if (threadnum == 1)
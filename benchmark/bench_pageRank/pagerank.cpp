@@ -4,6 +4,7 @@
 #include "common.h"
 #include "def.h"
 #include "openG.h"
+#include "frontier.h"
 #include <math.h>
 #include <stack>
 #include <iomanip>
@@ -49,6 +50,11 @@ void arg_init(argument_parser & arg)
     arg.add_arg("damp","0.85","damping factor");
     arg.add_arg("maxiter","100","maximum allowed iteration number");
     arg.add_arg("quad","0.001","quadratic error value");
+    arg.add_arg("pull","0","pull model: gather from predecessors without atomics", false);
+    arg.add_arg("async","0","asynchronous residual push mode", false);
+    arg.add_arg("residual","0","residual threshold of the asynchronous mode, implies --async. 0: quad divided by # of vertices");
+    arg.add_arg("batches","0","# of edge update batches from id.rand, applied incrementally after the run");
+    arg.add_arg("batchsize","100","edge changes per update batch");
 }
 //==============================================================//
 void init_pagerank(graph_t& g, double damp, unsigned threadnum)
@@ -77,7 +83,8 @@ void init_pagerank(graph_t& g, double damp, unsigned threadnum)
         }
     }
 }
-void parallel_pagerank(graph_t& g, 
+// return # of iterations
+unsigned parallel_pagerank(graph_t& g, 
         unsigned threadnum, 
         double damp,
         double quad,
@@ -89,6 +96,7 @@ void parallel_pagerank(graph_t& g,
     vector<float> e_vec(threadnum, 0);
     float random_weight = (1.0 - damp) / (double)g.num_vertices();
     bool stop = false;
+    unsigned iterations = 0;
     #pragma omp parallel num_threads(threadnum)
     {
         unsigned tid = omp_get_thread_num();
@@ -159,6 +167,7 @@ void parallel_pagerank(graph_t& g,
                     tot += e_vec[i];
                 }
                 float err = sqrt(tot);
+                iterations++;
                 if (err < quad || (++itercnt) > maxiter)
                 {
                     stop = true;
@@ -172,7 +181,384 @@ void parallel_pagerank(graph_t& g,
 #endif  
         perf.stop(tid, perf_group);
     }
+    return iterations;
 }
+
+//==============================================================//
+// pull model. every vertex sums damp*pr/outdeg of its predecessors,
+// read from a dense array, into the other one of two rank vectors. no
+// atomics are needed. predecessor ids are first copied into a
+// transposed CSR, "setup_time" is the time spent on that
+
+// undirected graphs keep in edges as out edges
+inline edge_iterator preds_begin(graph_t& g, vertex_iterator vit)
+{
+    return (g.get_directness()==openG::DIRECTED) ? vit->preds_begin() : vit->edges_begin();
+}
+inline edge_iterator preds_end(graph_t& g, vertex_iterator vit)
+{
+    return (g.get_directness()==openG::DIRECTED) ? vit->preds_end() : vit->edges_end();
+}
+inline uint64_t preds_size(graph_t& g, vertex_iterator vit)
+{
+    return (g.get_directness()==openG::DIRECTED) ? vit->preds_size() : vit->edges_size();
+}
+
+// return # of iterations
+unsigned pull_pagerank(graph_t& g, 
+        unsigned threadnum, 
+        double damp,
+        double quad,
+        size_t maxiter,
+        double & setup_time,
+        gBenchPerf_multi & perf, 
+        int perf_group)
+{
+    double t1 = timer::get_usec();
+    uint64_t bound = g.vid_bound();
+    vector<float> e_vec(threadnum, 0);
+    float random_weight = (1.0 - damp) / (double)g.num_vertices();
+
+    vector<char> valid(bound, 0);
+    vector<float> rank(bound, 0), next_rank(bound, 0);
+    vector<float> inv_degree(bound, 0), contrib(bound, 0);
+    vector<uint64_t> pred_offsets(bound+1, 0), preds;
+
+    #pragma omp parallel for num_threads(threadnum) schedule(dynamic,64)
+    for (uint64_t vid=0;vid<bound;vid++)
+    {
+        vertex_iterator vit = g.find_vertex(vid);
+        if (vit == g.vertices_end()) continue;
+        valid[vid] = 1;
+        rank[vid] = vit->property().pr;
+        if (vit->edges_size() > 0) inv_degree[vid] = 1.0/(double)vit->edges_size();
+        pred_offsets[vid+1] = preds_size(g, vit);
+    }
+    for (uint64_t vid=0;vid<bound;vid++)
+        pred_offsets[vid+1] += pred_offsets[vid];
+    preds.resize(pred_offsets[bound]);
+    #pragma omp parallel for num_threads(threadnum) schedule(dynamic,64)
+    for (uint64_t vid=0;vid<bound;vid++)
+    {
+        if (!valid[vid]) continue;
+        vertex_iterator vit = g.find_vertex(vid);
+        uint64_t pos = pred_offsets[vid];
+        for (edge_iterator eit=preds_begin(g,vit);eit!=preds_end(g,vit);eit++)
+            preds[pos++] = eit->target();
+    }
+    setup_time = timer::get_usec() - t1;
+
+    bool stop = false;
+    unsigned iterations = 0;
+    #pragma omp parallel num_threads(threadnum)
+    {
+        unsigned tid = omp_get_thread_num();
+
+        perf.open(tid, perf_group);
+        perf.start(tid, perf_group); 
+#ifdef SIM
+        unsigned iter = 0;
+#endif 
+        while(stop == false)
+        {
+            #pragma omp for schedule(static)
+            for (uint64_t vid=0;vid<bound;vid++)
+                contrib[vid] = damp * rank[vid] * inv_degree[vid];
+#ifdef SIM
+            SIM_BEGIN(iter==beginiter);
+            iter++;
+#endif
+            float err = 0;
+            #pragma omp for schedule(dynamic,64) nowait
+            for (uint64_t vid=0;vid<bound;vid++)
+            {
+                if (!valid[vid]) continue;
+                float sum = random_weight;
+                for (uint64_t j=pred_offsets[vid];j<pred_offsets[vid+1];j++)
+                    sum += contrib[preds[j]];
+                next_rank[vid] = sum;
+                float d = sum - rank[vid];
+                err += d * d;
+            }
+            e_vec[tid] = err;
+#ifdef SIM
+            SIM_END(iter==enditer);
+#endif
+            // check stop condition
+            #pragma omp barrier
+            if (tid==0)
+            {
+                float tot=0;
+                for (unsigned i=0;i<threadnum;i++)
+                {
+                    tot += e_vec[i];
+                }
+                rank.swap(next_rank);
+                iterations++;
+                if (sqrt(tot) < quad || (++itercnt) > maxiter)
+                    stop = true;
+            }
+            #pragma omp barrier
+        }
+#ifdef SIM
+        SIM_END(enditer==0);
+#endif  
+        perf.stop(tid, perf_group);
+    }
+
+    for (uint64_t vid=0;vid<bound;vid++)
+    {
+        if (!valid[vid]) continue;
+        vertex_iterator vit = g.find_vertex(vid);
+        vit->property().old_pr = next_rank[vid];
+        vit->property().pr = rank[vid];
+    }
+    return iterations;
+}
+
+//==============================================================//
+// residual push model. every vertex holds a residual besides its rank,
+// such that rank[v] + residual[v] = (1-damp)/N + damp * sigma(rank[u]/L_u)
+// over the predecessors u of v. processing a vertex moves its residual
+// into its rank and pushes damp*residual/outdeg to the residuals of its
+// successors. only vertices whose residual reached "threshold" are
+// processed again, so the ranks converge to the fixed point of the
+// synchronous iterations.
+class residual_state
+{
+public:
+    vector<float> rank;
+    vector<float> residual;
+    frontier front;     // vertices to process
+};
+
+// process the vertices of st.front until no residual reaches the
+// threshold. residuals may be negative after edge deletions.
+// return # of rounds, "updates" is # of processed vertices
+unsigned propagate_residuals(graph_t& g, 
+        unsigned threadnum, 
+        double damp,
+        double threshold,
+        residual_state & st,
+        uint64_t & updates,
+        gBenchPerf_multi & perf, 
+        int perf_group)
+{
+    vector<float> & rank = st.rank;
+    vector<float> & residual = st.residual;
+    frontier & front = st.front;
+
+    unsigned rounds = 0;
+    uint64_t cnt = 0;
+    #pragma omp parallel num_threads(threadnum) reduction(+:cnt)
+    {
+        unsigned tid = omp_get_thread_num();
+
+        perf.open(tid, perf_group);
+        perf.start(tid, perf_group); 
+#ifdef SIM
+        SIM_BEGIN(true);
+#endif 
+        while (!front.empty())
+        {
+            uint64_t begin, end;
+            front.range(tid, begin, end);
+            for (uint64_t i=begin;i<end;i++)
+            {
+                uint64_t vid = front[i];
+                float r;
+                #pragma omp atomic capture
+                {
+                    r = residual[vid];
+                    residual[vid] = 0;
+                }
+                rank[vid] += r;
+                cnt++;
+
+                vertex_iterator vit = g.find_vertex(vid);
+                if (vit->edges_size()==0) continue;
+                float r_push = damp * r / (double) vit->edges_size();
+                for (edge_iterator eit=vit->edges_begin(); eit!=vit->edges_end(); eit++)
+                {
+                    uint64_t dest = eit->target();
+                    float old;
+                    #pragma omp atomic capture
+                    {
+                        old = residual[dest];
+                        residual[dest] += r_push;
+                    }
+                    // activate on crossing the threshold
+                    if (fabs(old) < threshold && fabs(old + r_push) >= threshold)
+                        front.push(tid, dest);
+                }
+            }
+            #pragma omp barrier
+            #pragma omp master
+            {
+                front.plan();
+                rounds++;
+            }
+            #pragma omp barrier
+            front.build(tid);
+            #pragma omp barrier
+        }
+#ifdef SIM
+        SIM_END(true);
+#endif  
+        perf.stop(tid, perf_group);
+    }
+    updates = cnt;
+    return rounds;
+}
+
+// pr starts at 0 and every vertex at a residual of (1-damp)/N.
+// return # of rounds
+unsigned residual_pagerank(graph_t& g, 
+        unsigned threadnum, 
+        double damp,
+        double threshold,
+        residual_state & st,
+        uint64_t & updates,
+        gBenchPerf_multi & perf, 
+        int perf_group)
+{
+    uint64_t bound = g.vid_bound();
+    st.rank.assign(bound, 0);
+    st.residual.assign(bound, 0);
+
+    // every vertex is active once
+    st.front.init(bound, threadnum);
+    for (vertex_iterator vit=g.vertices_begin();vit!=g.vertices_end();vit++)
+    {
+        st.residual[vit->id()] = (1.0 - damp) / (double)g.num_vertices();
+        st.front.push(0, vit->id());
+    }
+    st.front.advance();
+
+    return propagate_residuals(g, threadnum, damp, threshold, st, updates, perf, perf_group);
+}
+
+void store_ranks(graph_t& g, vector<float>& rank)
+{
+    for (vertex_iterator vit=g.vertices_begin();vit!=g.vertices_end();vit++)
+    {
+        vit->property().old_pr = vit->property().pr;
+        vit->property().pr = rank[vit->id()];
+    }
+}
+
+//==============================================================//
+// incremental mode. a batch of edge changes only moves the residuals of
+// the successors of the changed sources, by the difference between their
+// old and new damp*rank/outdeg contributions. propagating these residual
+// deltas updates the ranks of st without recomputing them.
+// the number of vertices N is assumed to stay the same
+class edge_update
+{
+public:
+    edge_update():src(0),dest(0),insert(true){}
+    edge_update(uint64_t s, uint64_t d, bool i):src(s),dest(d),insert(i){}
+
+    uint64_t src;
+    uint64_t dest;
+    bool insert;    // false: delete all edges src->dest
+};
+
+// add sign*damp*rank/outdeg of every source in "sources" to the
+// residuals of its current successors
+void move_contributions(graph_t& g, unsigned threadnum, double damp, float sign,
+        vector<uint64_t>& sources, residual_state & st)
+{
+    #pragma omp parallel for num_threads(threadnum) schedule(dynamic,16)
+    for (size_t i=0;i<sources.size();i++)
+    {
+        vertex_iterator vit = g.find_vertex(sources[i]);
+        if (vit->edges_size()==0) continue;
+        float r_push = sign * damp * st.rank[sources[i]] / (double) vit->edges_size();
+        for (edge_iterator eit=vit->edges_begin(); eit!=vit->edges_end(); eit++)
+        {
+            #pragma omp atomic
+            st.residual[eit->target()] += r_push;
+        }
+    }
+}
+
+// apply "batch" to g via add_edge/delete_edge_v and update st.
+// return # of rounds, "updates" is # of processed vertices
+unsigned incremental_pagerank(graph_t& g, 
+        unsigned threadnum, 
+        double damp,
+        double threshold,
+        vector<edge_update> & batch,
+        residual_state & st,
+        uint64_t & updates,
+        gBenchPerf_multi & perf, 
+        int perf_group)
+{
+    bool undirected = (g.get_directness()==openG::UNDIRECTED);
+
+    // sources whose out edges change, and the end points of deletions.
+    // a deleted edge no longer reaches its dest, undirected also its src,
+    // so their residual drops without them being a successor of a source
+    vector<char> mark(st.rank.size(), 0);     // 1: in sources, 2: in removed
+    vector<uint64_t> sources, removed;
+    for (size_t i=0;i<batch.size();i++)
+    {
+        uint64_t ends[2] = {batch[i].src, batch[i].dest};
+        for (unsigned j=0;j<(undirected?2u:1u);j++)
+        {
+            if (mark[ends[j]] & 1) continue;
+            mark[ends[j]] |= 1;
+            sources.push_back(ends[j]);
+        }
+        if (batch[i].insert) continue;
+        for (unsigned j=(undirected?0u:1u);j<2;j++)
+        {
+            if (mark[ends[j]] & 2) continue;
+            mark[ends[j]] |= 2;
+            removed.push_back(ends[j]);
+        }
+    }
+
+    move_contributions(g, threadnum, damp, -1, sources, st);
+    for (size_t i=0;i<batch.size();i++)
+    {
+        if (batch[i].insert)
+        {
+            edge_iterator eit;
+            g.add_edge(batch[i].src, batch[i].dest, eit);
+        }
+        else
+            g.delete_edge_v(batch[i].src, batch[i].dest);
+    }
+    move_contributions(g, threadnum, damp, 1, sources, st);
+
+    // only residuals next to the batch have changed
+    #pragma omp parallel num_threads(threadnum)
+    {
+        unsigned tid = omp_get_thread_num();
+        #pragma omp for schedule(dynamic,16)
+        for (size_t i=0;i<sources.size();i++)
+        {
+            vertex_iterator vit = g.find_vertex(sources[i]);
+            for (edge_iterator eit=vit->edges_begin(); eit!=vit->edges_end(); eit++)
+            {
+                if (fabs(st.residual[eit->target()]) >= threshold)
+                    st.front.push(tid, eit->target());
+            }
+        }
+        #pragma omp for
+        for (size_t i=0;i<removed.size();i++)
+        {
+            if (fabs(st.residual[removed[i]]) >= threshold)
+                st.front.push(tid, removed[i]);
+        }
+    }
+    st.front.advance();
+
+    return propagate_residuals(g, threadnum, damp, threshold, st, updates, perf, perf_group);
+}
+
 void output(graph_t& g) 
 {
     cout<<"Page Rank Results: \n";
@@ -184,6 +570,196 @@ void output(graph_t& g)
     }
 }
 
+// synchronous iterations on dense ranks, starting from 1/N. without
+// "ref" they stop when no rank changes by "tolerance" or more, with it
+// when no rank is more than "tolerance" away from ref.
+// return # of iterations
+unsigned synchronous_ranks(graph_t& g, unsigned threadnum, double damp,
+        double tolerance, size_t maxiter, vector<double>& rank,
+        const vector<double>* ref)
+{
+    uint64_t bound = g.vid_bound();
+    double random_weight = (1.0 - damp) / (double)g.num_vertices();
+    vector<uint64_t> vids;
+    for (vertex_iterator vit=g.vertices_begin();vit!=g.vertices_end();vit++)
+        vids.push_back(vit->id());
+
+    rank.assign(bound, 0);
+    vector<double> next(bound, 0);
+    for (size_t i=0;i<vids.size();i++)
+        rank[vids[i]] = 1.0/(double)g.num_vertices();
+
+    unsigned iterations = 0;
+    double err;
+    do
+    {
+        for (size_t i=0;i<vids.size();i++)
+            next[vids[i]] = random_weight;
+        #pragma omp parallel for num_threads(threadnum) schedule(dynamic,64)
+        for (size_t i=0;i<vids.size();i++)
+        {
+            vertex_iterator vit = g.find_vertex(vids[i]);
+            if (vit->edges_size()==0) continue;
+            double pr_push = damp * rank[vids[i]] / (double) vit->edges_size();
+            for (edge_iterator eit=vit->edges_begin(); eit!=vit->edges_end(); eit++)
+            {
+                #pragma omp atomic
+                next[eit->target()] += pr_push;
+            }
+        }
+        err = 0;
+        for (size_t i=0;i<vids.size();i++)
+        {
+            uint64_t v = vids[i];
+            err = max(err, fabs(next[v] - ((ref==NULL) ? rank[v] : (*ref)[v])));
+        }
+        rank.swap(next);
+        iterations++;
+    } while (err > tolerance && iterations < maxiter);
+    return iterations;
+}
+
+// compare the residual ranks with the synchronous loop at matched
+// accuracy. a reference is iterated to max change threshold/1000, then
+// the loop runs until it is as close to the reference as the residual
+// ranks are. the residual ranks in g are kept
+void compare_synchronous(graph_t& g, unsigned threadnum, double damp, double threshold,
+        size_t maxiter, uint64_t updates)
+{
+    size_t ref_maxiter = max(maxiter, (size_t)1000);
+    vector<double> ref_rank, sync_rank;
+    unsigned ref_iterations = synchronous_ranks(g, threadnum, damp, threshold/1000,
+            ref_maxiter, ref_rank, NULL);
+
+    double res_err=0;
+    for (vertex_iterator vit=g.vertices_begin();vit!=g.vertices_end();vit++)
+        res_err = max(res_err, fabs(vit->property().pr - ref_rank[vit->id()]));
+
+    double t1 = timer::get_usec();
+    unsigned iterations = synchronous_ranks(g, threadnum, damp, res_err,
+            ref_maxiter, sync_rank, &ref_rank);
+    double t2 = timer::get_usec();
+    uint64_t sync_updates = iterations * (uint64_t)g.num_vertices();
+
+    double sync_err=0;
+    for (vertex_iterator vit=g.vertices_begin();vit!=g.vertices_end();vit++)
+        sync_err = max(sync_err, fabs(sync_rank[vit->id()] - ref_rank[vit->id()]));
+
+    cout<<"== max rank error vs reference ("<<ref_iterations<<" iterations): "
+        <<res_err<<"\n";
+    cout<<"== synchronous loop to the same error: "<<sync_updates
+        <<" vertex updates, "<<iterations<<" iterations, "<<t2-t1<<" sec, error "
+        <<sync_err<<"\n";
+    cout<<"== updates saved: "<<(int64_t)(sync_updates-updates)<<" ("
+        <<100.0*((double)sync_updates-updates)/max(sync_updates,(uint64_t)1)<<"%)\n";
+}
+
+//==============================================================//
+// update batches from the random ids of <dataset>/id.rand. change j of
+// the sequence takes the next two ids a and b (the file is wrapped
+// around). even changes insert a->b, odd ones delete the edge from a to
+// its (b mod outdeg)-th successor. ids are taken modulo the vertex id
+// bound, unknown vertices are skipped
+bool input_batches(string path, graph_t& g, size_t batches, size_t batchsize,
+        vector<vector<edge_update> > & out)
+{
+    string randfn = path + "/id.rand";
+    ifstream ifs(randfn.c_str());
+    if (ifs.is_open()==false)
+        return false;
+
+    vector<uint64_t> ids;
+    while (ifs.good())
+    {
+        string line;
+        getline(ifs,line);
+        
+        if (line.empty()) continue;
+        if (line[0]=='#') continue;
+
+        ids.push_back(atoll(line.c_str()) % g.vid_bound());
+    }
+    ifs.close();
+    if (ids.size() < 2) return false;
+
+    out.assign(batches, vector<edge_update>());
+    size_t pos=0;
+    for (size_t i=0;i<batches;i++)
+    {
+        for (size_t j=0;j<batchsize;j++)
+        {
+            uint64_t a = ids[pos++ % ids.size()];
+            uint64_t b = ids[pos++ % ids.size()];
+            vertex_iterator vit = g.find_vertex(a);
+            if (vit==g.vertices_end() || g.find_vertex(b)==g.vertices_end()) continue;
+
+            if (j%2==1 && vit->edges_size()>0)
+            {
+                edge_iterator eit = vit->edges_begin();
+                for (uint64_t k=b%vit->edges_size();k>0;k--) eit++;
+                out[i].push_back(edge_update(a, eit->target(), false));
+            }
+            else
+                out[i].push_back(edge_update(a, b, true));
+        }
+    }
+    return true;
+}
+
+// apply the update batches incrementally, starting from a residual run,
+// and recompute the synchronous loop from scratch after each of them.
+// the incremental latency includes applying the batch to the graph
+void update_benchmark(graph_t& g, string path, unsigned threadnum, double damp,
+        double quad, size_t maxiter, double threshold, size_t batches,
+        size_t batchsize, gBenchPerf_multi & perf)
+{
+    vector<vector<edge_update> > updates;
+    if (!input_batches(path, g, batches, batchsize, updates))
+    {
+        cout<<"Error in ID file\n";
+        return;
+    }
+
+    residual_state st;
+    uint64_t cnt;
+    residual_pagerank(g, threadnum, damp, threshold, st, cnt, perf, 0);
+    unsigned saved_itercnt = itercnt;
+
+    double inc_time=0, full_time=0;
+    uint64_t inc_updates=0, changes=0;
+    unsigned full_iterations=0;
+    float diff=0;
+    for (size_t i=0;i<batches;i++)
+    {
+        double t1 = timer::get_usec();
+        incremental_pagerank(g, threadnum, damp, threshold, updates[i], st, cnt, perf, 0);
+        double t2 = timer::get_usec();
+        inc_time += t2-t1;
+        inc_updates += cnt;
+        changes += updates[i].size();
+
+        init_pagerank(g, damp, threadnum);
+        itercnt = 0;
+        t1 = timer::get_usec();
+        full_iterations += parallel_pagerank(g, threadnum, damp, quad, maxiter, perf, 0);
+        t2 = timer::get_usec();
+        full_time += t2-t1;
+
+        for (vertex_iterator vit=g.vertices_begin();vit!=g.vertices_end();vit++)
+            diff = max(diff, (float)fabs(vit->property().pr - st.rank[vit->id()]));
+    }
+    store_ranks(g, st.rank);
+    itercnt = saved_itercnt;
+
+    cout<<"\nupdate batches: "<<batches<<", "<<changes<<" edge changes\n";
+    cout<<"== "<<g.num_vertices()<<" vertices  "<<g.num_edges()<<" edges\n";
+    cout<<"== incremental: "<<inc_time/batches<<" sec, "
+        <<inc_updates/batches<<" vertex updates per batch\n";
+    cout<<"== full recomputation: "<<full_time/batches<<" sec, "
+        <<full_iterations*(uint64_t)g.num_vertices()/batches<<" vertex updates per batch\n";
+    cout<<"== speedup: "<<full_time/inc_time<<"\n";
+    cout<<"== max rank difference: "<<diff<<"\n";
+}
 
 int main(int argc, char * argv[])
 {
@@ -205,14 +781,22 @@ int main(int argc, char * argv[])
     size_t threadnum, maxiter;
     arg.get_value("threadnum",threadnum);
     arg.get_value("maxiter",maxiter);
+    bool pull;
+    arg.get_value("pull",pull);
 #ifdef SIM
     arg.get_value("beginiter",beginiter);
     arg.get_value("enditer",enditer);
 #endif
 
-    double damp, quad;
+    double damp, quad, threshold;
     arg.get_value("damp",damp);
     arg.get_value("quad",quad);
+    arg.get_value("residual",threshold);
+    bool async;
+    arg.get_value("async",async);
+    size_t batches, batchsize;
+    arg.get_value("batches",batches);
+    arg.get_value("batchsize",batchsize);
 
     double t1, t2;
     graph_t graph;
@@ -238,16 +822,22 @@ int main(int argc, char * argv[])
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<t2-t1<<" sec\n";
 #endif
+    // like the update batches, the threshold defaults to quad per vertex
+    if (async && threshold == 0) threshold = quad / vertex_num;
 
     cout<<"threadnum: "<<threadnum<<endl;
     cout<<"damping factor: "<<damp<<endl;
     cout<<"quadratic error: "<<quad<<endl;
+    if (pull) cout<<"pull model"<<endl;
+    if (threshold > 0) cout<<"residual threshold: "<<threshold<<endl;
     cout<<"\ncomputing Page Rank ...\n";
 
     gBenchPerf_multi perf_multi(threadnum, perf);
     unsigned run_num = ceil(perf.get_event_cnt() / (double)DEFAULT_PERF_GRP_SZ);
     if (run_num==0) run_num = 1;
-    double elapse_time = 0;
+    double elapse_time = 0, setup_time = 0;
+    unsigned iterations = 0;
+    uint64_t updates = 0;
     
     for (unsigned i=0;i<run_num;i++)
     {
@@ -256,17 +846,43 @@ int main(int argc, char * argv[])
         // Degree Centrality
         t1 = timer::get_usec();
         
-        parallel_pagerank(graph, threadnum, damp, quad, maxiter, perf_multi, i);
+        double t = 0;
+        if (threshold > 0)
+        {
+            residual_state st;
+            itercnt = residual_pagerank(graph, threadnum, damp, threshold, st, updates, perf_multi, i);
+            store_ranks(graph, st.rank);
+        }
+        else if (pull)
+            iterations += pull_pagerank(graph, threadnum, damp, quad, maxiter, t, perf_multi, i);
+        else
+            iterations += parallel_pagerank(graph, threadnum, damp, quad, maxiter, perf_multi, i);
+        setup_time += t;
 
         t2 = timer::get_usec();
         elapse_time += t2-t1;
     }
+    if (threshold == 0) updates = iterations * (uint64_t)vertex_num / run_num;
 
 
     cout<<"Page Rank finish \n";
     cout<<"== iteration #: "<<itercnt<<endl;
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<elapse_time/run_num<<" sec\n";
+    if (pull)
+        cout<<"== setup time: "<<setup_time/run_num<<" sec\n";
+    if (threshold == 0)
+        cout<<"== iteration time: "<<(elapse_time-setup_time)/max(iterations,1u)<<" sec\n";
+    cout<<"== vertex updates: "<<updates<<"\n";
+    if (threshold > 0)
+        compare_synchronous(graph, threadnum, damp, threshold, maxiter, updates);
+    if (batches > 0)
+    {
+        // residual deltas need a threshold, by default quad per vertex
+        double t = (threshold > 0) ? threshold : quad / vertex_num;
+        update_benchmark(graph, path, threadnum, damp, quad, maxiter, t,
+                batches, batchsize, perf_multi);
+    }
     if (threadnum == 1)
         perf.print();
     else
@@ -6,11 +6,14 @@
 // Usage: ./sssp    --dataset <dataset path> 
 //                  --root <root vertex id> 
 //                  --target <target vertex id>
+//                  --delta <bucket width, 0: bellman-ford>
 
 #include "common.h"
 #include "def.h"
 #include "openG.h"
-#include <queue>
+#include "frontier.h"
+#include "monotone_queue.h"
+#include <algorithm>
 #include "omp.h"
 
 #ifdef HMC
@@ -52,22 +55,24 @@ typedef graph_t::edge_iterator      edge_iterator;
 void arg_init(argument_parser & arg)
 {
     arg.add_arg("root","0","root/starting vertex");
+    arg.add_arg("delta","0","bucket width of delta-stepping, 0 for level-synchronous bellman-ford");
 }
 //==============================================================//
-typedef pair<size_t,size_t> data_pair;
-class comp
+class relax_stat
 {
 public:
-    bool operator()(data_pair a, data_pair b)
-    {
-        return a.second > b.second;
-    }
-};
+    relax_stat():relaxations(0),phases(0),buckets(0){}
 
-
-void sssp(graph_t& g, size_t src, gBenchPerf_event & perf, int perf_group)
+    uint64_t relaxations;   // # of edges relaxed
+    uint64_t phases;        // # of synchronized rounds
+    uint64_t buckets;       // # of delta-stepping buckets
+};
+//==============================================================//
+// dijkstra on a radix heap. a vertex may be queued once per distance
+// improvement, entries above its current distance are skipped
+void sssp(graph_t& g, size_t src, relax_stat& stat, gBenchPerf_event & perf, int perf_group)
 {
-    priority_queue<data_pair, vector<data_pair>, comp> PQ;
+    radix_heap<uint64_t> PQ;
     
     perf.open(perf_group);
     perf.start(perf_group);
@@ -77,15 +82,16 @@ void sssp(graph_t& g, size_t src, gBenchPerf_event & perf, int perf_group)
     // initialize
     vertex_iterator src_vit = g.find_vertex(src);
     src_vit->property().distance = 0;
-    PQ.push(data_pair(src,0));
+    PQ.push(0, src);
 
     // for every un-visited vertex, try relaxing the path
     while (!PQ.empty())
     {
-        size_t u = PQ.top().first; 
-        PQ.pop();
+        uint64_t d, u;
+        PQ.pop(d, u);
 
         vertex_iterator u_vit = g.find_vertex(u);
+        if (d > u_vit->property().distance) continue;
 
         for (edge_iterator eit = u_vit->edges_begin(); eit != u_vit->edges_end(); eit++)
         {
@@ -93,11 +99,12 @@ void sssp(graph_t& g, size_t src, gBenchPerf_event & perf, int perf_group)
             vertex_iterator v_vit = g.find_vertex(v);
 
             size_t alt = u_vit->property().distance + eit->property().weight;
+            stat.relaxations++;
             if (alt < v_vit->property().distance) 
             {
                 v_vit->property().distance = alt;
                 v_vit->property().predecessor = u;
-                PQ.push(data_pair(v,alt));
+                PQ.push(alt, v);
             }
         }
     }
@@ -108,11 +115,8 @@ void sssp(graph_t& g, size_t src, gBenchPerf_event & perf, int perf_group)
     return;
 }
 
-inline unsigned vertex_distributor(uint64_t vid, unsigned threadnum)
-{
-    return vid%threadnum;
-}
-void parallel_sssp(graph_t& g, size_t root, unsigned threadnum, gBenchPerf_multi & perf, int perf_group)
+void parallel_sssp(graph_t& g, size_t root, unsigned threadnum, relax_stat& stat, 
+        gBenchPerf_multi & perf, int perf_group)
 {
     vertex_iterator rootvit=g.find_vertex(root);
     rootvit->property().distance = 0;
@@ -121,38 +125,43 @@ void parallel_sssp(graph_t& g, size_t root, unsigned threadnum, gBenchPerf_multi
     //vector<uint16_t> update(g.num_vertices(), MY_INFINITY);
     //update[root] = 0;
 
-    bool * locks = new bool[g.num_vertices()];
-    memset(locks, 0, sizeof(bool)*g.num_vertices()); 
-
-    vector<vector<uint64_t> > global_input_tasks(threadnum);
-    global_input_tasks[vertex_distributor(root,threadnum)].push_back(root);
-    
-    vector<vector<uint64_t> > global_output_tasks(threadnum*threadnum);
+    bool * locks = new bool[g.vid_bound()];
+    memset(locks, 0, sizeof(bool)*g.vid_bound()); 
 
+    frontier front(g.vid_bound(), threadnum);
+    front.push(0, root);
+    front.advance();
     
-    bool stop = false;
-    #pragma omp parallel num_threads(threadnum) shared(stop,global_input_tasks,global_output_tasks) 
+    uint64_t relaxations=0, phases=0;
+    #pragma omp parallel num_threads(threadnum) shared(front) reduction(+:relaxations)
     {
         unsigned tid = omp_get_thread_num();
-        vector<uint64_t> & input_tasks = global_input_tasks[tid];
      
         perf.open(tid, perf_group);
         perf.start(tid, perf_group); 
 #ifdef SIM
         unsigned iter = 0;
 #endif 
-        while(!stop)
+        while(!front.empty())
         {
+            // process local share of the frontier
+            uint64_t begin, end;
+            front.range(tid, begin, end);
+            for (uint64_t i=begin;i<end;i++) 
+            {
+                vertex_iterator vit = g.find_vertex(front[i]);
+                vit->property().distance = vit->property().update;
+            }
+            // the copy reads update without the lock, relaxations of
+            // other threads must not start before it is done
             #pragma omp barrier
-            // process local queue
-            stop = true;
 #ifdef SIM
             SIM_BEGIN(iter==beginiter);
             iter++;
 #endif           
-            for (unsigned i=0;i<input_tasks.size();i++)
+            for (uint64_t i=begin;i<end;i++)
             {
-                uint64_t vid=input_tasks[i];
+                uint64_t vid=front[i];
                 vertex_iterator vit = g.find_vertex(vid);
                 
                 uint16_t curr_dist = vit->property().distance;
@@ -161,10 +170,11 @@ void parallel_sssp(graph_t& g, size_t root, unsigned threadnum, gBenchPerf_multi
                     uint64_t dest_vid = eit->target();
                     vertex_iterator dvit = g.find_vertex(dest_vid);
                     uint16_t new_dist = curr_dist + eit->property().weight;
+                    relaxations++;
 #ifdef HMC
                     if (HMC_CAS_greater_16B(&(dvit->property().update),new_dist) > new_dist) 
                     {
-                        global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                        front.push(tid, dest_vid);
                     }
 #else
                     bool active=false;
@@ -182,7 +192,7 @@ void parallel_sssp(graph_t& g, size_t root, unsigned threadnum, gBenchPerf_multi
                     
                     if (active)
                     {
-                        global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                        front.push(tid, dest_vid);
                     }
 #endif
                 }
@@ -191,33 +201,169 @@ void parallel_sssp(graph_t& g, size_t root, unsigned threadnum, gBenchPerf_multi
             SIM_END(iter==enditer);
 #endif           
             #pragma omp barrier
-            input_tasks.clear();
-            for (unsigned i=0;i<threadnum;i++)
+            #pragma omp master
+            {
+                front.plan();
+                phases++;
+            }
+            #pragma omp barrier
+            front.build(tid);
+            #pragma omp barrier
+        }
+#ifdef SIM
+        SIM_END(enditer==0);
+#endif    
+        perf.stop(tid, perf_group);
+    }
+    stat.relaxations = relaxations;
+    stat.phases = phases;
+
+    delete[] locks;
+}
+
+//==============================================================//
+// delta-stepping. vertices wait in buckets of width delta by tentative
+// distance and the lowest non-empty bucket is processed in parallel.
+// light edges (weight <= delta) are relaxed in rounds until the bucket
+// stays empty. heavy edges can not land in the current bucket, their
+// requests are collected meanwhile and applied once it is settled.
+// buckets are thread local; entries whose distance dropped to a lower
+// bucket meanwhile are skipped when a bucket becomes current.
+
+#define NO_BUCKET ((uint64_t)-1)
+
+// lower *addr to val, true if it was larger
+inline bool atomic_min(uint16_t * addr, uint16_t val)
+{
+#ifdef HMC
+    return HMC_CAS_greater_16B(addr, val) > val;
+#else
+    uint16_t old = *addr;
+    while (val < old)
+    {
+        uint16_t prev = __sync_val_compare_and_swap(addr, old, val);
+        if (prev == old) return true;
+        old = prev;
+    }
+    return false;
+#endif
+}
+
+typedef pair<uint64_t,uint16_t> request_t;  // target, new distance
+
+// move the target to the bucket of its new distance if that is shorter
+inline void relax(graph_t& g, uint64_t dest_vid, uint16_t new_dist, size_t delta,
+        vector<vector<uint64_t> >& bins)
+{
+    vertex_iterator dvit = g.find_vertex(dest_vid);
+    if (atomic_min(&(dvit->property().distance), new_dist))
+    {
+        uint64_t b = new_dist/delta;
+        if (b >= bins.size()) bins.resize(b+1);
+        bins[b].push_back(dest_vid);
+    }
+}
+
+void delta_stepping(graph_t& g, size_t root, size_t delta, unsigned threadnum, 
+        relax_stat& stat, gBenchPerf_multi & perf, int perf_group)
+{
+    vertex_iterator rootvit=g.find_vertex(root);
+    rootvit->property().distance = 0;
+
+    frontier front(g.vid_bound(), threadnum);
+    front.push(0, root);
+    front.advance();
+
+    // per thread: current bucket not empty, lowest later bucket
+    vector<char> light_left(threadnum);
+    vector<uint64_t> next_bin(threadnum);
+    uint64_t relaxations=0, phases=0, buckets=0;
+
+    #pragma omp parallel num_threads(threadnum) shared(front) reduction(+:relaxations)
+    {
+        unsigned tid = omp_get_thread_num();
+        uint64_t curr_bin = 0;
+        vector<vector<uint64_t> > bins;
+        vector<request_t> heavy;
+
+        perf.open(tid, perf_group);
+        perf.start(tid, perf_group); 
+#ifdef SIM
+        SIM_BEGIN(true);
+#endif 
+        while (curr_bin != NO_BUCKET)
+        {
+            // light round on the current bucket
+            uint64_t begin, end;
+            front.range(tid, begin, end);
+            for (uint64_t i=begin;i<end;i++)
+            {
+                vertex_iterator vit = g.find_vertex(front[i]);
+                uint32_t curr_dist = vit->property().distance;
+                for (edge_iterator eit=vit->edges_begin();eit!=vit->edges_end();eit++)
+                {
+                    uint32_t new_dist = curr_dist + eit->property().weight;
+                    if (new_dist >= MY_INFINITY) continue;
+                    if (eit->property().weight > delta)
+                        heavy.push_back(request_t(eit->target(), new_dist));
+                    else
+                    {
+                        relax(g, eit->target(), new_dist, delta, bins);
+                        relaxations++;
+                    }
+                }
+            }
+            light_left[tid] = (curr_bin < bins.size() && !bins[curr_bin].empty());
+            #pragma omp barrier
+            bool settled = (std::count(light_left.begin(), light_left.end(), 1) == 0);
+            if (settled)
             {
-                if (global_output_tasks[i*threadnum+tid].size()!=0)
+                // relax heavy edges and look for the next bucket
+                for (size_t i=0;i<heavy.size();i++)
+                    relax(g, heavy[i].first, heavy[i].second, delta, bins);
+                relaxations += heavy.size();
+                heavy.clear();
+                next_bin[tid] = NO_BUCKET;
+                for (uint64_t b=curr_bin+1;b<bins.size();b++)
                 {
-                    stop = false;
-                    input_tasks.insert(input_tasks.end(),
-                            global_output_tasks[i*threadnum+tid].begin(),
-                            global_output_tasks[i*threadnum+tid].end());
-                    global_output_tasks[i*threadnum+tid].clear();
+                    if (bins[b].empty()) continue;
+                    next_bin[tid] = b;
+                    break;
                 }
             }
-            for (unsigned i=0;i<input_tasks.size();i++) 
+            #pragma omp barrier
+            if (settled)
+                curr_bin = *std::min_element(next_bin.begin(), next_bin.end());
+            if (tid==0)
             {
-                vertex_iterator vit = g.find_vertex(input_tasks[i]);
-                vit->property().distance = vit->property().update;
+                phases++;
+                if (settled) buckets++;
             }
+            if (curr_bin < bins.size())
+            {
+                vector<uint64_t> & bin = bins[curr_bin];
+                for (size_t i=0;i<bin.size();i++)
+                {
+                    if (g.find_vertex(bin[i])->property().distance/delta == curr_bin)
+                        front.push(tid, bin[i]);
+                }
+                bin.clear();
+            }
+            #pragma omp barrier
+            #pragma omp master
+            front.plan();
+            #pragma omp barrier
+            front.build(tid);
             #pragma omp barrier
         }
 #ifdef SIM
-        SIM_END(enditer==0);
+        SIM_END(true);
 #endif    
         perf.stop(tid, perf_group);
     }
-
-
-    delete[] locks;
+    stat.relaxations = relaxations;
+    stat.phases = phases;
+    stat.buckets = buckets;
 }
 
 //==============================================================//
@@ -267,9 +413,10 @@ int main(int argc, char * argv[])
     arg.get_value("dataset",path);
     arg.get_value("separator",separator);
 
-    size_t root,threadnum;
+    size_t root,threadnum,delta;
     arg.get_value("root",root);
     arg.get_value("threadnum",threadnum);
+    arg.get_value("delta",delta);
 
 
     graph_t graph;
@@ -313,15 +460,19 @@ int main(int argc, char * argv[])
     unsigned run_num = ceil(perf.get_event_cnt() /(double) DEFAULT_PERF_GRP_SZ);
     if (run_num==0) run_num = 1;
     double elapse_time = 0;
+    relax_stat stat;
     
     for (unsigned i=0;i<run_num;i++)
     {
         t1 = timer::get_usec();
 
-        if (threadnum==1)
-            sssp(graph, root, perf, i);
+        stat = relax_stat();
+        if (delta > 0)
+            delta_stepping(graph, root, delta, threadnum, stat, perf_multi, i);
+        else if (threadnum==1)
+            sssp(graph, root, stat, perf, i);
         else
-            parallel_sssp(graph, root, threadnum, perf_multi, i);
+            parallel_sssp(graph, root, threadnum, stat, perf_multi, i);
         
         t2 = timer::get_usec();
         elapse_time += t2-t1;
@@ -329,7 +480,13 @@ int main(int argc, char * argv[])
     }
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<elapse_time/run_num<<" sec\n";
-    if (threadnum == 1)
+    cout<<"== relaxations: "<<stat.relaxations
+        <<"  ("<<stat.relaxations/(double)max(edge_num,(size_t)1)<<" per edge)\n";
+    if (stat.phases > 0)
+        cout<<"== phases: "<<stat.phases<<"\n";
+    if (stat.buckets > 0)
+        cout<<"== buckets: "<<stat.buckets<<"\n";
+    if (threadnum == 1 && delta == 0)
         perf.print();
     else
         perf_multi.print();
@@ -2,6 +2,7 @@
 //======== Connected Component =======//
 //
 // Usage: ./tc.exe --dataset <dataset path>
+//                 --ordered
 
 #include "common.h"
 #include "def.h"
@@ -10,6 +11,10 @@
 #include <set>
 #include <vector>
 #include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TC_SIMD
+#endif
 
 #ifdef HMC
 #include "HMC.h"
@@ -51,6 +56,7 @@ typedef graph_t::edge_iterator      edge_iterator;
 void arg_init(argument_parser & arg)
 {
     arg.add_arg("maxiter","0","maximum loop iteration (0-unlimited, only set for simulation purpose)");
+    arg.add_arg("ordered","0","degree ordered: count on a compact csr of higher ranked neighbors", false);
 }
 //==============================================================//
 size_t get_intersect_cnt(vector<size_t>& setA, vector<size_t>& setB)
@@ -294,6 +300,248 @@ size_t parallel_triangle_count(graph_t& g, unsigned threadnum, vector<unsigned>&
     return ret;
 }
 
+//==============================================================//
+// degree ordered mode. vertices are relabeled by rank of (degree, id)
+// and each keeps only its neighbors of higher rank, sorted and without
+// duplicates, in a compact csr. every triangle u<v<w is then found once,
+// at the edge (u,v), and high degree vertices get short lists. in and
+// out edges are both taken as undirected edges.
+
+// a pair is intersected by galloping when one list is this many times
+// longer than the other
+#define GALLOP_RATIO 32
+
+class oriented_csr
+{
+public:
+    vector<uint64_t> offsets;
+    vector<uint32_t> adj;       // relabeled vertex ids
+};
+
+// first position in [begin,end) with a value >= key, probing 1,2,4,...
+// elements ahead before the binary search
+inline const uint32_t * gallop(const uint32_t * begin, const uint32_t * end, uint32_t key)
+{
+    size_t step = 1;
+    const uint32_t * lo = begin;
+    while (lo+step < end && lo[step] < key)
+    {
+        lo += step;
+        step *= 2;
+    }
+    const uint32_t * hi = (lo+step < end) ? lo+step+1 : end;
+    return std::lower_bound(lo, hi, key);
+}
+
+size_t intersect_gallop(const uint32_t * a, size_t na, const uint32_t * b, size_t nb)
+{
+    size_t ret=0;
+    const uint32_t * pos = b;
+    const uint32_t * end = b + nb;
+    for (size_t i=0;i<na && pos<end;i++)
+    {
+        pos = gallop(pos, end, a[i]);
+        if (pos<end && *pos==a[i]) ret++;
+    }
+    return ret;
+}
+
+inline size_t intersect_merge(const uint32_t * a, size_t na, const uint32_t * b, size_t nb)
+{
+    size_t ret=0, i=0, j=0;
+    while (i<na && j<nb)
+    {
+        if (a[i] < b[j]) i++;
+        else if (a[i] > b[j]) j++;
+        else
+        {
+            ret++;
+            i++;
+            j++;
+        }
+    }
+    return ret;
+}
+
+#ifdef TC_SIMD
+// all-pairs compare of 4x4 blocks. each element of a block of a is
+// compared with the 4 rotations of a block of b, then the block with
+// the smaller last element is consumed. lists must be duplicate free
+size_t intersect_sse(const uint32_t * a, size_t na, const uint32_t * b, size_t nb)
+{
+    size_t ret=0, i=0, j=0;
+    while (i+4<=na && j+4<=nb)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a+i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b+j));
+        __m128i m = _mm_cmpeq_epi32(va, vb);
+        m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0,3,2,1))));
+        m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1,0,3,2))));
+        m = _mm_or_si128(m, _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2,1,0,3))));
+        ret += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(m)));
+
+        uint32_t a_max = a[i+3], b_max = b[j+3];
+        if (a_max <= b_max) i += 4;
+        if (b_max <= a_max) j += 4;
+    }
+    return ret + intersect_merge(a+i, na-i, b+j, nb-j);
+}
+
+// same with 8x8 blocks and 8 rotations
+__attribute__((target("avx2")))
+size_t intersect_avx2(const uint32_t * a, size_t na, const uint32_t * b, size_t nb)
+{
+    const __m256i rot = _mm256_setr_epi32(1,2,3,4,5,6,7,0);
+    size_t ret=0, i=0, j=0;
+    while (i+8<=na && j+8<=nb)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a+i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b+j));
+        __m256i m = _mm256_cmpeq_epi32(va, vb);
+        for (unsigned r=1;r<8;r++)
+        {
+            vb = _mm256_permutevar8x32_epi32(vb, rot);
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi32(va, vb));
+        }
+        ret += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(m)));
+
+        uint32_t a_max = a[i+7], b_max = b[j+7];
+        if (a_max <= b_max) i += 8;
+        if (b_max <= a_max) j += 8;
+    }
+    return ret + intersect_sse(a+i, na-i, b+j, nb-j);
+}
+
+static const bool has_avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+// # of common elements of two sorted duplicate free lists
+inline size_t intersect(const uint32_t * a, size_t na, const uint32_t * b, size_t nb)
+{
+    if (na*GALLOP_RATIO < nb) return intersect_gallop(a, na, b, nb);
+    if (nb*GALLOP_RATIO < na) return intersect_gallop(b, nb, a, na);
+#ifdef TC_SIMD
+    if (has_avx2) return intersect_avx2(a, na, b, nb);
+    return intersect_sse(a, na, b, nb);
+#else
+    return intersect_merge(a, na, b, nb);
+#endif
+}
+
+// order vertex ids by degree, then by id
+class degree_less
+{
+public:
+    degree_less(const vector<uint64_t>& d):_degree(d){}
+
+    bool operator()(uint64_t a, uint64_t b)
+    {
+        return (_degree[a]==_degree[b]) ? (a<b) : (_degree[a]<_degree[b]);
+    }
+protected:
+    const vector<uint64_t> & _degree;
+};
+
+
+void build_oriented(graph_t& g, unsigned threadnum, oriented_csr& csr)
+{
+    uint64_t bound = g.vid_bound();
+    vector<uint64_t> order;
+    for (vertex_iterator vit=g.vertices_begin(); vit!=g.vertices_end(); vit++) 
+        order.push_back(vit->id());
+    vector<uint64_t> degree(bound, 0);
+    #pragma omp parallel for num_threads(threadnum) schedule(dynamic,64)
+    for (uint64_t i=0;i<order.size();i++)
+    {
+        vertex_iterator vit = g.find_vertex(order[i]);
+        // undirected graphs have no in edges
+        degree[order[i]] = vit->edges_size() + vit->preds_size();
+    }
+
+    // rank by degree, ties by id
+    std::sort(order.begin(), order.end(), degree_less(degree));
+    vector<uint32_t> rank(bound, 0);
+    for (uint64_t r=0;r<order.size();r++)
+        rank[order[r]] = r;
+
+    uint64_t n = order.size();
+    vector<uint64_t> len(n+1, 0);
+    csr.offsets.assign(n+1, 0);
+    // upper bound of each list
+    #pragma omp parallel for num_threads(threadnum) schedule(dynamic,64)
+    for (uint64_t r=0;r<n;r++)
+    {
+        vertex_iterator vit = g.find_vertex(order[r]);
+        uint64_t cnt=0;
+        for (edge_iterator eit=vit->edges_begin();eit!=vit->edges_end();eit++) 
+            if (rank[eit->target()] > r) cnt++;
+        for (edge_iterator eit=vit->preds_begin();eit!=vit->preds_end();eit++) 
+            if (rank[eit->target()] > r) cnt++;
+        len[r+1] = cnt;
+    }
+    for (uint64_t r=0;r<n;r++)
+        len[r+1] += len[r];
+
+    // fill, sort and drop duplicates in place
+    vector<uint32_t> tmp(len[n]);
+    #pragma omp parallel for num_threads(threadnum) schedule(dynamic,64)
+    for (uint64_t r=0;r<n;r++)
+    {
+        vertex_iterator vit = g.find_vertex(order[r]);
+        uint64_t pos = len[r];
+        for (edge_iterator eit=vit->edges_begin();eit!=vit->edges_end();eit++) 
+            if (rank[eit->target()] > r) tmp[pos++] = rank[eit->target()];
+        for (edge_iterator eit=vit->preds_begin();eit!=vit->preds_end();eit++) 
+            if (rank[eit->target()] > r) tmp[pos++] = rank[eit->target()];
+        std::sort(tmp.begin()+len[r], tmp.begin()+pos);
+        csr.offsets[r+1] = std::unique(tmp.begin()+len[r], tmp.begin()+pos) - (tmp.begin()+len[r]);
+    }
+    for (uint64_t r=0;r<n;r++)
+        csr.offsets[r+1] += csr.offsets[r];
+
+    // compact
+    csr.adj.resize(csr.offsets[n]);
+    #pragma omp parallel for num_threads(threadnum) schedule(dynamic,64)
+    for (uint64_t r=0;r<n;r++)
+        std::copy(tmp.begin()+len[r], tmp.begin()+len[r]+(csr.offsets[r+1]-csr.offsets[r]), 
+                csr.adj.begin()+csr.offsets[r]);
+}
+
+size_t ordered_triangle_count(oriented_csr& csr, unsigned threadnum, 
+        gBenchPerf_multi & perf, int perf_group)
+{
+    uint64_t n = csr.offsets.size()-1;
+    const uint32_t * adj = csr.adj.empty() ? NULL : &(csr.adj[0]);
+    size_t ret=0;
+
+    #pragma omp parallel num_threads(threadnum) reduction(+:ret)
+    {
+        unsigned tid = omp_get_thread_num();
+
+        perf.open(tid, perf_group);
+        perf.start(tid, perf_group);  
+#ifdef SIM
+        SIM_BEGIN(true);
+#endif
+        #pragma omp for schedule(dynamic,64)
+        for (uint64_t u=0;u<n;u++)
+        {
+            const uint32_t * a = adj + csr.offsets[u];
+            size_t na = csr.offsets[u+1] - csr.offsets[u];
+            for (size_t i=0;i<na;i++)
+            {
+                uint32_t v = a[i];
+                ret += intersect(a+i+1, na-i-1, adj+csr.offsets[v], csr.offsets[v+1]-csr.offsets[v]);
+            }
+        }
+#ifdef SIM
+        SIM_END(true);
+#endif  
+        perf.stop(tid, perf_group);
+    }
+    return ret;
+}
+
 void output(graph_t& g)
 {
     cout<<"Triangle Count Results: \n";
@@ -333,6 +581,8 @@ int main(int argc, char * argv[])
     size_t threadnum;
     arg.get_value("threadnum",threadnum);
     arg.get_value("maxiter",maxiter);
+    bool ordered;
+    arg.get_value("ordered",ordered);
 #ifdef SIM
     arg.get_value("beginiter",beginiter);
     arg.get_value("enditer",enditer);
@@ -364,12 +614,27 @@ int main(int argc, char * argv[])
     cout<<"== time: "<<t2-t1<<" sec\n";
 #endif
 
-    cout<<"\npreparing neighbor sets..."<<endl;
     vector<unsigned> workset;
-    if (threadnum==1)
+    oriented_csr csr;
+    if (ordered)
+    {
+        cout<<"\npreparing degree ordered csr..."<<endl;
+        t1 = timer::get_usec();
+        build_oriented(graph, threadnum, csr);
+        t2 = timer::get_usec();
+        cout<<"== "<<csr.adj.size()<<" oriented edges\n";
+#ifndef ENABLE_VERIFY
+        cout<<"== time: "<<t2-t1<<" sec\n";
+#endif
+    }
+    else if (threadnum==1)
+    {
+        cout<<"\npreparing neighbor sets..."<<endl;
         tc_init(graph);
+    }
     else
     {
+        cout<<"\npreparing neighbor sets..."<<endl;
         parallel_tc_init(graph, threadnum);
         cout<<"preparing workset..."<<endl;
         //parallel_workset_init(graph, workset, arguments.threadnum);
@@ -389,7 +654,9 @@ int main(int argc, char * argv[])
     {
         t1 = timer::get_usec();
 
-        if (threadnum==1)
+        if (ordered)
+            tcount = ordered_triangle_count(csr, threadnum, perf_multi, i);
+        else if (threadnum==1)
             tcount = triangle_count(graph, perf, i);
         else
             tcount = parallel_triangle_count(graph, threadnum, workset, perf_multi, i);
@@ -401,15 +668,19 @@ int main(int argc, char * argv[])
     cout<<"== total triangle count: "<<tcount<<endl;
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<elapse_time/run_num<<" sec\n";
-    if (threadnum == 1)
+    if (threadnum == 1 && !ordered)
         perf.print();
     else
         perf_multi.print();
 #endif
 
 #ifdef ENABLE_OUTPUT
-    cout<<endl;
-    output(graph);
+    // the ordered mode only counts the total
+    if (!ordered)
+    {
+        cout<<endl;
+        output(graph);
+    }
 #endif
     cout<<"==================================================================\n";
     return 0;
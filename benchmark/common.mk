@@ -58,12 +58,24 @@ ifeq (${STRUCTURE}, VV)
   TRAITS=-DTRAITS_VV
 endif
 
+ifeq (${STRUCTURE}, DL)
+  TRAITS=-DTRAITS_DL
+endif
+
+ifeq (${STRUCTURE}, FLAT)
+  TRAITS=-DTRAITS_FLAT
+endif
+
 ifeq (${STRUCTURE}, LLS)
   TRAITS=-DTRAITS_LL_S
 endif
 
 EXTRA_CXX_FLAGS+=${TRAITS}
 
+ifeq (${EPROP}, COLUMN)
+  EXTRA_CXX_FLAGS+=-DEPROP_COLUMN
+endif
+
 ifeq (${OUTPUT},1)
   EXTRA_CXX_FLAGS+=-DENABLE_OUTPUT
 endif
@@ -2,6 +2,7 @@
 //======= RandomGraph Construction =======//
 //
 // Usage: ./graphupdate --delete <vertex #> --dataset <dataset path>
+//                      --mode <single|batch|compare>
 
 #include "common.h"
 #include "def.h"
@@ -11,6 +12,7 @@
 using namespace std;
 
 #define SEED 111
+unsigned threadnum;
 
 class vertex_property
 {
@@ -37,6 +39,7 @@ typedef graph_t::edge_iterator      edge_iterator;
 void arg_init(argument_parser & arg)
 {
     arg.add_arg("delete","10","delete vertex #");
+    arg.add_arg("mode","single","single: delete_vertex per vertex, batch: delete_vertices, compare: vertices/s of both");
 }
 //==============================================================//
 
@@ -81,6 +84,53 @@ void graph_update(graph_t &g, vector<uint64_t> IDs)
     
 }
 
+void graph_update_batch(graph_t &g, vector<uint64_t>& IDs)
+{
+    g.delete_vertices(IDs, threadnum);
+}
+
+bool load_graph(graph_t &g, string path, string separator)
+{
+    string vfile = path + "/vertex.csv";
+    string efile = path + "/edge.csv";
+
+#ifndef EDGES_ONLY
+    if (g.load_csv_vertices(vfile, true, separator, 0) == -1)
+        return false;
+    if (g.load_csv_edges(efile, true, separator, 0, 1) == -1) 
+        return false;
+#else
+    if (g.load_csv_edges(efile, true, separator, 0, 1) == -1)
+        return false;
+#endif
+    return true;
+}
+
+// deletion rate of delete_vertex and delete_vertices
+void compare_update(string path, string separator, vector<uint64_t>& IDs)
+{
+    double t1, t2;
+
+    graph_t g1;
+    if (!load_graph(g1, path, separator)) return;
+    t1 = timer::get_usec();
+    graph_update(g1, IDs);
+    t2 = timer::get_usec();
+    double single_time = t2-t1;
+
+    graph_t g2;
+    if (!load_graph(g2, path, separator)) return;
+    t1 = timer::get_usec();
+    graph_update_batch(g2, IDs);
+    t2 = timer::get_usec();
+    double batch_time = t2-t1;
+
+    cout<<"\nvertex deletion ("<<threadnum<<" threads for batch): \n";
+    cout<<"== single: "<<IDs.size()/single_time<<" vertices/sec  time: "<<single_time<<" sec\n";
+    cout<<"== batch:  "<<IDs.size()/batch_time<<" vertices/sec  time: "<<batch_time<<" sec\n";
+    cout<<"== speedup: "<<single_time/batch_time<<"\n";
+}
+
 //==============================================================//
 
 void output(graph_t& g)
@@ -111,8 +161,17 @@ int main(int argc, char * argv[])
     arg.get_value("dataset",path);
     arg.get_value("separator",separator);
 
+    arg.get_value("threadnum",threadnum);
+
     size_t delete_num;
     arg.get_value("delete",delete_num);
+    string mode;
+    arg.get_value("mode",mode);
+    if (mode!="single" && mode!="batch" && mode!="compare")
+    {
+        arg.help();
+        return -1;
+    }
 
     srand(SEED); // fix seed to avoid runtime dynamics
     graph_t g;
@@ -121,18 +180,8 @@ int main(int argc, char * argv[])
     cout<<"loading data... \n";
 
     t1 = timer::get_usec();
-    string vfile = path + "/vertex.csv";
-    string efile = path + "/edge.csv";
-
-#ifndef EDGES_ONLY
-    if (g.load_csv_vertices(vfile, true, separator, 0) == -1)
-        return -1;
-    if (g.load_csv_edges(efile, true, separator, 0, 1) == -1) 
+    if (!load_graph(g, path, separator))
         return -1;
-#else
-    if (g.load_csv_edges(efile, true, separator, 0, 1) == -1)
-        return -1;
-#endif
 
     size_t vertex_num = g.num_vertices();
     size_t edge_num = g.num_edges();
@@ -155,7 +204,10 @@ int main(int argc, char * argv[])
     t1 = timer::get_usec();
     perf.start();
 
-    graph_update(g, IDs);
+    if (mode=="batch")
+        graph_update_batch(g, IDs);
+    else
+        graph_update(g, IDs);
 
 
     perf.stop();
@@ -165,7 +217,10 @@ int main(int argc, char * argv[])
 
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<t2-t1<<" sec\n";
+    cout<<"== throughput: "<<IDs.size()/(t2-t1)<<" vertices/sec\n";
     perf.print();
+    if (mode=="compare")
+        compare_update(path, separator, IDs);
 #else
     (void)t1;
     (void)t2;
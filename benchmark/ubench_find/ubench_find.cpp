@@ -36,10 +36,17 @@ typedef openG::extGraph<vertex_property, edge_property> graph_t;
 typedef graph_t::vertex_iterator    vertex_iterator;
 typedef graph_t::edge_iterator      edge_iterator;
 
+// vertex storage layouts used by --compare
+typedef openG::openG_configure<vertex_property, edge_property, openG::ILV_ILE> hash_list_config_t;
+typedef openG::openG_configure<vertex_property, edge_property, openG::IVV_ILE> hash_vector_config_t;
+typedef openG::openG_configure<vertex_property, edge_property, openG::DVV_ILE> dense_vector_config_t;
+
 //==============================================================//
 void arg_init(argument_parser & arg)
 {
     arg.add_arg("find","10","find vertex #");
+    arg.add_arg("compare","0","compare lookup time of hash-indexed and dense vertex storage", false);
+    arg.add_arg("repeat","1000","lookup repetitions in compare mode");
 }
 //==============================================================//
 
@@ -85,6 +92,56 @@ size_t graph_lookup(graph_t &g, vector<uint64_t> & ids)
     return found;
 }
 
+//==============================================================//
+template<class G>
+bool load_graph(G &g, string path, string separator)
+{
+    string vfile = path + "/vertex.csv";
+    string efile = path + "/edge.csv";
+
+#ifndef EDGES_ONLY
+    if (g.load_csv_vertices(vfile, true, separator, 0) == -1)
+        return false;
+#endif
+    if (g.load_csv_edges(efile, true, separator, 0, 1) == -1)
+        return false;
+    return true;
+}
+
+// average time (sec) of one find_vertex call
+template<class G>
+double lookup_time(G &g, vector<uint64_t> & ids, size_t repeat, size_t & found)
+{
+    typedef typename G::vertex_iterator vit_t;
+
+    found=0;
+    double t1 = timer::get_usec();
+    for (size_t r=0;r<repeat;r++)
+    {
+        for (size_t i=0;i<ids.size();i++)
+        {
+            vit_t vit = g.find_vertex(ids[i]);
+            if (vit != g.vertices_end()) found++;
+        }
+    }
+    double t2 = timer::get_usec();
+    found /= repeat;
+
+    return (t2-t1)/(repeat*ids.size());
+}
+
+template<class CONFIG>
+void compare_layout(string name, string path, string separator,
+                    vector<uint64_t> & ids, size_t repeat)
+{
+    openG::extGraph<vertex_property, edge_property, CONFIG> g;
+    if (load_graph(g, path, separator)==false) return;
+
+    size_t found;
+    double t = lookup_time(g, ids, repeat, found);
+    cout<<"== "<<name<<":\tfound "<<found<<"\t"<<t*1e9<<" ns/lookup\n";
+}
+
 //==============================================================//
 
 void output(graph_t& g)
@@ -115,8 +172,11 @@ int main(int argc, char * argv[])
     arg.get_value("dataset",path);
     arg.get_value("separator",separator);
 
-    size_t find_num;
+    size_t find_num, repeat;
+    bool compare;
     arg.get_value("find",find_num);
+    arg.get_value("compare",compare);
+    arg.get_value("repeat",repeat);
 
     srand(SEED); // fix seed to avoid runtime dynamics
     graph_t g;
@@ -175,6 +235,14 @@ int main(int argc, char * argv[])
     (void)t2;
 #endif
 
+    if (compare)
+    {
+        cout<<"\nvertex storage comparison ("<<repeat<<" repetitions): \n";
+        compare_layout<hash_list_config_t>("indexed_list  ", path, separator, IDs, repeat);
+        compare_layout<hash_vector_config_t>("indexed_vector", path, separator, IDs, repeat);
+        compare_layout<dense_vector_config_t>("dense_vector  ", path, separator, IDs, repeat);
+    }
+
 #ifdef ENABLE_OUTPUT
     cout<<"\n";
     output(g);
@@ -0,0 +1,275 @@
+//====== Graph Benchmark Suites ======//
+//====== Priority Queue Comparison ======//
+//
+// Runs sequential dijkstra with several priority queues
+//
+// Usage: ./ubench_pqueue --dataset <dataset path>
+//                        --root <root vertex id>
+//                        --weight <max edge weight>
+//                        --repeat <runs per queue>
+
+#include <vector>
+#include <string>
+#include <queue>
+#include "common.h"
+#include "def.h"
+#include "perf.h"
+#include "openG.h"
+#include "monotone_queue.h"
+
+using namespace std;
+
+#define MY_INFINITY 0xffffffff
+
+class vertex_property
+{
+public:
+    vertex_property():value(0){}
+    vertex_property(uint64_t x):value(x){}
+
+    uint64_t value;
+};
+class edge_property
+{
+public:
+    edge_property():value(0){}
+    edge_property(uint64_t x):value(x){}
+
+    uint64_t value;
+};
+
+typedef openG::extGraph<vertex_property, edge_property> graph_t;
+typedef graph_t::vertex_iterator    vertex_iterator;
+typedef graph_t::edge_iterator      edge_iterator;
+
+//==============================================================//
+void arg_init(argument_parser & arg)
+{
+    arg.add_arg("root","0","root/starting vertex");
+    arg.add_arg("weight","1","max edge weight. 1: unit weights of the dataset, otherwise hashed from the end points");
+    arg.add_arg("repeat","1","runs per queue");
+}
+//==============================================================//
+
+// adjacency of the graph in CSR form, so that the queue dominates
+class csr_t
+{
+public:
+    vector<uint64_t> vertexlist;
+    vector<uint64_t> edgelist;
+    vector<uint32_t> weightlist;
+};
+
+void build_csr(graph_t& g, uint64_t max_weight, csr_t& csr)
+{
+    uint64_t bound = g.vid_bound();
+    csr.vertexlist.assign(bound+1, 0);
+    for (vertex_iterator vit=g.vertices_begin();vit!=g.vertices_end();vit++)
+        csr.vertexlist[vit->id()+1] = vit->edges_size();
+    for (uint64_t i=0;i<bound;i++)
+        csr.vertexlist[i+1] += csr.vertexlist[i];
+
+    csr.edgelist.resize(csr.vertexlist[bound]);
+    csr.weightlist.resize(csr.vertexlist[bound]);
+    for (vertex_iterator vit=g.vertices_begin();vit!=g.vertices_end();vit++)
+    {
+        uint64_t pos = csr.vertexlist[vit->id()];
+        for (edge_iterator eit=vit->edges_begin();eit!=vit->edges_end();eit++,pos++)
+        {
+            csr.edgelist[pos] = eit->target();
+            csr.weightlist[pos] = (max_weight<=1) ? 1 :
+                (vit->id()*7+eit->target()*13)%max_weight+1;
+        }
+    }
+}
+
+//==============================================================//
+// std::priority_queue with the interface of the monotone queues
+template <class T>
+class std_queue
+{
+public:
+    typedef pair<uint64_t, T> entry_t;
+
+    bool empty(void){return _q.empty();}
+    void push(uint64_t key, const T& value){_q.push(entry_t(key, value));}
+    void pop(uint64_t& key, T& value)
+    {
+        key = _q.top().first;
+        value = _q.top().second;
+        _q.pop();
+    }
+protected:
+    priority_queue<entry_t, vector<entry_t>, greater<entry_t> > _q;
+};
+
+class queue_stat
+{
+public:
+    queue_stat():pushes(0),pops(0),stale(0),time(0){}
+
+    uint64_t pushes;
+    uint64_t pops;
+    uint64_t stale;     // popped entries above the vertex distance
+    double time;
+};
+
+// skip_stale false expands stale entries again, like a plain
+// priority_queue dijkstra without lazy deletion
+template <class Q>
+void dijkstra(csr_t& csr, uint64_t root, Q& q, bool skip_stale,
+        vector<uint32_t>& dist, queue_stat& stat)
+{
+    dist.assign(csr.vertexlist.size()-1, MY_INFINITY);
+    dist[root] = 0;
+    q.push(0, root);
+    stat.pushes++;
+
+    while (!q.empty())
+    {
+        uint64_t d, u;
+        q.pop(d, u);
+        stat.pops++;
+        if (d > dist[u])
+        {
+            stat.stale++;
+            if (skip_stale) continue;
+        }
+
+        for (uint64_t j=csr.vertexlist[u];j<csr.vertexlist[u+1];j++)
+        {
+            uint64_t v = csr.edgelist[j];
+            uint32_t alt = dist[u] + csr.weightlist[j];
+            if (alt < dist[v])
+            {
+                dist[v] = alt;
+                q.push(alt, v);
+                stat.pushes++;
+            }
+        }
+    }
+}
+
+template <class Q>
+void run_queue(string name, csr_t& csr, uint64_t root, Q& q, bool skip_stale,
+        size_t repeat, vector<uint32_t>& dist)
+{
+    queue_stat stat;
+    double t1 = timer::get_usec();
+    for (size_t r=0;r<repeat;r++)
+    {
+        stat = queue_stat();
+        dijkstra(csr, root, q, skip_stale, dist, stat);
+    }
+    double t2 = timer::get_usec();
+
+    cout<<"== "<<name<<":\tpushes "<<stat.pushes<<"  pops "<<stat.pops
+        <<"  stale "<<stat.stale;
+#ifndef ENABLE_VERIFY
+    cout<<"\t"<<(t2-t1)/repeat<<" sec";
+#else
+    (void)t1;
+    (void)t2;
+#endif
+    cout<<"\n";
+}
+
+//==============================================================//
+void output(vector<uint32_t>& dist)
+{
+    cout<<"Results: \n";
+    for (size_t i=0;i<dist.size();i++)
+    {
+        cout<<"== vertex "<<i<<": distance-";
+        if (dist[i] == MY_INFINITY)
+            cout<<"INF";
+        else
+            cout<<dist[i];
+        cout<<"\n";
+    }
+}
+
+//==============================================================//
+int main(int argc, char * argv[])
+{
+    graphBIG::print();
+    cout<<"Benchmark: ubench-pqueue\n";
+
+    argument_parser arg;
+    gBenchPerf_event perf;
+    arg_init(arg);
+    if (arg.parse(argc,argv,perf,false)==false)
+    {
+        arg.help();
+        return -1;
+    }
+    string path, separator;
+    arg.get_value("dataset",path);
+    arg.get_value("separator",separator);
+
+    size_t root, max_weight, repeat;
+    arg.get_value("root",root);
+    arg.get_value("weight",max_weight);
+    arg.get_value("repeat",repeat);
+    if (max_weight==0) max_weight = 1;
+    if (repeat==0) repeat = 1;
+
+    graph_t g;
+    double t1, t2;
+
+    cout<<"loading data... \n";
+
+    t1 = timer::get_usec();
+    string vfile = path + "/vertex.csv";
+    string efile = path + "/edge.csv";
+
+#ifndef EDGES_ONLY
+    if (g.load_csv_vertices(vfile, true, separator, 0) == -1)
+        return -1;
+#endif
+    if (g.load_csv_edges(efile, true, separator, 0, 1) == -1)
+        return -1;
+
+    size_t vertex_num = g.num_vertices();
+    size_t edge_num = g.num_edges();
+    t2 = timer::get_usec();
+
+    cout<<"== "<<vertex_num<<" vertices  "<<edge_num<<" edges\n";
+
+#ifndef ENABLE_VERIFY
+    cout<<"== time: "<<t2-t1<<" sec\n";
+#endif
+
+    if (g.find_vertex(root)==g.vertices_end())
+    {
+        cerr<<"wrong source vertex: "<<root<<endl;
+        return 0;
+    }
+
+    csr_t csr;
+    build_csr(g, max_weight, csr);
+
+    cout<<"\ndijkstra from "<<root<<", max weight "<<max_weight<<": \n";
+
+    vector<uint32_t> ref, dist;
+    std_queue<uint64_t> sq;
+    radix_heap<uint64_t> rq;
+    bucket_queue<uint64_t> bq(max_weight);
+
+    run_queue("priority_queue      ", csr, root, sq, false, repeat, ref);
+    run_queue("priority_queue skip ", csr, root, sq, true, repeat, dist);
+    bool agree = (dist==ref);
+    run_queue("radix_heap          ", csr, root, rq, true, repeat, dist);
+    agree = agree && (dist==ref);
+    run_queue("bucket_queue        ", csr, root, bq, true, repeat, dist);
+    agree = agree && (dist==ref);
+    cout<<"== distances "<<(agree?"agree":"DIFFER")<<"\n";
+
+#ifdef ENABLE_OUTPUT
+    cout<<"\n";
+    output(ref);
+#endif
+
+    cout<<"==================================================================\n";
+    return 0;
+}  // end main
@@ -0,0 +1,123 @@
+#ifndef _DEGREE_STAT_H
+#define _DEGREE_STAT_H
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <stdint.h>
+
+// log2 buckets: 0 holds degree 0, b>0 holds [2^(b-1), 2^b)
+#define DEGREE_BUCKETS 65
+
+//================================================================//
+// Degree statistics and top-k hubs without shared counters. Every
+// thread collects the vertices of its own range into a private
+// degree_stat and degree_topk, the caller merges them afterwards:
+//
+//      s[tid].add(d), k[tid].push(v, d)     every v of the range of tid
+//      barrier
+//      s[0].merge(s[t]), k[0].merge(k[t])   t = 1..threadnum-1
+//
+// Neither class starts threads or locks, merging is cheap since it
+// only touches DEGREE_BUCKETS counters and k entries per thread.
+//================================================================//
+
+inline unsigned degree_bucket(uint64_t d)
+{
+    return (d==0) ? 0 : 64-__builtin_clzll(d);
+}
+
+class degree_stat
+{
+public:
+    degree_stat(){clear();}
+
+    void clear(void)
+    {
+        for (unsigned b=0;b<DEGREE_BUCKETS;b++) hist[b]=0;
+        min = std::numeric_limits<uint64_t>::max();
+        max = 0;
+        sum = 0;
+        cnt = 0;
+    }
+    void add(uint64_t d)
+    {
+        hist[degree_bucket(d)]++;
+        if (d < min) min = d;
+        if (d > max) max = d;
+        sum += d;
+        cnt++;
+    }
+    void merge(const degree_stat & other)
+    {
+        for (unsigned b=0;b<DEGREE_BUCKETS;b++) hist[b] += other.hist[b];
+        if (other.min < min) min = other.min;
+        if (other.max > max) max = other.max;
+        sum += other.sum;
+        cnt += other.cnt;
+    }
+
+    uint64_t hist[DEGREE_BUCKETS];
+    uint64_t min;
+    uint64_t max;
+    uint64_t sum;
+    uint64_t cnt;
+};
+
+// the k vertices of largest degree, ties go to the smaller id.
+// kept as a min-heap, so most vertices are rejected by one compare
+// with the weakest entry
+class degree_topk
+{
+public:
+    typedef std::pair<uint64_t, uint64_t> entry_t;     // degree, vertex id
+
+    degree_topk():_k(0){}
+    degree_topk(size_t k):_k(k){_heap.reserve(k);}
+
+    void init(size_t k)
+    {
+        _k = k;
+        _heap.clear();
+        _heap.reserve(k);
+    }
+    void push(uint64_t vid, uint64_t d)
+    {
+        if (_k==0) return;
+        entry_t e(d, vid);
+        if (_heap.size() < _k)
+        {
+            _heap.push_back(e);
+            std::push_heap(_heap.begin(), _heap.end(), stronger);
+        }
+        else if (stronger(e, _heap.front()))
+        {
+            std::pop_heap(_heap.begin(), _heap.end(), stronger);
+            _heap.back() = e;
+            std::push_heap(_heap.begin(), _heap.end(), stronger);
+        }
+    }
+    void merge(const degree_topk & other)
+    {
+        for (size_t i=0;i<other._heap.size();i++)
+            push(other._heap[i].second, other._heap[i].first);
+    }
+    // strongest first
+    void sorted(std::vector<entry_t> & out) const
+    {
+        out = _heap;
+        std::sort(out.begin(), out.end(), stronger);
+    }
+
+    static bool stronger(const entry_t & a, const entry_t & b)
+    {
+        if (a.first != b.first) return a.first > b.first;
+        return a.second < b.second;
+    }
+
+protected:
+    size_t _k;
+    std::vector<entry_t> _heap;
+};
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef _FRONTIER_H
+#define _FRONTIER_H
+
+#include <vector>
+#include <stdint.h>
+
+// a level with more than 1/FRONTIER_DENSE_RATIO of the vertices is
+// built from the bitmap instead of the per thread queues
+#define FRONTIER_DENSE_RATIO 32
+
+//================================================================//
+// Active vertex set of a level-synchronous kernel.
+//
+// Worker threads read the current level with range()/operator[] and
+// push() the vertices of the next level. A push appends to a thread
+// local queue, duplicates within a level are dropped by an atomic test
+// and set on a bitmap of vertex ids. Switching to the next level takes
+// a serial plan() by one thread and a parallel build() by every thread,
+// separated by barriers of the caller (pthread or openmp):
+//
+//      while (!front.empty())
+//      {
+//          front.range(tid, begin, end);
+//          for (i=begin;i<end;i++) ... front.push(tid, vid) ...
+//          barrier
+//          if (tid==0) front.plan();
+//          barrier
+//          front.build(tid);
+//          barrier
+//      }
+//
+// A small next level is the concatenation of the thread queues. A
+// large one is collected from the bitmap in vertex id order. All
+// buffers are kept across levels.
+class frontier
+{
+public:
+    frontier():_bound(0),_size(0),_dense(false){}
+    frontier(uint64_t bound, unsigned threadnum){init(bound, threadnum);}
+
+    // vertex ids are below "bound"
+    void init(uint64_t bound, unsigned threadnum)
+    {
+        _bound = bound;
+        _size = 0;
+        _dense = false;
+        _curr.resize(bound);
+        _bitmap.assign((bound+63)/64, 0);
+        _queues.assign(threadnum, std::vector<uint64_t>());
+        _offsets.assign(threadnum+1, 0);
+    }
+
+    //========== current level ==========//
+    uint64_t size(void){return _size;}
+    bool empty(void){return _size==0;}
+    // true if the level was collected from the bitmap, sorted by id
+    bool dense(void){return _dense;}
+    uint64_t operator[](uint64_t i){return _curr[i];}
+
+    // static share [begin,end) of thread tid
+    void range(unsigned tid, uint64_t& begin, uint64_t& end)
+    {
+        unsigned threadnum = _queues.size();
+        begin = _size*tid/threadnum;
+        end = _size*(tid+1)/threadnum;
+    }
+
+    //========== next level ==========//
+    // return false if vid is already in the next level
+    bool push(unsigned tid, uint64_t vid)
+    {
+        uint64_t mask = 1ULL<<(vid&63);
+        if (_bitmap[vid>>6] & mask) return false;
+        if (__sync_fetch_and_or(&(_bitmap[vid>>6]), mask) & mask) return false;
+        _queues[tid].push_back(vid);
+        return true;
+    }
+
+    // by one thread, after all pushes of the level
+    void plan(void)
+    {
+        unsigned threadnum = _queues.size();
+        uint64_t total=0;
+        for (unsigned t=0;t<threadnum;t++)
+            total += _queues[t].size();
+        _dense = (total > _bound/FRONTIER_DENSE_RATIO);
+
+        _offsets[0] = 0;
+        for (unsigned t=0;t<threadnum;t++)
+        {
+            if (_dense)
+            {
+                uint64_t begin, end;
+                word_range(t, begin, end);
+                uint64_t cnt=0;
+                for (uint64_t w=begin;w<end;w++)
+                    cnt += __builtin_popcountll(_bitmap[w]);
+                _offsets[t+1] = _offsets[t] + cnt;
+            }
+            else
+                _offsets[t+1] = _offsets[t] + _queues[t].size();
+        }
+        _size = total;
+    }
+
+    // by every thread tid, after plan()
+    void build(unsigned tid)
+    {
+        std::vector<uint64_t> & queue = _queues[tid];
+        uint64_t pos = _offsets[tid];
+        if (_dense)
+        {
+            // words of the range are owned by this thread
+            uint64_t begin, end;
+            word_range(tid, begin, end);
+            for (uint64_t w=begin;w<end;w++)
+            {
+                uint64_t word = _bitmap[w];
+                while (word)
+                {
+                    _curr[pos++] = w*64 + __builtin_ctzll(word);
+                    word &= word-1;
+                }
+                _bitmap[w] = 0;
+            }
+        }
+        else
+        {
+            for (size_t i=0;i<queue.size();i++)
+            {
+                uint64_t vid = queue[i];
+                _curr[pos++] = vid;
+                __sync_fetch_and_and(&(_bitmap[vid>>6]), ~(1ULL<<(vid&63)));
+            }
+        }
+        queue.clear();
+    }
+
+    // serial plan() and build(), e.g. after pushing the first level
+    void advance(void)
+    {
+        plan();
+        for (unsigned t=0;t<_queues.size();t++) build(t);
+    }
+protected:
+    void word_range(unsigned tid, uint64_t& begin, uint64_t& end)
+    {
+        unsigned threadnum = _queues.size();
+        begin = _bitmap.size()*tid/threadnum;
+        end = _bitmap.size()*(tid+1)/threadnum;
+    }
+
+    uint64_t _bound;
+    uint64_t _size;
+    bool _dense;
+    std::vector<uint64_t> _curr;
+    std::vector<uint64_t> _bitmap;
+    std::vector<std::vector<uint64_t> > _queues;
+    std::vector<uint64_t> _offsets;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef _MONOTONE_QUEUE_H
+#define _MONOTONE_QUEUE_H
+
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+//================================================================//
+// Priority queues for monotone integer keys, e.g. dijkstra with
+// non-negative integer edge weights. A pushed key must not be below
+// the key popped last. Both keep entries of a key until they are
+// popped, callers skip stale ones:
+//
+//      q.push(0, root);
+//      while (!q.empty())
+//      {
+//          q.pop(d, u);
+//          if (d > dist[u]) continue;     // u was reached cheaper
+//          ... q.push(d+w, v) for every improved neighbor v ...
+//      }
+//================================================================//
+
+// radix heap. bucket i holds the keys whose highest bit differing from
+// the last popped key is bit i-1, bucket 0 the keys equal to it. an
+// entry only moves to lower buckets, so a pop is amortized O(log C)
+// for a maximum key distance C
+template <class T>
+class radix_heap
+{
+public:
+    typedef std::pair<uint64_t, T> entry_t;
+
+    radix_heap():_last(0),_size(0){}
+
+    bool empty(void){return _size==0;}
+    size_t size(void){return _size;}
+
+    void push(uint64_t key, const T& value)
+    {
+        _buckets[bucket(key)].push_back(entry_t(key, value));
+        _size++;
+    }
+
+    // remove an entry of the smallest key
+    void pop(uint64_t& key, T& value)
+    {
+        if (_buckets[0].empty())
+        {
+            unsigned i=1;
+            while (_buckets[i].empty()) i++;
+
+            // the smallest key of the first non-empty bucket becomes the
+            // last key, its entries fall apart into lower buckets
+            std::vector<entry_t> & b = _buckets[i];
+            uint64_t min=b[0].first;
+            for (size_t j=1;j<b.size();j++)
+                if (b[j].first < min) min = b[j].first;
+            _last = min;
+            for (size_t j=0;j<b.size();j++)
+                _buckets[bucket(b[j].first)].push_back(b[j]);
+            b.clear();
+        }
+        key = _buckets[0].back().first;
+        value = _buckets[0].back().second;
+        _buckets[0].pop_back();
+        _size--;
+    }
+
+    void clear(void)
+    {
+        for (unsigned i=0;i<65;i++) _buckets[i].clear();
+        _last = 0;
+        _size = 0;
+    }
+protected:
+    unsigned bucket(uint64_t key)
+    {
+        return (key==_last) ? 0 : 64-__builtin_clzll(key^_last);
+    }
+
+    std::vector<entry_t> _buckets[65];
+    uint64_t _last;
+    size_t _size;
+};
+
+// dial's bucket queue. a circular array of buckets, one per key, for
+// keys at most max_step above the last popped key (the maximum edge
+// weight). push is O(1), pops scan the empty buckets in between
+template <class T>
+class bucket_queue
+{
+public:
+    bucket_queue(uint64_t max_step=1):_last(0),_size(0){_buckets.resize(max_step+1);}
+
+    bool empty(void){return _size==0;}
+    size_t size(void){return _size;}
+
+    void push(uint64_t key, const T& value)
+    {
+        _buckets[key%_buckets.size()].push_back(value);
+        _size++;
+    }
+
+    // remove an entry of the smallest key
+    void pop(uint64_t& key, T& value)
+    {
+        while (_buckets[_last%_buckets.size()].empty()) _last++;
+
+        std::vector<T> & b = _buckets[_last%_buckets.size()];
+        key = _last;
+        value = b.back();
+        b.pop_back();
+        _size--;
+    }
+
+    void clear(void)
+    {
+        for (size_t i=0;i<_buckets.size();i++) _buckets[i].clear();
+        _last = 0;
+        _size = 0;
+    }
+protected:
+    std::vector<std::vector<T> > _buckets;
+    uint64_t _last;
+    size_t _size;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef _MSBFS_H
+#define _MSBFS_H
+
+#include <vector>
+#include <stdint.h>
+
+//================================================================//
+// Multi-source bfs (MS-BFS, Then et al. VLDB'15). Up to 64*WORDS
+// traversals run at once, one bit lane per source. Every vertex keeps
+// three lane masks: lanes that have seen it, lanes that visit it at
+// the current level and lanes that reach it at the next level. An edge
+// scan of a vertex serves all its visiting lanes at once.
+//
+// Like the frontier, the engine does not start threads. The caller
+// runs each step over all vertex ids in parallel, with a barrier
+// between the two steps:
+//
+//      ms.start(roots, n);                       lanes 0..n-1 at level 0
+//      do
+//      {
+//          ms.expand(v, adj_begin, adj_end)      every v, returns edges scanned
+//          barrier
+//          ms.settle(v, fresh)                   every v, true if fresh
+//                                                lanes reached v
+//          barrier
+//      } while (a lane reached any vertex)
+//
+// The masks of a vertex are written by expand() with an atomic or, so
+// expand() of different vertices may run concurrently. settle() only
+// touches vertex v.
+//================================================================//
+
+template <unsigned WORDS>
+class lane_mask
+{
+public:
+    uint64_t w[WORDS];
+
+    void clear(void){for (unsigned k=0;k<WORDS;k++) w[k]=0;}
+    bool empty(void) const
+    {
+        uint64_t any=0;
+        for (unsigned k=0;k<WORDS;k++) any |= w[k];
+        return any==0;
+    }
+    void set(unsigned lane){w[lane>>6] |= 1ULL<<(lane&63);}
+    unsigned count(void) const
+    {
+        unsigned cnt=0;
+        for (unsigned k=0;k<WORDS;k++) cnt += __builtin_popcountll(w[k]);
+        return cnt;
+    }
+};
+
+template <unsigned WORDS>
+class multi_source_bfs
+{
+public:
+    typedef lane_mask<WORDS> mask_t;
+    static const unsigned LANES = 64*WORDS;
+
+    multi_source_bfs():_bound(0){}
+    multi_source_bfs(uint64_t bound){init(bound);}
+
+    // vertex ids are below "bound"
+    void init(uint64_t bound)
+    {
+        _bound = bound;
+        _seen.resize(bound);
+        _visit.resize(bound);
+        _next.resize(bound);
+    }
+
+    // by one thread. lane i starts at roots[i], n <= LANES
+    void start(const uint64_t * roots, unsigned n)
+    {
+        for (uint64_t v=0;v<_bound;v++)
+        {
+            _seen[v].clear();
+            _visit[v].clear();
+            _next[v].clear();
+        }
+        for (unsigned i=0;i<n;i++)
+        {
+            _seen[roots[i]].set(i);
+            _visit[roots[i]].set(i);
+        }
+    }
+
+    // lanes visiting v at the current level
+    const mask_t & visit(uint64_t v){return _visit[v];}
+
+    // push the visiting lanes of v to its neighbors [adj_begin,adj_end)
+    template <class ITER>
+    uint64_t expand(uint64_t v, ITER adj_begin, ITER adj_end)
+    {
+        const mask_t & curr = _visit[v];
+        if (curr.empty()) return 0;
+
+        uint64_t edges=0;
+        for (ITER it=adj_begin;it!=adj_end;++it)
+        {
+            edges++;
+            mask_t & seen = _seen[*it];
+            mask_t & next = _next[*it];
+            for (unsigned k=0;k<WORDS;k++)
+            {
+                uint64_t d = curr.w[k] & ~seen.w[k] & ~next.w[k];
+                if (d) __sync_fetch_and_or(&(next.w[k]), d);
+            }
+        }
+        return edges;
+    }
+
+    // make the lanes that reached v its visiting lanes of the next
+    // level. "fresh" gets the lanes that see v for the first time
+    bool settle(uint64_t v, mask_t & fresh)
+    {
+        mask_t & seen = _seen[v];
+        mask_t & next = _next[v];
+        for (unsigned k=0;k<WORDS;k++)
+        {
+            fresh.w[k] = next.w[k] & ~seen.w[k];
+            seen.w[k] |= fresh.w[k];
+            next.w[k] = 0;
+        }
+        _visit[v] = fresh;
+        return !fresh.empty();
+    }
+
+protected:
+    uint64_t _bound;
+    std::vector<mask_t> _seen;
+    std::vector<mask_t> _visit;
+    std::vector<mask_t> _next;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef _UNION_FIND_H
+#define _UNION_FIND_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+
+// neighbors per vertex linked before the largest component is sampled
+#define UF_NEIGHBOR_ROUNDS 2
+// vertices sampled to guess the largest component
+#define UF_SAMPLES 1024
+
+//================================================================//
+// Lock-free union-find for connected components (Afforest, Sutton et
+// al. IPDPS'18). "comp" is a parent array indexed by vertex id, every
+// vertex starts as its own root. Roots are always the smallest id of
+// their tree, so the labels after uf_compress() are the smallest vertex
+// id of each component:
+//
+//      comp[v] = v                          for every v
+//      uf_link(comp, v, n_r(v))             r-th neighbor, r < UF_NEIGHBOR_ROUNDS
+//      uf_compress(comp, v)                 after every round
+//      c = uf_sample_frequent(comp, n, UF_SAMPLES)
+//      uf_link(comp, v, w)                  remaining edges of v with comp[v]!=c
+//      uf_compress(comp, v)
+//
+// Skipping the vertices of the sampled component is only safe if an
+// edge (v,w) is also visited from w, i.e. for symmetric edge lists or
+// when in edges are linked as well.
+//================================================================//
+
+// hook the root with the larger id under the other one. the
+// compare-and-swap only succeeds on a root, otherwise retry from the
+// grandparents (pointer jumping)
+inline void uf_link(uint64_t * comp, uint64_t u, uint64_t v)
+{
+    uint64_t p1 = comp[u];
+    uint64_t p2 = comp[v];
+    while (p1 != p2)
+    {
+        uint64_t high = (p1 > p2) ? p1 : p2;
+        uint64_t low = p1 + p2 - high;
+        uint64_t p_high = comp[high];
+        if (p_high == low) break;
+        if (p_high == high && __sync_bool_compare_and_swap(&(comp[high]), high, low))
+            break;
+        p1 = comp[comp[high]];
+        p2 = comp[low];
+    }
+}
+
+// point v directly to its root
+inline void uf_compress(uint64_t * comp, uint64_t v)
+{
+    while (comp[v] != comp[comp[v]])
+        comp[v] = comp[comp[v]];
+}
+
+// most frequent label among "samples" random vertices of [0,n)
+inline uint64_t uf_sample_frequent(uint64_t * comp, uint64_t n, unsigned samples)
+{
+    if (n == 0) return 0;
+
+    std::vector<uint64_t> labels(samples);
+    unsigned seed = 27491095;
+    for (unsigned i=0;i<samples;i++)
+    {
+        uint64_t r = ((uint64_t)rand_r(&seed) << 31) ^ (uint64_t)rand_r(&seed);
+        labels[i] = comp[r % n];
+    }
+
+    // samples are few, count them by sorting
+    std::sort(labels.begin(), labels.end());
+    uint64_t best = labels[0];
+    size_t best_cnt = 0, cnt = 0;
+    for (size_t i=0;i<labels.size();i++)
+    {
+        cnt = (i>0 && labels[i]==labels[i-1]) ? cnt+1 : 1;
+        if (cnt > best_cnt)
+        {
+            best_cnt = cnt;
+            best = labels[i];
+        }
+    }
+    return best;
+}
+
+#endif
@@ -62,8 +62,20 @@ ifeq (${STRUCTURE}, VV)
   TRAITS=-DTRAITS_VV
 endif
 
+ifeq (${STRUCTURE}, DL)
+  TRAITS=-DTRAITS_DL
+endif
+
+ifeq (${STRUCTURE}, FLAT)
+  TRAITS=-DTRAITS_FLAT
+endif
+
 EXTRA_CXX_FLAGS+=${TRAITS}
 
+ifeq (${EPROP}, COLUMN)
+  EXTRA_CXX_FLAGS+=-DEPROP_COLUMN
+endif
+
 ifeq (${OUTPUT}, 1)
   EXTRA_CXX_FLAGS+=-DENABLE_OUTPUT
 endif
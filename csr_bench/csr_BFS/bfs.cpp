@@ -2,8 +2,10 @@
 #include <string>
 #include <vector>
 #include <queue>
+#include <algorithm>
 #include <stdint.h>
 #include "common.h"
+#include "frontier.h"
 
 #ifdef USE_OMP
 #include "omp.h"
@@ -107,40 +109,32 @@ struct arg_t
     uint64_t vertex_cnt;
     uint64_t edge_cnt;
 
-    vector<vector<uint64_t> > * global_input_tasks_ptr;
-    vector<vector<uint64_t> > * global_output_tasks_ptr;
+    frontier * front_ptr;
     unsigned tid;
     unsigned threadnum;
-    bool * stop;
 };
 
 void* thread_work(void * t)
 {
     struct arg_t * arg = (struct arg_t *) t;
-    vector<vector<uint64_t> > & global_input_tasks = *(arg->global_input_tasks_ptr);
-    vector<vector<uint64_t> > & global_output_tasks = *(arg->global_output_tasks_ptr);
+    frontier & front = *(arg->front_ptr);
     uint64_t * vertexlist = arg->vertexlist; 
     uint64_t * edgelist = arg->edgelist; 
     uint16_t * vproplist = arg->vproplist;
     unsigned tid = arg->tid;
-    bool & stop = *(arg->stop);
-    unsigned threadnum = arg->threadnum;
 
-    vector<uint64_t> & input_tasks = global_input_tasks[tid];
 #ifdef SIM
     pthread_barrier_wait (&barrier);
     SIM_BEGIN(true);
 #endif        
-    while(!stop)
+    while(!front.empty())
     {
-        pthread_barrier_wait (&barrier);
-        // process local queue
-        stop = true;
-        
-    
-        for (unsigned i=0;i<input_tasks.size();i++)
+        // process local share of the frontier
+        uint64_t begin, end;
+        front.range(tid, begin, end);
+        for (uint64_t i=begin;i<end;i++)
         {
-            uint64_t vid=input_tasks[i];
+            uint64_t vid=front[i];
             uint16_t curr_level = vproplist[vid];
             uint32_t edge_start = vertexlist[vid];
             uint32_t edge_end = vertexlist[vid+1];
@@ -156,23 +150,14 @@ void* thread_work(void * t)
                             MY_INFINITY,curr_level+1))
 #endif
                 {
-                    global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                    front.push(tid, dest_vid);
                 }
             }
         }
         pthread_barrier_wait (&barrier);
-        input_tasks.clear();
-        for (unsigned i=0;i<threadnum;i++)
-        {
-            if (global_output_tasks[i*threadnum+tid].size()!=0)
-            {
-                stop = false;
-                input_tasks.insert(input_tasks.end(),
-                        global_output_tasks[i*threadnum+tid].begin(),
-                        global_output_tasks[i*threadnum+tid].end());
-                global_output_tasks[i*threadnum+tid].clear();
-            }
-        }
+        if (tid==0) front.plan();
+        pthread_barrier_wait (&barrier);
+        front.build(tid);
         pthread_barrier_wait (&barrier);
 
     }
@@ -203,10 +188,9 @@ void parallel_BFS(
     }
     vproplist[root] = 0;
 
-    vector<vector<uint64_t> > global_input_tasks(threadnum);
-    global_input_tasks[vertex_distributor(root,threadnum)].push_back(root);
-    
-    vector<vector<uint64_t> > global_output_tasks(threadnum*threadnum);
+    frontier front(vertex_cnt, threadnum);
+    front.push(0, root);
+    front.advance();
     t2 = timer::get_usec();
 #ifndef ENABLE_VERIFY
     cout<<"== initialization time: "<<t2-t1<<" sec\n";
@@ -216,7 +200,6 @@ void parallel_BFS(
 #endif
     t1 = timer::get_usec();
     
-    bool stop = false;
 #ifndef USE_OMP
     pthread_barrier_init (&barrier, NULL, threadnum);
 
@@ -234,11 +217,9 @@ void parallel_BFS(
         args[t].vertex_cnt = vertex_cnt;
         args[t].edge_cnt = edge_cnt;
 
-        args[t].global_input_tasks_ptr = &global_input_tasks;
-        args[t].global_output_tasks_ptr = &global_output_tasks;
+        args[t].front_ptr = &front;
     
         args[t].tid = t;
-        args[t].stop = &stop;
         args[t].threadnum = threadnum;
     }
 
@@ -267,23 +248,20 @@ void parallel_BFS(
     }
         
 #else    
-    #pragma omp parallel num_threads(threadnum) shared(stop,global_input_tasks,global_output_tasks) 
+    #pragma omp parallel num_threads(threadnum) shared(front) 
     {
         unsigned tid = omp_get_thread_num();
-        vector<uint64_t> & input_tasks = global_input_tasks[tid];
 #ifdef SIM
         SIM_BEGIN(true);
 #endif        
-        while(!stop)
+        while(!front.empty())
         {
-            #pragma omp barrier
-            // process local queue
-            stop = true;
-            
-        
-            for (unsigned i=0;i<input_tasks.size();i++)
+            // process local share of the frontier
+            uint64_t begin, end;
+            front.range(tid, begin, end);
+            for (uint64_t i=begin;i<end;i++)
             {
-                uint64_t vid=input_tasks[i];
+                uint64_t vid=front[i];
                 uint16_t curr_level = vproplist[vid];
                 uint32_t edge_start = vertexlist[vid];
                 uint32_t edge_end = vertexlist[vid+1];
@@ -299,34 +277,396 @@ void parallel_BFS(
                                 MY_INFINITY,curr_level+1))
 #endif
                     {
-                        global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                        front.push(tid, dest_vid);
                     }
                 }
             }
             #pragma omp barrier
-            input_tasks.clear();
-            for (unsigned i=0;i<threadnum;i++)
+            #pragma omp master
+            front.plan();
+            #pragma omp barrier
+            front.build(tid);
+            #pragma omp barrier
+
+        }
+#ifdef SIM
+        SIM_END(true);
+#endif
+    }
+#endif
+    t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+    cout<<"== traversal time: "<<t2-t1<<" sec\n";
+#endif
+}
+
+
+//==============================================================//
+// direction-optimizing BFS. a top-down step pushes from a sparse queue
+// of frontier vertices. a bottom-up step lets every unvisited vertex
+// scan its in edges (reverse CSR) for a parent in a frontier bitmap,
+// and stops at the first one found.
+
+// go bottom-up when the frontier's edges exceed 1/DO_ALPHA of the
+// unexplored edges, back to top-down when the frontier drops below
+// 1/DO_BETA of the vertices
+#define DO_ALPHA 15
+#define DO_BETA 18
+#define DO_CHUNK 64
+
+struct level_stat_t
+{
+    bool bottomup;
+    uint64_t frontier;  // # of vertices visited at this level
+    uint64_t edges;     // # of edges inspected
+    double time;
+};
+
+struct hybrid_t
+{
+    uint64_t * vertexlist; 
+    uint64_t * edgelist; 
+    uint64_t * rvertexlist;
+    uint64_t * redgelist;
+    uint16_t * vproplist;
+    uint64_t vertex_cnt;
+    uint64_t edge_cnt;
+    unsigned threadnum;
+    bool hybrid;
+
+    vector<uint64_t> curr_bm;
+    vector<uint64_t> next_bm;
+    vector<uint64_t> queue;
+    vector<vector<uint64_t> > next_queues;
+    vector<uint64_t> edges, nf, mf;     // per thread counters
+    vector<level_stat_t> stats;
+
+    uint64_t cursor;                    // next chunk of the current step
+    uint64_t prev_nf, curr_nf, curr_mf, mu;
+    uint16_t level;
+    bool bottomup;
+    bool stop;
+    double t1;
+};
+
+struct hybrid_arg_t
+{
+    hybrid_t * h;
+    unsigned tid;
+};
+
+inline bool bitmap_test(uint64_t * bm, uint64_t vid)
+{
+    return (bm[vid>>6] & (1ULL<<(vid&63))) != 0;
+}
+
+void top_down_step(hybrid_t & h, unsigned tid)
+{
+    vector<uint64_t> & next = h.next_queues[tid];
+    uint64_t * vertexlist = h.vertexlist;
+    uint64_t * edgelist = h.edgelist;
+    uint16_t * vproplist = h.vproplist;
+    uint16_t next_level = h.level+1;
+    uint64_t edges=0, mf=0;
+
+    uint64_t begin;
+    while ((begin=__sync_fetch_and_add(&(h.cursor), DO_CHUNK)) < h.queue.size())
+    {
+        uint64_t end = min(begin+DO_CHUNK, (uint64_t)h.queue.size());
+        for (uint64_t i=begin;i<end;i++)
+        {
+            uint64_t vid = h.queue[i];
+            for (uint64_t j=vertexlist[vid];j<vertexlist[vid+1];j++)
             {
-                if (global_output_tasks[i*threadnum+tid].size()!=0)
+                edges++;
+                uint64_t dest_vid = edgelist[j];
+                if (vproplist[dest_vid]==MY_INFINITY &&
+#ifdef HMC
+                    HMC_CAS_equal_16B(&(vproplist[dest_vid]),
+                            MY_INFINITY,next_level) == MY_INFINITY)
+#else
+                    __sync_bool_compare_and_swap(&(vproplist[dest_vid]), 
+                            MY_INFINITY,next_level))
+#endif
                 {
-                    stop = false;
-                    input_tasks.insert(input_tasks.end(),
-                            global_output_tasks[i*threadnum+tid].begin(),
-                            global_output_tasks[i*threadnum+tid].end());
-                    global_output_tasks[i*threadnum+tid].clear();
+                    next.push_back(dest_vid);
+                    mf += vertexlist[dest_vid+1]-vertexlist[dest_vid];
                 }
             }
-            #pragma omp barrier
+        }
+    }
+    h.edges[tid] = edges;
+    h.nf[tid] = next.size();
+    h.mf[tid] = mf;
+}
 
+// a word of the next bitmap is owned by one thread, no atomics needed
+void bottom_up_step(hybrid_t & h, unsigned tid)
+{
+    vector<uint64_t> & next = h.next_queues[tid];
+    uint64_t * vertexlist = h.vertexlist;
+    uint64_t * rvertexlist = h.rvertexlist;
+    uint64_t * redgelist = h.redgelist;
+    uint16_t * vproplist = h.vproplist;
+    uint64_t * curr_bm = &(h.curr_bm[0]);
+    uint64_t words = h.curr_bm.size();
+    uint16_t next_level = h.level+1;
+    uint64_t edges=0, mf=0;
+
+    uint64_t begin;
+    while ((begin=__sync_fetch_and_add(&(h.cursor), DO_CHUNK)) < words)
+    {
+        uint64_t end = min(begin+DO_CHUNK, words);
+        for (uint64_t w=begin;w<end;w++)
+        {
+            uint64_t word=0;
+            uint64_t vend = min(w*64+64, h.vertex_cnt);
+            for (uint64_t vid=w*64;vid<vend;vid++)
+            {
+                if (vproplist[vid]!=MY_INFINITY) continue;
+                for (uint64_t j=rvertexlist[vid];j<rvertexlist[vid+1];j++)
+                {
+                    edges++;
+                    if (bitmap_test(curr_bm, redgelist[j]))
+                    {
+                        vproplist[vid] = next_level;
+                        word |= 1ULL<<(vid&63);
+                        next.push_back(vid);
+                        mf += vertexlist[vid+1]-vertexlist[vid];
+                        break;
+                    }
+                }
+            }
+            h.next_bm[w] = word;
         }
+    }
+    h.edges[tid] = edges;
+    h.nf[tid] = next.size();
+    h.mf[tid] = mf;
+}
+
+// executed by thread 0 between the steps. record the level and pick
+// the direction of the next one
+void finish_level(hybrid_t & h)
+{
+    level_stat_t stat;
+    stat.bottomup = h.bottomup;
+    stat.frontier = h.curr_nf;
+    stat.edges = 0;
+    uint64_t nf=0, mf=0;
+    for (unsigned t=0;t<h.threadnum;t++)
+    {
+        stat.edges += h.edges[t];
+        nf += h.nf[t];
+        mf += h.mf[t];
+    }
+    double t2 = timer::get_usec();
+    stat.time = t2-h.t1;
+    h.t1 = t2;
+    h.stats.push_back(stat);
+
+    if (h.bottomup) h.curr_bm.swap(h.next_bm);
+    h.prev_nf = h.curr_nf;
+    h.curr_nf = nf;
+    h.curr_mf = mf;
+    h.mu = (h.mu > mf) ? h.mu-mf : 0;
+    h.level++;
+    h.stop = (nf==0);
+    h.cursor = 0;
+
+    h.queue.clear();
+    if (h.hybrid)
+    {
+        if (!h.bottomup && h.curr_mf > h.mu/DO_ALPHA) 
+            h.bottomup = true;
+        else if (h.bottomup && h.curr_nf < h.prev_nf && h.curr_nf < h.vertex_cnt/DO_BETA)
+            h.bottomup = false;
+    }
+    if (!h.bottomup) h.queue.resize(nf);
+}
+
+void* hybrid_work(void * t)
+{
+    struct hybrid_arg_t * arg = (struct hybrid_arg_t *) t;
+    hybrid_t & h = *(arg->h);
+    unsigned tid = arg->tid;
+
+    pthread_barrier_wait (&barrier);
 #ifdef SIM
-        SIM_END(true);
+    SIM_BEGIN(true);
+#endif        
+    while(true)
+    {
+        bool bottomup = h.bottomup;
+        if (bottomup)
+            bottom_up_step(h, tid);
+        else
+            top_down_step(h, tid);
+        pthread_barrier_wait (&barrier);
+        if (tid==0) finish_level(h);
+        pthread_barrier_wait (&barrier);
+        if (h.stop) break;
+
+        // build the next frontier from the per thread queues
+        vector<uint64_t> & next = h.next_queues[tid];
+        if (!h.bottomup)
+        {
+            uint64_t offset=0;
+            for (unsigned i=0;i<tid;i++) offset += h.nf[i];
+            std::copy(next.begin(), next.end(), h.queue.begin()+offset);
+        }
+        else if (!bottomup)
+        {
+            uint64_t words = h.curr_bm.size();
+            uint64_t begin = words*tid/h.threadnum;
+            uint64_t end = words*(tid+1)/h.threadnum;
+            std::fill(h.curr_bm.begin()+begin, h.curr_bm.begin()+end, 0);
+            pthread_barrier_wait (&barrier);
+            for (size_t i=0;i<next.size();i++)
+                __sync_fetch_and_or(&(h.curr_bm[next[i]>>6]), 1ULL<<(next[i]&63));
+        }
+        next.clear();
+        pthread_barrier_wait (&barrier);
+    }
+#ifdef SIM
+    SIM_END(true);
+#endif    
+    return NULL;
+}
+
+// in edges of every vertex, by counting sort of the edge list
+void reverse_CSR(uint64_t * vertexlist, uint64_t * edgelist, uint64_t vertex_cnt,
+        vector<uint64_t> & rvertexlist, vector<uint64_t> & redgelist)
+{
+    rvertexlist.assign(vertex_cnt+1, 0);
+    redgelist.resize(vertexlist[vertex_cnt]);
+    for (uint64_t j=0;j<vertexlist[vertex_cnt];j++)
+        rvertexlist[edgelist[j]+1]++;
+    for (uint64_t i=0;i<vertex_cnt;i++)
+        rvertexlist[i+1] += rvertexlist[i];
+
+    vector<uint64_t> pos(rvertexlist.begin(), rvertexlist.end()-1);
+    for (uint64_t vid=0;vid<vertex_cnt;vid++)
+    {
+        for (uint64_t j=vertexlist[vid];j<vertexlist[vid+1];j++)
+            redgelist[pos[edgelist[j]]++] = vid;
+    }
+}
+
+void hybrid_BFS(
+        uint64_t * vertexlist, 
+        uint64_t * edgelist, uint16_t * vproplist,
+        uint64_t vertex_cnt, uint64_t edge_cnt,
+        uint64_t root, unsigned threadnum, bool hybrid)
+{
+    double t1, t2;
+    
+    t1 = timer::get_usec();
+
+    // initializzation
+    for (unsigned i=0; i<vertex_cnt; i++)
+    {
+        vproplist[i] = MY_INFINITY;
+    }
+    vproplist[root] = 0;
+
+    vector<uint64_t> rvertexlist, redgelist;
+    reverse_CSR(vertexlist, edgelist, vertex_cnt, rvertexlist, redgelist);
+
+    hybrid_t h;
+    h.vertexlist = vertexlist;
+    h.edgelist = edgelist;
+    h.rvertexlist = &(rvertexlist[0]);
+    h.redgelist = redgelist.empty() ? NULL : &(redgelist[0]);
+    h.vproplist = vproplist;
+    h.vertex_cnt = vertex_cnt;
+    h.edge_cnt = edge_cnt;
+    h.threadnum = threadnum;
+    h.hybrid = hybrid;
+
+    uint64_t words = (vertex_cnt+63)/64;
+    h.curr_bm.assign(words, 0);
+    h.next_bm.assign(words, 0);
+    h.curr_bm[root>>6] |= 1ULL<<(root&63);
+    h.queue.push_back(root);
+    h.next_queues.resize(threadnum);
+    h.edges.assign(threadnum, 0);
+    h.nf.assign(threadnum, 0);
+    h.mf.assign(threadnum, 0);
+
+    h.cursor = 0;
+    h.prev_nf = 0;
+    h.curr_nf = 1;
+    h.curr_mf = vertexlist[root+1]-vertexlist[root];
+    h.mu = vertexlist[vertex_cnt] - h.curr_mf;
+    h.level = 0;
+    h.bottomup = !hybrid || (h.curr_mf > h.mu/DO_ALPHA);
+    h.stop = false;
+
+    t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+    cout<<"== initialization time: "<<t2-t1<<" sec\n";
+#else
+    (void)t1;
+    (void)t2;
 #endif
+    t1 = timer::get_usec();
+    h.t1 = t1;
+
+    pthread_barrier_init (&barrier, NULL, threadnum);
+    struct hybrid_arg_t args[threadnum];
+    for (unsigned t=0;t<threadnum;t++)
+    {
+        args[t].h = &h;
+        args[t].tid = t;
+    }
+#ifndef USE_OMP
+    pthread_t thread[threadnum];
+    pthread_attr_t attr; 
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+    for(unsigned t=1; t<threadnum; t++) 
+    {
+        int rc = pthread_create(&thread[t], &attr, hybrid_work, (&(args[t]))); 
+        if (rc) 
+        {
+            printf("ERROR; return code from pthread_create() is %d\n", rc);
+            exit(-1);
+        }
+    }
+
+    hybrid_work((void*) &(args[0]));
+
+    pthread_attr_destroy(&attr);
+    for(unsigned t=1; t<threadnum; t++) 
+    {
+        void* status;
+        int rc = pthread_join(thread[t], &status);
+        if (rc) 
+        {
+            printf("ERROR; return code from pthread_join() is %d\n", rc);
+            exit(-1);
+        }
+    }
+#else
+    #pragma omp parallel num_threads(threadnum)
+    {
+        hybrid_work((void*) &(args[omp_get_thread_num()]));
     }
 #endif
+    pthread_barrier_destroy (&barrier);
     t2 = timer::get_usec();
 #ifndef ENABLE_VERIFY
     cout<<"== traversal time: "<<t2-t1<<" sec\n";
+    uint64_t total=0;
+    for (size_t i=0;i<h.stats.size();i++)
+    {
+        cout<<"== level "<<i<<": "<<(h.stats[i].bottomup?"bottom-up":"top-down ")
+            <<"  frontier "<<h.stats[i].frontier<<"  edges "<<h.stats[i].edges
+            <<"  time "<<h.stats[i].time<<" sec\n";
+        total += h.stats[i].edges;
+    }
+    cout<<"== edges inspected: "<<total<<"\n";
 #endif
 }
-
@@ -20,6 +20,11 @@ extern void parallel_BFS(
         uint64_t * edgelist, uint16_t * vproplist,
         uint64_t vertex_cnt, uint64_t edge_cnt,
         uint64_t root, unsigned threadnum);
+extern void hybrid_BFS(
+        uint64_t * vertexlist,  
+        uint64_t * edgelist, uint16_t * vproplist,
+        uint64_t vertex_cnt, uint64_t edge_cnt,
+        uint64_t root, unsigned threadnum, bool hybrid);
 
 
 class vertex_property
@@ -47,6 +52,7 @@ typedef graph_t::edge_iterator      edge_iterator;
 void arg_init(argument_parser & arg)
 {
     arg.add_arg("root","0","root/starting vertex");
+    arg.add_arg("mode","topdown","topdown: push only, bottomup: pull from unvisited vertices, hybrid: direction-optimizing");
 }
 //==============================================================//
 
@@ -90,6 +96,13 @@ int main(int argc, char * argv[])
     size_t root,threadnum;
     arg.get_value("root",root);
     arg.get_value("threadnum",threadnum);
+    string mode;
+    arg.get_value("mode",mode);
+    if (mode!="topdown" && mode!="bottomup" && mode!="hybrid")
+    {
+        arg.help();
+        return -1;
+    }
     
     double t1, t2;
     
@@ -127,7 +140,12 @@ int main(int argc, char * argv[])
     perf.start();
 #endif
     //================================================//
-    if (threadnum==1)
+    if (mode!="topdown")
+        hybrid_BFS(&(vertexlist[0]), 
+            &(edgelist[0]), &(vproplist[0]), 
+            vertexlist.size()-1, edgelist.size(), 
+            root, threadnum, mode=="hybrid");
+    else if (threadnum==1)
         seq_BFS(&(vertexlist[0]), 
             &(edgelist[0]), &(vproplist[0]), 
             vertexlist.size()-1, edgelist.size(), 
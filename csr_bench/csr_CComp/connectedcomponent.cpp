@@ -4,6 +4,8 @@
 #include <queue>
 #include <stdint.h>
 #include "common.h"
+#include "frontier.h"
+#include "union_find.h"
 
 #ifdef USE_OMP
 #include "omp.h"
@@ -24,7 +26,7 @@ using namespace std;
 
 pthread_barrier_t   barrier;
 
-unsigned global_label = 0;
+uint64_t global_label = 0;
 
 inline unsigned vertex_distributor(uint64_t vid, unsigned threadnum)
 {
@@ -33,7 +35,7 @@ inline unsigned vertex_distributor(uint64_t vid, unsigned threadnum)
 
 unsigned seq_CC(
         uint64_t * vertexlist, 
-        uint64_t * edgelist, uint16_t * vproplist, uint16_t * labellist,
+        uint64_t * edgelist, uint16_t * vproplist, uint64_t * labellist,
         uint64_t vertex_cnt, uint64_t edge_cnt)
 {
     double t1, t2;
@@ -70,7 +72,7 @@ unsigned seq_CC(
         ret++;
         root = i;
         vertex_queue.push(root);
-        unsigned label = global_label; global_label++;
+        uint64_t label = global_label; global_label++;
        
         while(!vertex_queue.empty())
         {
@@ -88,7 +90,7 @@ unsigned seq_CC(
                 if (HMC_CAS_equal_16B(&(vproplist[dest_vid]),
                     MY_INFINITY,curr_level+1) == MY_INFINITY)
                 {
-                    HMC_CAS_equal_16B(&(labellist[dest_vid]),MY_INFINITY,label);
+                    labellist[dest_vid] = label;
 #else
                 if (vproplist[dest_vid]==MY_INFINITY)
                 {
@@ -115,15 +117,13 @@ struct arg_t
     uint64_t * vertexlist; 
     uint64_t * edgelist; 
     uint16_t * vproplist;
-    uint16_t * labellist;
+    uint64_t * labellist;
     uint64_t vertex_cnt;
     uint64_t edge_cnt;
 
-    vector<vector<uint64_t> > * global_input_tasks_ptr;
-    vector<vector<uint64_t> > * global_output_tasks_ptr;
+    frontier * front_ptr;
     unsigned tid;
     unsigned threadnum;
-    bool * stop;
     uint64_t * root;
     unsigned * ret;
 };
@@ -131,19 +131,15 @@ struct arg_t
 void* thread_work(void * t)
 {
     struct arg_t * arg = (struct arg_t *) t;
-    vector<vector<uint64_t> > & global_input_tasks = *(arg->global_input_tasks_ptr);
-    vector<vector<uint64_t> > & global_output_tasks = *(arg->global_output_tasks_ptr);
+    frontier & front = *(arg->front_ptr);
     uint64_t * vertexlist = arg->vertexlist; 
     uint64_t * edgelist = arg->edgelist; 
     uint16_t * vproplist = arg->vproplist;
-    uint16_t * labellist = arg->labellist;
+    uint64_t * labellist = arg->labellist;
     unsigned tid = arg->tid;
-    bool & stop = *(arg->stop);
-    unsigned threadnum = arg->threadnum;
     uint64_t & root = *(arg->root);
     unsigned & ret = *(arg->ret);
 
-    vector<uint64_t> & input_tasks = global_input_tasks[tid];
 #ifdef SIM
     pthread_barrier_wait (&barrier);
     SIM_BEGIN(true);
@@ -154,21 +150,19 @@ void* thread_work(void * t)
         {
             vproplist[root] = 0;
             labellist[root] = global_label;
-            global_input_tasks[vertex_distributor(root, threadnum)].push_back(root);
-            stop = false;
+            front.push(0, root);
+            front.advance();
         }
         pthread_barrier_wait (&barrier);
 
-        while(!stop)
+        while(!front.empty())
         {
-            pthread_barrier_wait (&barrier);
-            // process local queue
-            stop = true;
-            
-        
-            for (unsigned i=0;i<input_tasks.size();i++)
+            // process local share of the frontier
+            uint64_t begin, end;
+            front.range(tid, begin, end);
+            for (uint64_t i=begin;i<end;i++)
             {
-                uint64_t vid=input_tasks[i];
+                uint64_t vid=front[i];
                 uint16_t curr_level = vproplist[vid];
                 uint32_t edge_start = vertexlist[vid];
                 uint32_t edge_end = vertexlist[vid+1];
@@ -180,30 +174,21 @@ void* thread_work(void * t)
                     if (HMC_CAS_equal_16B(&(vproplist[dest_vid]),
                                 MY_INFINITY,curr_level+1) == MY_INFINITY)
                     {
-                        HMC_CAS_equal_16B(&(labellist[dest_vid]), MY_INFINITY, global_label);
+                        labellist[dest_vid] = global_label;
 #else
                     if (__sync_bool_compare_and_swap(&(vproplist[dest_vid]), 
                                 MY_INFINITY,curr_level+1))
                     {
                         labellist[dest_vid] = global_label;
 #endif
-                        global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                        front.push(tid, dest_vid);
                     }
                 }
             }
             pthread_barrier_wait (&barrier);
-            input_tasks.clear();
-            for (unsigned i=0;i<threadnum;i++)
-            {
-                if (global_output_tasks[i*threadnum+tid].size()!=0)
-                {
-                    stop = false;
-                    input_tasks.insert(input_tasks.end(),
-                            global_output_tasks[i*threadnum+tid].begin(),
-                            global_output_tasks[i*threadnum+tid].end());
-                    global_output_tasks[i*threadnum+tid].clear();
-                }
-            }
+            if (tid==0) front.plan();
+            pthread_barrier_wait (&barrier);
+            front.build(tid);
             pthread_barrier_wait (&barrier);
 
         }
@@ -231,7 +216,7 @@ void* thread_work(void * t)
 unsigned parallel_CC(
         uint64_t * vertexlist, 
         uint64_t * edgelist, uint16_t * vproplist,
-        uint16_t * labellist,
+        uint64_t * labellist,
         uint64_t vertex_cnt, uint64_t edge_cnt,
         unsigned threadnum)
 {
@@ -248,8 +233,7 @@ unsigned parallel_CC(
     uint64_t root = 0;
     unsigned ret = 0;
 
-    vector<vector<uint64_t> > global_input_tasks(threadnum);
-    vector<vector<uint64_t> > global_output_tasks(threadnum*threadnum);
+    frontier front(vertex_cnt, threadnum);
     t2 = timer::get_usec();
 #ifndef ENABLE_VERIFY
     cout<<"== initialization time: "<<t2-t1<<" sec\n";
@@ -259,7 +243,6 @@ unsigned parallel_CC(
 #endif
     t1 = timer::get_usec();
     
-    bool stop = false;
 #ifndef USE_OMP
     pthread_barrier_init (&barrier, NULL, threadnum);
 
@@ -278,11 +261,9 @@ unsigned parallel_CC(
         args[t].vertex_cnt = vertex_cnt;
         args[t].edge_cnt = edge_cnt;
 
-        args[t].global_input_tasks_ptr = &global_input_tasks;
-        args[t].global_output_tasks_ptr = &global_output_tasks;
+        args[t].front_ptr = &front;
     
         args[t].tid = t;
-        args[t].stop = &stop;
         args[t].root = &root;
         args[t].ret= &ret;
         args[t].threadnum = threadnum;
@@ -312,31 +293,29 @@ unsigned parallel_CC(
         }
     }
 #else    
-    #pragma omp parallel num_threads(threadnum) shared(stop,global_input_tasks,global_output_tasks) 
+    #pragma omp parallel num_threads(threadnum) shared(front) 
     {
         unsigned tid = omp_get_thread_num();
-        vector<uint64_t> & input_tasks = global_input_tasks[tid];
         
         while(root < vertex_cnt)
         {
             if (tid == 0)
             {
                 vproplist[root] = 0;
-                labellist[root] = root;
-                global_input_tasks[vertex_distributor(root, threadnum)].push_back(root);
+                labellist[root] = global_label;
+                front.push(0, root);
+                front.advance();
             }
+            #pragma omp barrier
 
-
-            while(!stop)
+            while(!front.empty())
             {
-                #pragma omp barrier
-                // process local queue
-                stop = true;
-                
-            
-                for (unsigned i=0;i<input_tasks.size();i++)
+                // process local share of the frontier
+                uint64_t begin, end;
+                front.range(tid, begin, end);
+                for (uint64_t i=begin;i<end;i++)
                 {
-                    uint64_t vid=input_tasks[i];
+                    uint64_t vid=front[i];
                     uint16_t curr_level = vproplist[vid];
                     uint32_t edge_start = vertexlist[vid];
                     uint32_t edge_end = vertexlist[vid+1];
@@ -346,29 +325,24 @@ unsigned parallel_CC(
                         uint64_t dest_vid = edgelist[j];
 #ifdef HMC
                         if (HMC_CAS_equal_16B(&(vproplist[dest_vid]),
-                                    MY_INFINITY,curr_level+1) == (curr_level+1))
+                                    MY_INFINITY,curr_level+1) == MY_INFINITY)
+                        {
+                            labellist[dest_vid] = global_label;
 #else
                         if (__sync_bool_compare_and_swap(&(vproplist[dest_vid]), 
                                     MY_INFINITY,curr_level+1))
-#endif
                         {
-                            global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                            labellist[dest_vid] = global_label;
+#endif
+                            front.push(tid, dest_vid);
                         }
                     }
                 }
                 #pragma omp barrier
-                input_tasks.clear();
-                for (unsigned i=0;i<threadnum;i++)
-                {
-                    if (global_output_tasks[i*threadnum+tid].size()!=0)
-                    {
-                        stop = false;
-                        input_tasks.insert(input_tasks.end(),
-                                global_output_tasks[i*threadnum+tid].begin(),
-                                global_output_tasks[i*threadnum+tid].end());
-                        global_output_tasks[i*threadnum+tid].clear();
-                    }
-                }
+                #pragma omp master
+                front.plan();
+                #pragma omp barrier
+                front.build(tid);
                 #pragma omp barrier
 
             }
@@ -380,9 +354,9 @@ unsigned parallel_CC(
                 {
                     if (vproplist[root]==MY_INFINITY) break;
                 }
-                stop = false;
+                global_label++;
             }
-            pthread_barrier_wait (&barrier);
+            #pragma omp barrier
         }
     }
 #endif
@@ -393,3 +367,153 @@ unsigned parallel_CC(
     return ret;
 }
 
+
+//==============================================================//
+// lock-free union-find with neighbor sampling. the csr graph has no in
+// edges, so the last phase links all remaining edges instead of
+// skipping the largest component. labels are the smallest vertex id of
+// each component
+
+struct uf_t
+{
+    uint64_t * vertexlist; 
+    uint64_t * edgelist; 
+    uint64_t * labellist;
+    uint64_t vertex_cnt;
+    unsigned threadnum;
+
+    vector<uint64_t> roots;         // per thread: # of component roots
+};
+
+struct uf_arg_t
+{
+    uf_t * u;
+    unsigned tid;
+};
+
+void* uf_work(void * t)
+{
+    struct uf_arg_t * arg = (struct uf_arg_t *) t;
+    uf_t & u = *(arg->u);
+    unsigned tid = arg->tid;
+    uint64_t * comp = u.labellist;
+
+    // static share of the vertices
+    uint64_t begin = u.vertex_cnt*tid/u.threadnum;
+    uint64_t end = u.vertex_cnt*(tid+1)/u.threadnum;
+
+    for (uint64_t vid=begin;vid<end;vid++)
+        comp[vid] = vid;
+    pthread_barrier_wait (&barrier);
+#ifdef SIM
+    SIM_BEGIN(true);
+#endif       
+    // link the r-th neighbor of every vertex
+    for (unsigned r=0;r<UF_NEIGHBOR_ROUNDS;r++)
+    {
+        for (uint64_t vid=begin;vid<end;vid++)
+        {
+            if (u.vertexlist[vid]+r < u.vertexlist[vid+1])
+                uf_link(comp, vid, u.edgelist[u.vertexlist[vid]+r]);
+        }
+        pthread_barrier_wait (&barrier);
+        for (uint64_t vid=begin;vid<end;vid++)
+            uf_compress(comp, vid);
+        pthread_barrier_wait (&barrier);
+    }
+
+    for (uint64_t vid=begin;vid<end;vid++)
+    {
+        for (uint64_t j=u.vertexlist[vid]+UF_NEIGHBOR_ROUNDS;j<u.vertexlist[vid+1];j++)
+            uf_link(comp, vid, u.edgelist[j]);
+    }
+    pthread_barrier_wait (&barrier);
+    uint64_t roots = 0;
+    for (uint64_t vid=begin;vid<end;vid++)
+    {
+        uf_compress(comp, vid);
+        if (comp[vid] == vid) roots++;
+    }
+    u.roots[tid] = roots;
+#ifdef SIM
+    SIM_END(true);
+#endif    
+
+    return NULL;
+}
+
+unsigned UF_CC(
+        uint64_t * vertexlist, 
+        uint64_t * edgelist,
+        uint64_t * labellist,
+        uint64_t vertex_cnt, uint64_t edge_cnt,
+        unsigned threadnum)
+{
+    double t1, t2;
+    
+    t1 = timer::get_usec();
+
+    uf_t u;
+    u.vertexlist = vertexlist;
+    u.edgelist = edgelist;
+    u.labellist = labellist;
+    u.vertex_cnt = vertex_cnt;
+    u.threadnum = threadnum;
+    u.roots.assign(threadnum, 0);
+
+    pthread_barrier_init (&barrier, NULL, threadnum);
+    struct uf_arg_t args[threadnum];
+    for (unsigned t=0;t<threadnum;t++)
+    {
+        args[t].u = &u;
+        args[t].tid = t;
+    }
+#ifndef USE_OMP
+    pthread_t thread[threadnum];
+    pthread_attr_t attr; 
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+    for(unsigned t=1; t<threadnum; t++) 
+    {
+        int rc = pthread_create(&thread[t], &attr, uf_work, (&(args[t]))); 
+        if (rc) 
+        {
+            printf("ERROR; return code from pthread_create() is %d\n", rc);
+            exit(-1);
+        }
+    }
+
+    uf_work((void*) &(args[0]));
+
+    pthread_attr_destroy(&attr);
+    for(unsigned t=1; t<threadnum; t++) 
+    {
+        void* status;
+        int rc = pthread_join(thread[t], &status);
+        if (rc) 
+        {
+            printf("ERROR; return code from pthread_join() is %d\n", rc);
+            exit(-1);
+        }
+    }
+#else
+    #pragma omp parallel num_threads(threadnum)
+    {
+        uf_work((void*) &(args[omp_get_thread_num()]));
+    }
+#endif
+    pthread_barrier_destroy (&barrier);
+
+    unsigned ret = 0;
+    for (unsigned t=0;t<threadnum;t++)
+        ret += u.roots[t];
+    t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+    cout<<"== union-find time: "<<t2-t1<<" sec\n";
+#else
+    (void)t1;
+    (void)t2;
+#endif
+    return ret;
+}
@@ -13,12 +13,18 @@ using namespace std;
 extern unsigned seq_CC(
         uint64_t * vertexlist,  
         uint64_t * edgelist, uint16_t * vproplist,
-        uint16_t * labellist,
+        uint64_t * labellist,
         uint64_t vertex_cnt, uint64_t edge_cnt);
 extern unsigned parallel_CC(
         uint64_t * vertexlist,  
         uint64_t * edgelist, uint16_t * vproplist,
-        uint16_t * labellist,
+        uint64_t * labellist,
+        uint64_t vertex_cnt, uint64_t edge_cnt,
+        unsigned threadnum);
+extern unsigned UF_CC(
+        uint64_t * vertexlist,  
+        uint64_t * edgelist,
+        uint64_t * labellist,
         uint64_t vertex_cnt, uint64_t edge_cnt,
         unsigned threadnum);
 
@@ -48,7 +54,7 @@ typedef graph_t::edge_iterator      edge_iterator;
 
 //==============================================================//
 
-void output(vector<uint16_t> & labellist)
+void output(vector<uint64_t> & labellist)
 {
     cout<<"Connected Component Results:\n";
     for(size_t i=0;i<labellist.size();i++)
@@ -64,6 +70,7 @@ int main(int argc, char * argv[])
     cout<<"Benchmark: Connected Component\n";
 
     argument_parser arg;
+    arg.add_arg("unionfind","0","lock-free union-find with neighbor sampling instead of bfs", false);
 #ifndef NO_PERF    
     gBenchPerf_event perf;
     if (arg.parse(argc,argv,perf,false)==false)
@@ -83,6 +90,8 @@ int main(int argc, char * argv[])
 
     size_t threadnum;
     arg.get_value("threadnum",threadnum);
+    bool unionfind;
+    arg.get_value("unionfind",unionfind);
 
 
     double t1, t2;
@@ -113,7 +122,7 @@ int main(int argc, char * argv[])
 
     //================================================//
     vector<uint16_t> vproplist(vertex_num, 0);
-    vector<uint16_t> labellist(vertex_num, 0);
+    vector<uint64_t> labellist(vertex_num, 0);
     //================================================//
     
     unsigned ret=0;
@@ -122,7 +131,14 @@ int main(int argc, char * argv[])
     perf.start();
 #endif
     //================================================//
-    if (threadnum==1)
+    if (unionfind)
+        ret = UF_CC(&(vertexlist[0]), 
+            &(edgelist[0]), 
+            &(labellist[0]), 
+            vertexlist.size()-1, 
+            edgelist.size(), 
+            threadnum);
+    else if (threadnum==1)
         ret = seq_CC(&(vertexlist[0]), 
             &(edgelist[0]), 
             &(vproplist[0]),
@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <math.h>
 #include "common.h"
+#include "degree_stat.h"
 
 #ifdef USE_OMP
 #include "omp.h"
@@ -238,3 +239,161 @@ void parallel_degree_centr(
 #endif
 }
 
+
+// in degrees without a shared counter per edge. every thread counts the
+// targets of its own vertices into a private array. after a barrier each
+// thread sums the arrays over its range of vertices and collects the
+// histogram and the hubs of that range
+struct hub_t
+{
+    uint64_t * vertexlist; 
+    uint64_t * edgelist; 
+    int16_t * vproplist;
+    uint64_t vertex_cnt;
+    unsigned threadnum;
+    uint64_t unit;
+
+    vector<vector<uint32_t> > partial;
+    vector<degree_stat> stat;
+    vector<degree_topk> hubs;
+};
+
+struct hub_arg_t
+{
+    hub_t * h;
+    unsigned tid;
+};
+
+void* hub_work(void * t)
+{
+    struct hub_arg_t * arg = (struct hub_arg_t *) t;
+    hub_t & h = *(arg->h);
+    unsigned tid = arg->tid;
+
+    uint64_t begin = tid*h.unit;
+    uint64_t end = begin+h.unit;
+    if (end > h.vertex_cnt) end = h.vertex_cnt;
+    if (begin > end) begin = end;
+
+    // first touch by the owner
+    vector<uint32_t> & cnt = h.partial[tid];
+    cnt.assign(h.vertex_cnt, 0);
+    pthread_barrier_wait (&barrier);
+#ifdef SIM
+    SIM_BEGIN(true);
+#endif  
+    for (uint64_t vid=begin;vid<end;vid++)
+    {
+        for (uint64_t j=h.vertexlist[vid]; j<h.vertexlist[vid+1]; j++)
+            cnt[h.edgelist[j]]++;
+    }
+    pthread_barrier_wait (&barrier);
+
+    degree_stat & stat = h.stat[tid];
+    degree_topk & hubs = h.hubs[tid];
+    for (uint64_t vid=begin;vid<end;vid++)
+    {
+        uint64_t indegree = 0;
+        for (unsigned i=0;i<h.threadnum;i++)
+            indegree += h.partial[i][vid];
+        h.vproplist[vid] = indegree;
+        stat.add(indegree);
+        hubs.push(vid, indegree);
+    }
+#ifdef SIM
+    SIM_END(true);
+#endif    
+
+    return NULL;
+}
+
+void partial_degree_centr(
+        uint64_t * vertexlist, 
+        uint64_t * edgelist, int16_t * vproplist,
+        uint64_t vertex_cnt, uint64_t edge_cnt,
+        unsigned threadnum, size_t k,
+        degree_stat & stat, degree_topk & hubs)
+{
+    double t1, t2;
+    
+    t1 = timer::get_usec();
+
+    // initializzation
+    hub_t h;
+    h.vertexlist = vertexlist;
+    h.edgelist = edgelist;
+    h.vproplist = vproplist;
+    h.vertex_cnt = vertex_cnt;
+    h.threadnum = threadnum;
+    h.unit = (uint64_t)ceil(vertex_cnt/(double)threadnum);
+    h.partial.resize(threadnum);
+    h.stat.resize(threadnum);
+    h.hubs.resize(threadnum);
+    for (unsigned t=0;t<threadnum;t++)
+        h.hubs[t].init(k);
+
+    t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+    cout<<"== initialization time: "<<t2-t1<<" sec\n";
+#else
+    (void)t1;
+    (void)t2;
+#endif
+    t1 = timer::get_usec();
+
+    pthread_barrier_init (&barrier, NULL, threadnum);
+    struct hub_arg_t args[threadnum];
+    for (unsigned t=0;t<threadnum;t++)
+    {
+        args[t].h = &h;
+        args[t].tid = t;
+    }
+#ifndef USE_OMP
+    pthread_t thread[threadnum];
+    pthread_attr_t attr; 
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+    for(unsigned t=1; t<threadnum; t++) 
+    {
+        int rc = pthread_create(&thread[t], &attr, hub_work, (&(args[t]))); 
+        if (rc) 
+        {
+            printf("ERROR; return code from pthread_create() is %d\n", rc);
+            exit(-1);
+        }
+    }
+
+    hub_work((void*) &(args[0]));
+
+    pthread_attr_destroy(&attr);
+    for(unsigned t=1; t<threadnum; t++) 
+    {
+        void* status;
+        int rc = pthread_join(thread[t], &status);
+        if (rc) 
+        {
+            printf("ERROR; return code from pthread_join() is %d\n", rc);
+            exit(-1);
+        }
+    }
+#else
+    #pragma omp parallel num_threads(threadnum)
+    {
+        hub_work((void*) &(args[omp_get_thread_num()]));
+    }
+#endif
+    pthread_barrier_destroy (&barrier);
+
+    stat.clear();
+    hubs.init(k);
+    for (unsigned t=0;t<threadnum;t++)
+    {
+        stat.merge(h.stat[t]);
+        hubs.merge(h.hubs[t]);
+    }
+    t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+    cout<<"== process time: "<<t2-t1<<" sec\n";
+#endif
+}
@@ -7,6 +7,7 @@
 #include "common.h"
 #include "def.h"
 #include "openG.h"
+#include "degree_stat.h"
 
 using namespace std;
 
@@ -19,7 +20,12 @@ extern void parallel_degree_centr(
         uint64_t * edgelist, int16_t * vproplist,
         uint64_t vertex_cnt, uint64_t edge_cnt,
         unsigned threadnum);
-
+extern void partial_degree_centr(
+        uint64_t * vertexlist, 
+        uint64_t * edgelist, int16_t * vproplist,
+        uint64_t vertex_cnt, uint64_t edge_cnt,
+        unsigned threadnum, size_t k,
+        degree_stat & stat, degree_topk & hubs);
 
 class vertex_property
 {
@@ -43,9 +49,33 @@ typedef graph_t::vertex_iterator    vertex_iterator;
 typedef graph_t::edge_iterator      edge_iterator;
 
 //==============================================================//
-
+void arg_init(argument_parser & arg)
+{
+    arg.add_arg("topk","0","k>0: in degrees from per-thread counts, degree histogram and the k vertices of largest in degree");
+}
 //==============================================================//
 
+void print_histogram(degree_stat & stat)
+{
+    cout<<"== inDegree[Max-"<<stat.max<<" Min-"<<stat.min<<"] histogram:\n";
+    for (unsigned b=0;b<DEGREE_BUCKETS;b++)
+    {
+        if (stat.hist[b]==0) continue;
+        if (b==0)
+            cout<<"==   0: "<<stat.hist[b]<<"\n";
+        else
+            cout<<"==   ["<<(1ULL<<(b-1))<<", "<<(b<64 ? (1ULL<<b)-1 : stat.max)<<"]: "<<stat.hist[b]<<"\n";
+    }
+}
+void print_hubs(degree_topk & hubs)
+{
+    vector<degree_topk::entry_t> top;
+    hubs.sorted(top);
+    cout<<"== top "<<top.size()<<" hubs by inDegree:\n";
+    for (size_t i=0;i<top.size();i++)
+        cout<<"==   vertex "<<top[i].second<<": in-"<<top[i].first<<"\n";
+}
+
 void output(vector<int16_t> & vproplist)
 {
     cout<<"Degree Centrality Results:\n";
@@ -63,6 +93,7 @@ int main(int argc, char * argv[])
     cout<<"Benchmark: Degree Centrality\n";
 
     argument_parser arg;
+    arg_init(arg);
 #ifndef NO_PERF    
     gBenchPerf_event perf;
     if (arg.parse(argc,argv,perf,false)==false)
@@ -84,6 +115,8 @@ int main(int argc, char * argv[])
 
     size_t threadnum;
     arg.get_value("threadnum",threadnum);
+    size_t topk;
+    arg.get_value("topk",topk);
 
     double t1, t2;
     
@@ -114,12 +147,21 @@ int main(int argc, char * argv[])
 
     //================================================//
     vector<int16_t> vproplist(vertex_num, 0);
+    degree_stat stat;
+    degree_topk hubs;
     //================================================//
     
     t1 = timer::get_usec();
     //================================================//
     // call omp function 
-    if (threadnum==1)
+    if (topk>0)
+    {
+        partial_degree_centr(&(vertexlist[0]), 
+            &(edgelist[0]), &(vproplist[0]), 
+            vertexlist.size()-1, edgelist.size(),
+            threadnum, topk, stat, hubs);
+    }
+    else if (threadnum==1)
     {
         seq_degree_centr(&(vertexlist[0]), 
             &(edgelist[0]), &(vproplist[0]), 
@@ -138,6 +180,11 @@ int main(int argc, char * argv[])
 
     cout<<"\nDegree Centrality finish: \n";
     cout<<"== "<<vertex_num<<" vertices  "<<edge_num<<" edges\n";
+    if (topk>0)
+    {
+        print_histogram(stat);
+        print_hubs(hubs);
+    }
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<t2-t1<<" sec\n";
 #endif
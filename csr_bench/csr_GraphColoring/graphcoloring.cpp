@@ -4,6 +4,7 @@
 #include <stdint.h>
 #include <algorithm>
 #include "common.h"
+#include "frontier.h"
 
 #ifdef USE_OMP
 #include "omp.h"
@@ -103,43 +104,36 @@ struct arg_t
     uint64_t vertex_cnt;
     uint64_t edge_cnt;
 
-    vector<vector<uint64_t> > * global_input_tasks_ptr;
-    vector<vector<uint64_t> > * global_output_tasks_ptr;
+    frontier * front_ptr;
     vector<uint16_t>  * vertex_rand_ptr;
     unsigned tid;
     unsigned threadnum;
-    bool * stop;
 };
 void* thread_work(void * t)
 {
     struct arg_t * arg = (struct arg_t *) t;
-    vector<vector<uint64_t> > & global_input_tasks = *(arg->global_input_tasks_ptr);
-    vector<vector<uint64_t> > & global_output_tasks = *(arg->global_output_tasks_ptr);
+    frontier & front = *(arg->front_ptr);
     vector<uint16_t> & vertex_rand = *(arg->vertex_rand_ptr);
 
     uint64_t * vertexlist = arg->vertexlist; 
     uint64_t * edgelist = arg->edgelist; 
     uint16_t * vproplist = arg->vproplist;
     unsigned tid = arg->tid;
-    bool & stop = *(arg->stop);
-    unsigned threadnum = arg->threadnum;
 
-    vector<uint64_t> & input_tasks = global_input_tasks[tid];
 #ifdef SIM
     pthread_barrier_wait (&barrier);
     SIM_BEGIN(true);
 #endif  
     vector<uint16_t> updatelist;
     unsigned color=0; 
-    while(!stop)
+    while(!front.empty())
     {
-        pthread_barrier_wait (&barrier);
-        // process local queue
-        stop = true;
-                    
-        for (unsigned i=0;i<input_tasks.size();i++)
+        // process local share of the frontier
+        uint64_t begin, end;
+        front.range(tid, begin, end);
+        for (uint64_t i=begin;i<end;i++)
         {
-            uint64_t vid=input_tasks[i];
+            uint64_t vid=front[i];
             uint16_t local_rand = vertex_rand[vid];
 
             unsigned start = vertexlist[vid];
@@ -160,7 +154,7 @@ void* thread_work(void * t)
             if (found_larger == false)
                 vproplist[vid]=color;//updatelist.push_back(vid);
             else // otherwise, need to processed again 
-                global_output_tasks[vertex_distributor(vid,threadnum)+tid*threadnum].push_back(vid);
+                front.push(tid, vid);
         }
         pthread_barrier_wait (&barrier);
         //for (unsigned i=0;i<updatelist.size();i++)
@@ -168,20 +162,9 @@ void* thread_work(void * t)
         //    vproplist[updatelist[i]] = color;
         //}
         //updatelist.clear();
-        input_tasks.clear();
-        // generate input worklists from output worklists
-        for (unsigned i=0;i<threadnum;i++)
-        {
-            if (global_output_tasks[i*threadnum+tid].size()!=0)
-            {
-                stop = false;
-                input_tasks.insert(input_tasks.end(),
-                        global_output_tasks[i*threadnum+tid].begin(),
-                        global_output_tasks[i*threadnum+tid].end());
-                global_output_tasks[i*threadnum+tid].clear();
-            }
-        }
-        
+        if (tid==0) front.plan();
+        pthread_barrier_wait (&barrier);
+        front.build(tid);
         color++;
         pthread_barrier_wait (&barrier);
     }
@@ -206,15 +189,15 @@ void parallel_graph_coloring(
     // initializzation
     srand(SEED);
     vector<uint16_t> vertex_rand(vertex_cnt);
-    vector<vector<uint64_t> > global_input_tasks(threadnum);
-    vector<vector<uint64_t> > global_output_tasks(threadnum*threadnum);
+    frontier front(vertex_cnt, threadnum);
 
     for (unsigned i=0; i<vertex_cnt; i++)
     {
         vproplist[i] = MY_INFINITY;
         vertex_rand[i] = rand();
-        global_input_tasks[vertex_distributor(i, threadnum)].push_back(i);
+        front.push(0, i);
     }
+    front.advance();
     
     t2 = timer::get_usec();
 #ifndef ENABLE_VERIFY
@@ -225,7 +208,6 @@ void parallel_graph_coloring(
 #endif
     t1 = timer::get_usec();
     
-    bool stop = false;
 #ifndef USE_OMP
     pthread_barrier_init (&barrier, NULL, threadnum);
 
@@ -243,12 +225,10 @@ void parallel_graph_coloring(
         args[t].vertex_cnt = vertex_cnt;
         args[t].edge_cnt = edge_cnt;
 
-        args[t].global_input_tasks_ptr = &global_input_tasks;
-        args[t].global_output_tasks_ptr = &global_output_tasks;
+        args[t].front_ptr = &front;
         args[t].vertex_rand_ptr = &vertex_rand;
 
         args[t].tid = t;
-        args[t].stop = &stop;
         args[t].threadnum = threadnum;
     }
 
@@ -277,21 +257,19 @@ void parallel_graph_coloring(
     }
         
 #else    
-    #pragma omp parallel num_threads(threadnum) shared(stop,global_input_tasks,global_output_tasks) 
+    #pragma omp parallel num_threads(threadnum) shared(front) 
     {
         unsigned tid = omp_get_thread_num();
-        vector<uint64_t> & input_tasks = global_input_tasks[tid];
         vector<uint16_t> updatelist;
         unsigned color=0; 
-        while(!stop)
+        while(!front.empty())
         {
-            #pragma omp barrier
-            // process local queue
-            stop = true;
-                        
-            for (unsigned i=0;i<input_tasks.size();i++)
+            // process local share of the frontier
+            uint64_t begin, end;
+            front.range(tid, begin, end);
+            for (uint64_t i=begin;i<end;i++)
             {
-                uint64_t vid=input_tasks[i];
+                uint64_t vid=front[i];
                 uint16_t local_rand = vertex_rand[vid];
 
                 unsigned start = vertexlist[vid];
@@ -312,7 +290,7 @@ void parallel_graph_coloring(
                 if (found_larger == false)
                     vproplist[vid]=color;//updatelist.push_back(vid);
                 else // otherwise, need to processed again 
-                    global_output_tasks[vertex_distributor(vid,threadnum)+tid*threadnum].push_back(vid);
+                    front.push(tid, vid);
             }
             #pragma omp barrier
             //for (unsigned i=0;i<updatelist.size();i++)
@@ -320,20 +298,10 @@ void parallel_graph_coloring(
             //    vproplist[updatelist[i]] = color;
             //}
             //updatelist.clear();
-            input_tasks.clear();
-            // generate input worklists from output worklists
-            for (unsigned i=0;i<threadnum;i++)
-            {
-                if (global_output_tasks[i*threadnum+tid].size()!=0)
-                {
-                    stop = false;
-                    input_tasks.insert(input_tasks.end(),
-                            global_output_tasks[i*threadnum+tid].begin(),
-                            global_output_tasks[i*threadnum+tid].end());
-                    global_output_tasks[i*threadnum+tid].clear();
-                }
-            }
-            
+            #pragma omp master
+            front.plan();
+            #pragma omp barrier
+            front.build(tid);
             color++;
             #pragma omp barrier
         }
@@ -345,3 +313,260 @@ void parallel_graph_coloring(
 #endif
 }
 
+
+//==============================================================//
+// speculative and priority based coloring. both give a vertex the
+// smallest color that none of its neighbors has. edges are taken as
+// symmetric, as in the round based coloring.
+
+// smallest color not used by a neighbor of vid. mark is a per thread
+// scratch array, color c is taken if mark[c]==stamp. a vertex of degree
+// d always finds a color <= d, larger neighbor colors are not marked
+inline uint16_t smallest_free_color(uint64_t * vertexlist, uint64_t * edgelist,
+        uint16_t * vproplist, uint64_t vid, vector<uint64_t>& mark, uint64_t stamp)
+{
+    uint64_t degree = vertexlist[vid+1]-vertexlist[vid];
+    if (mark.size() < degree+1) mark.resize(degree+1, 0);
+    for (uint64_t d=vertexlist[vid];d<vertexlist[vid+1];d++)
+    {
+        uint16_t c = vproplist[edgelist[d]];
+        if (c <= degree) mark[c] = stamp;
+    }
+    uint16_t c = 0;
+    while (mark[c]==stamp) c++;
+    return c;
+}
+
+// largest-degree-first priority, ties by rand and then by lower id
+inline bool higher_priority(uint64_t * vertexlist, vector<uint16_t>& vertex_rand,
+        uint64_t u, uint64_t v)
+{
+    uint64_t du = vertexlist[u+1]-vertexlist[u];
+    uint64_t dv = vertexlist[v+1]-vertexlist[v];
+    if (du != dv) return du > dv;
+    if (vertex_rand[u] != vertex_rand[v]) return vertex_rand[u] > vertex_rand[v];
+    return u < v;
+}
+
+struct color_t
+{
+    uint64_t * vertexlist; 
+    uint64_t * edgelist; 
+    uint16_t * vproplist;
+    uint64_t vertex_cnt;
+    bool speculative;       // otherwise largest-degree-first
+
+    vector<uint16_t> vertex_rand;
+    vector<uint32_t> pending;   // uncolored neighbors of higher priority
+    frontier front;
+    unsigned rounds;
+};
+
+struct color_arg_t
+{
+    color_t * c;
+    unsigned tid;
+};
+
+// gebremedhin-manne. every vertex of the worklist is colored greedily
+// from the colors its neighbors have at that moment. neighbors colored
+// concurrently may pick the same color, the one with the larger id is
+// then queued for the next round
+void speculative_round(color_t & c, unsigned tid, vector<uint64_t>& mark, uint64_t& stamp)
+{
+    frontier & front = c.front;
+    uint64_t begin, end;
+    front.range(tid, begin, end);
+    for (uint64_t i=begin;i<end;i++)
+    {
+        uint64_t vid = front[i];
+        c.vproplist[vid] = smallest_free_color(c.vertexlist, c.edgelist, 
+                c.vproplist, vid, mark, ++stamp);
+    }
+    pthread_barrier_wait (&barrier);
+
+    // conflict detection
+    for (uint64_t i=begin;i<end;i++)
+    {
+        uint64_t vid = front[i];
+        for (uint64_t d=c.vertexlist[vid];d<c.vertexlist[vid+1];d++)
+        {
+            uint64_t dest = c.edgelist[d];
+            if (dest < vid && c.vproplist[dest] == c.vproplist[vid])
+            {
+                front.push(tid, vid);
+                break;
+            }
+        }
+    }
+}
+
+// jones-plassmann. a vertex joins the worklist once its neighbors of
+// higher priority are all colored. a round colors the whole worklist,
+// so the rounds are the longest chain of decreasing priority instead of
+// the number of colors
+void ldf_round(color_t & c, unsigned tid, vector<uint64_t>& mark, uint64_t& stamp)
+{
+    frontier & front = c.front;
+    uint64_t begin, end;
+    front.range(tid, begin, end);
+    for (uint64_t i=begin;i<end;i++)
+    {
+        uint64_t vid = front[i];
+        c.vproplist[vid] = smallest_free_color(c.vertexlist, c.edgelist, 
+                c.vproplist, vid, mark, ++stamp);
+        for (uint64_t d=c.vertexlist[vid];d<c.vertexlist[vid+1];d++)
+        {
+            uint64_t dest = c.edgelist[d];
+            if (higher_priority(c.vertexlist, c.vertex_rand, vid, dest) &&
+                __sync_sub_and_fetch(&(c.pending[dest]), 1) == 0)
+                front.push(tid, dest);
+        }
+    }
+}
+
+void* color_work(void * t)
+{
+    struct color_arg_t * arg = (struct color_arg_t *) t;
+    color_t & c = *(arg->c);
+    frontier & front = c.front;
+    unsigned tid = arg->tid;
+    vector<uint64_t> mark;
+    uint64_t stamp = 0;
+
+    pthread_barrier_wait (&barrier);
+    if (!c.speculative)
+    {
+        // front holds all vertices, keep the ones without pending neighbors
+        uint64_t begin, end;
+        front.range(tid, begin, end);
+        for (uint64_t i=begin;i<end;i++)
+        {
+            uint64_t vid = front[i];
+            uint32_t cnt = 0;
+            for (uint64_t d=c.vertexlist[vid];d<c.vertexlist[vid+1];d++)
+                if (higher_priority(c.vertexlist, c.vertex_rand, c.edgelist[d], vid)) cnt++;
+            c.pending[vid] = cnt;
+            if (cnt==0) front.push(tid, vid);
+        }
+        pthread_barrier_wait (&barrier);
+        if (tid==0) front.plan();
+        pthread_barrier_wait (&barrier);
+        front.build(tid);
+        pthread_barrier_wait (&barrier);
+    }
+#ifdef SIM
+    SIM_BEGIN(true);
+#endif  
+    while (!front.empty())
+    {
+        if (c.speculative)
+            speculative_round(c, tid, mark, stamp);
+        else
+            ldf_round(c, tid, mark, stamp);
+        pthread_barrier_wait (&barrier);
+        if (tid==0)
+        {
+            front.plan();
+            c.rounds++;
+        }
+        pthread_barrier_wait (&barrier);
+        front.build(tid);
+        pthread_barrier_wait (&barrier);
+    }
+#ifdef SIM
+    SIM_END(true);
+#endif 
+
+    return NULL;
+}
+
+// returns the number of rounds
+unsigned greedy_graph_coloring(
+        uint64_t * vertexlist, 
+        uint64_t * edgelist, uint16_t * vproplist,
+        uint64_t vertex_cnt, uint64_t edge_cnt,
+        unsigned threadnum, bool speculative)
+{
+    double t1, t2;
+       
+    t1 = timer::get_usec();
+
+    // initializzation
+    color_t c;
+    c.vertexlist = vertexlist;
+    c.edgelist = edgelist;
+    c.vproplist = vproplist;
+    c.vertex_cnt = vertex_cnt;
+    c.speculative = speculative;
+    c.rounds = 0;
+    srand(SEED);
+    c.vertex_rand.resize(vertex_cnt);
+    if (!speculative) c.pending.resize(vertex_cnt);
+    c.front.init(vertex_cnt, threadnum);
+    for (uint64_t i=0; i<vertex_cnt; i++)
+    {
+        vproplist[i] = MY_INFINITY;
+        c.vertex_rand[i] = rand();
+        c.front.push(0, i);
+    }
+    c.front.advance();
+
+    t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+    cout<<"== initialization time: "<<t2-t1<<" sec\n";
+#else
+    (void)t1;
+    (void)t2;
+#endif
+    t1 = timer::get_usec();
+
+    pthread_barrier_init (&barrier, NULL, threadnum);
+    struct color_arg_t args[threadnum];
+    for (unsigned t=0;t<threadnum;t++)
+    {
+        args[t].c = &c;
+        args[t].tid = t;
+    }
+#ifndef USE_OMP
+    pthread_t thread[threadnum];
+    pthread_attr_t attr; 
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+    for(unsigned t=1; t<threadnum; t++) 
+    {
+        int rc = pthread_create(&thread[t], &attr, color_work, (&(args[t]))); 
+        if (rc) 
+        {
+            printf("ERROR; return code from pthread_create() is %d\n", rc);
+            exit(-1);
+        }
+    }
+
+    color_work((void*) &(args[0]));
+
+    pthread_attr_destroy(&attr);
+    for(unsigned t=1; t<threadnum; t++) 
+    {
+        void* status;
+        int rc = pthread_join(thread[t], &status);
+        if (rc) 
+        {
+            printf("ERROR; return code from pthread_join() is %d\n", rc);
+            exit(-1);
+        }
+    }
+#else
+    #pragma omp parallel num_threads(threadnum)
+    {
+        color_work((void*) &(args[omp_get_thread_num()]));
+    }
+#endif
+    pthread_barrier_destroy (&barrier);
+    t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+    cout<<"== traversal time: "<<t2-t1<<" sec\n";
+#endif
+    return c.rounds;
+}
@@ -19,6 +19,11 @@ extern void parallel_graph_coloring(
         uint64_t * edgelist, uint16_t * vproplist,
         uint64_t vertex_cnt, uint64_t edge_cnt,
         unsigned threadnum);
+extern unsigned greedy_graph_coloring(
+        uint64_t * vertexlist, 
+        uint64_t * edgelist, uint16_t * vproplist,
+        uint64_t vertex_cnt, uint64_t edge_cnt,
+        unsigned threadnum, bool speculative);
 
 class vertex_property
 {
@@ -42,7 +47,10 @@ typedef graph_t::vertex_iterator    vertex_iterator;
 typedef graph_t::edge_iterator      edge_iterator;
 
 //==============================================================//
-
+void arg_init(argument_parser & arg)
+{
+    arg.add_arg("mode","rounds","rounds: one color per round, speculative: greedy with conflict repair, ldf: jones-plassmann with largest-degree-first priority");
+}
 //==============================================================//
 
 void output(vector<uint16_t> & vproplist)
@@ -61,6 +69,7 @@ int main(int argc, char * argv[])
     cout<<"Benchmark: Graph Coloring\n";
 
     argument_parser arg;
+    arg_init(arg);
 #ifndef NO_PERF    
     gBenchPerf_event perf;
     if (arg.parse(argc,argv,perf,false)==false)
@@ -81,6 +90,13 @@ int main(int argc, char * argv[])
 
     size_t threadnum;
     arg.get_value("threadnum",threadnum);
+    string mode;
+    arg.get_value("mode",mode);
+    if (mode!="rounds" && mode!="speculative" && mode!="ldf")
+    {
+        arg.help();
+        return -1;
+    }
 
     double t1, t2;
     
@@ -115,7 +131,12 @@ int main(int argc, char * argv[])
 
     t1 = timer::get_usec();
     //================================================//
-    if (threadnum==1)
+    unsigned rounds = 0;
+    if (mode!="rounds")
+        rounds = greedy_graph_coloring(&(vertexlist[0]), 
+            &(edgelist[0]), &(vproplist[0]), 
+            vertexlist.size()-1, edgelist.size(), threadnum, mode=="speculative");
+    else if (threadnum==1)
         seq_graph_coloring(&(vertexlist[0]), 
             &(edgelist[0]), &(vproplist[0]), 
             vertexlist.size()-1, edgelist.size());
@@ -130,6 +151,13 @@ int main(int argc, char * argv[])
     cout<<"\nGraph Coloring finish: \n";
     cout<<"== thread num: "<<threadnum<<endl;
     cout<<"== "<<vertex_num<<" vertices  "<<edge_num<<" edges\n";
+    if (mode!="rounds")
+    {
+        uint16_t colors = 0;
+        for (size_t i=0;i<vproplist.size();i++)
+            colors = std::max<uint16_t>(colors, vproplist[i]+1);
+        cout<<"== colors: "<<colors<<"  rounds: "<<rounds<<"\n";
+    }
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<t2-t1<<" sec\n";
 #endif
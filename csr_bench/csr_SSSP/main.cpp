@@ -26,6 +26,14 @@ extern void parallel_SSSP(
         uint64_t vertex_cnt, 
         uint64_t edge_cnt,
         uint64_t root, unsigned threadnum);
+extern void delta_SSSP(
+        uint64_t * vertexlist, 
+        uint64_t * edgelist, 
+        uint16_t * vproplist,
+        uint16_t * eproplist,
+        uint64_t vertex_cnt, 
+        uint64_t edge_cnt,
+        uint64_t root, unsigned threadnum, uint64_t delta);
 
 class vertex_property
 {
@@ -52,6 +60,7 @@ typedef graph_t::edge_iterator      edge_iterator;
 void arg_init(argument_parser & arg)
 {
     arg.add_arg("root","0","root/starting vertex");
+    arg.add_arg("delta","0","bucket width of delta-stepping, 0 for level-synchronous bellman-ford");
 }
 //==============================================================//
 
@@ -93,9 +102,10 @@ int main(int argc, char * argv[])
     string path;
     arg.get_value("dataset",path);
 
-    size_t root,threadnum;
+    size_t root,threadnum,delta;
     arg.get_value("root",root);
     arg.get_value("threadnum",threadnum);
+    arg.get_value("delta",delta);
     
     double t1, t2;
     
@@ -131,7 +141,11 @@ int main(int argc, char * argv[])
 
     t1 = timer::get_usec();
     //================================================//
-    if (threadnum==1)
+    if (delta > 0)
+        delta_SSSP(&(vertexlist[0]), 
+            &(edgelist[0]), &(vproplist[0]),&(eproplist[0]), 
+            vertexlist.size()-1, edgelist.size(), root, threadnum, delta);
+    else if (threadnum==1)
         seq_SSSP(&(vertexlist[0]), 
             &(edgelist[0]), &(vproplist[0]),&(eproplist[0]), 
             vertexlist.size()-1, edgelist.size(), root);
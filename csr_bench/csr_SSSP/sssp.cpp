@@ -3,7 +3,9 @@
 #include <vector>
 #include <stdint.h>
 #include <queue>
+#include <algorithm>
 #include "common.h"
+#include "frontier.h"
 
 #ifdef USE_OMP
 #include "omp.h"
@@ -104,19 +106,16 @@ struct arg_t
     uint16_t * update;
     bool * locks;
 
-    vector<vector<uint64_t> > * global_input_tasks_ptr;
-    vector<vector<uint64_t> > * global_output_tasks_ptr;
+    frontier * front_ptr;
 
     unsigned tid;
     unsigned threadnum;
-    bool * stop;
 };
 
 void* thread_work(void * t)
 {
     struct arg_t * arg = (struct arg_t *) t;
-    vector<vector<uint64_t> > & global_input_tasks = *(arg->global_input_tasks_ptr);
-    vector<vector<uint64_t> > & global_output_tasks = *(arg->global_output_tasks_ptr);
+    frontier & front = *(arg->front_ptr);
 
     uint64_t * vertexlist = arg->vertexlist; 
     uint64_t * edgelist = arg->edgelist; 
@@ -126,24 +125,25 @@ void* thread_work(void * t)
     bool * locks = arg->locks;
 
     unsigned tid = arg->tid;
-    bool & stop = *(arg->stop);
-    unsigned threadnum = arg->threadnum;
 
-    vector<uint64_t> & input_tasks = global_input_tasks[tid];
 #ifdef SIM
     pthread_barrier_wait (&barrier);
     SIM_BEGIN(true);
 #endif 
        
-    while(!stop)
+    while(!front.empty())
     {
+        // process local share of the frontier
+        uint64_t begin, end;
+        front.range(tid, begin, end);
+        for (uint64_t i=begin;i<end;i++)
+            vproplist[front[i]] = update[front[i]];
+        // the copy reads update without the lock, relaxations of other
+        // threads must not start before it is done
         pthread_barrier_wait (&barrier);
-        // process local queue
-        stop = true;
-        
-        for (unsigned i=0;i<input_tasks.size();i++)
+        for (uint64_t i=begin;i<end;i++)
         {
-            uint64_t vid=input_tasks[i];
+            uint64_t vid=front[i];
             uint16_t curr_dist = vproplist[vid];
             uint32_t edge_start = vertexlist[vid];
             uint32_t edge_end = vertexlist[vid+1];
@@ -156,7 +156,7 @@ void* thread_work(void * t)
 #ifdef HMC
                 if (HMC_CAS_greater_16B(&(update[dest_vid]),new_dist) > new_dist) 
                 {
-                    global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                    front.push(tid, dest_vid);
                 }
 #else
                 bool active=false;
@@ -172,28 +172,15 @@ void* thread_work(void * t)
                 
                 if (active)
                 {
-                    global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                    front.push(tid, dest_vid);
                 }
 #endif
             }
         }
         pthread_barrier_wait (&barrier);
-        input_tasks.clear();
-        for (unsigned i=0;i<threadnum;i++)
-        {
-            if (global_output_tasks[i*threadnum+tid].size()!=0)
-            {
-                stop = false;
-                input_tasks.insert(input_tasks.end(),
-                        global_output_tasks[i*threadnum+tid].begin(),
-                        global_output_tasks[i*threadnum+tid].end());
-                global_output_tasks[i*threadnum+tid].clear();
-            }
-        }
-        for (unsigned i=0;i<input_tasks.size();i++) 
-        {
-            vproplist[input_tasks[i]] = update[input_tasks[i]];
-        }
+        if (tid==0) front.plan();
+        pthread_barrier_wait (&barrier);
+        front.build(tid);
         pthread_barrier_wait (&barrier);
     }
 
@@ -234,10 +221,9 @@ void parallel_SSSP(
     bool * locks = new bool[vertex_cnt];
     memset(locks, 0, sizeof(bool)*vertex_cnt); 
 
-    vector<vector<uint64_t> > global_input_tasks(threadnum);
-    global_input_tasks[vertex_distributor(root,threadnum)].push_back(root);
-    
-    vector<vector<uint64_t> > global_output_tasks(threadnum*threadnum);
+    frontier front(vertex_cnt, threadnum);
+    front.push(0, root);
+    front.advance();
     t2 = timer::get_usec();
 #ifndef ENABLE_VERIFY
     cout<<"== initialization time: "<<t2-t1<<" sec\n";
@@ -248,7 +234,6 @@ void parallel_SSSP(
 
     t1 = timer::get_usec();
     
-    bool stop = false;
 #ifndef USE_OMP
     pthread_barrier_init (&barrier, NULL, threadnum);
 
@@ -266,15 +251,13 @@ void parallel_SSSP(
         args[t].vertex_cnt = vertex_cnt;
         args[t].edge_cnt = edge_cnt;
 
-        args[t].global_input_tasks_ptr = &global_input_tasks;
-        args[t].global_output_tasks_ptr = &global_output_tasks;
+        args[t].front_ptr = &front;
 
         args[t].update = &(update[0]);
         args[t].eproplist = eproplist;
         args[t].locks = locks;
 
         args[t].tid = t;
-        args[t].stop = &stop;
         args[t].threadnum = threadnum;
     }
 
@@ -303,20 +286,21 @@ void parallel_SSSP(
     }
         
 #else    
-    #pragma omp parallel num_threads(threadnum) shared(stop,global_input_tasks,global_output_tasks) 
+    #pragma omp parallel num_threads(threadnum) shared(front) 
     {
         unsigned tid = omp_get_thread_num();
-        vector<uint64_t> & input_tasks = global_input_tasks[tid];
         
-        while(!stop)
+        while(!front.empty())
         {
+            // process local share of the frontier
+            uint64_t begin, end;
+            front.range(tid, begin, end);
+            for (uint64_t i=begin;i<end;i++)
+                vproplist[front[i]] = update[front[i]];
             #pragma omp barrier
-            // process local queue
-            stop = true;
-            
-            for (unsigned i=0;i<input_tasks.size();i++)
+            for (uint64_t i=begin;i<end;i++)
             {
-                uint64_t vid=input_tasks[i];
+                uint64_t vid=front[i];
                 uint16_t curr_dist = vproplist[vid];
                 uint32_t edge_start = vertexlist[vid];
                 uint32_t edge_end = vertexlist[vid+1];
@@ -329,7 +313,7 @@ void parallel_SSSP(
 #ifdef HMC
                     if (HMC_CAS_greater_16B(&(update[dest_vid]),new_dist) > new_dist) 
                     {
-                        global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                        front.push(tid, dest_vid);
                     }
 #else
                     bool active=false;
@@ -345,35 +329,270 @@ void parallel_SSSP(
                     
                     if (active)
                     {
-                        global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                        front.push(tid, dest_vid);
                     }
 #endif
                 }
             }
             #pragma omp barrier
-            input_tasks.clear();
-            for (unsigned i=0;i<threadnum;i++)
+            #pragma omp master
+            front.plan();
+            #pragma omp barrier
+            front.build(tid);
+            #pragma omp barrier
+        }
+    }
+#endif
+    t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+    cout<<"== traversal time: "<<t2-t1<<" sec\n";
+#endif
+    delete[] locks;
+}
+
+//==============================================================//
+// delta-stepping. vertices wait in buckets of width delta by tentative
+// distance and the lowest non-empty bucket is processed in parallel.
+// light edges (weight <= delta) are relaxed in rounds until the bucket
+// stays empty, requests of heavy edges are applied once it is settled.
+// buckets are thread local; stale entries are skipped when collected.
+
+#define NO_BUCKET ((uint64_t)-1)
+
+struct delta_t
+{
+    uint64_t * vertexlist; 
+    uint64_t * edgelist; 
+    uint16_t * vproplist;
+    uint16_t * eproplist;
+    uint64_t delta;
+
+    frontier front;                 // current bucket
+    vector<char> light_left;        // per thread: current bucket not empty
+    vector<uint64_t> next_bin;      // per thread: lowest later bucket
+    vector<uint64_t> relaxations;   // per thread counters
+    uint64_t phases, buckets;
+};
+
+struct delta_arg_t
+{
+    delta_t * d;
+    unsigned tid;
+};
+
+// lower *addr to val, true if it was larger
+inline bool atomic_min(uint16_t * addr, uint16_t val)
+{
+#ifdef HMC
+    return HMC_CAS_greater_16B(addr, val) > val;
+#else
+    uint16_t old = *addr;
+    while (val < old)
+    {
+        uint16_t prev = __sync_val_compare_and_swap(addr, old, val);
+        if (prev == old) return true;
+        old = prev;
+    }
+    return false;
+#endif
+}
+
+// move the target to the bucket of its new distance if that is shorter
+inline void relax(delta_t & d, uint64_t dest_vid, uint16_t new_dist, 
+        vector<vector<uint64_t> > & bins)
+{
+    if (atomic_min(&(d.vproplist[dest_vid]), new_dist))
+    {
+        uint64_t b = new_dist/d.delta;
+        if (b >= bins.size()) bins.resize(b+1);
+        bins[b].push_back(dest_vid);
+    }
+}
+
+void* delta_work(void * t)
+{
+    struct delta_arg_t * arg = (struct delta_arg_t *) t;
+    delta_t & d = *(arg->d);
+    frontier & front = d.front;
+    unsigned tid = arg->tid;
+
+    uint64_t curr_bin = 0;
+    uint64_t relaxations = 0;
+    vector<vector<uint64_t> > bins;
+    vector<pair<uint64_t,uint16_t> > heavy;     // target, new distance
+
+    pthread_barrier_wait (&barrier);
+#ifdef SIM
+    SIM_BEGIN(true);
+#endif        
+    while (curr_bin != NO_BUCKET)
+    {
+        // light round on the current bucket
+        uint64_t begin, end;
+        front.range(tid, begin, end);
+        for (uint64_t i=begin;i<end;i++)
+        {
+            uint64_t vid = front[i];
+            uint32_t curr_dist = d.vproplist[vid];
+            for (uint64_t j=d.vertexlist[vid];j<d.vertexlist[vid+1];j++)
             {
-                if (global_output_tasks[i*threadnum+tid].size()!=0)
+                uint32_t new_dist = curr_dist + d.eproplist[j];
+                if (new_dist >= MY_INFINITY) continue;
+                if (d.eproplist[j] > d.delta)
+                    heavy.push_back(make_pair(d.edgelist[j], (uint16_t)new_dist));
+                else
                 {
-                    stop = false;
-                    input_tasks.insert(input_tasks.end(),
-                            global_output_tasks[i*threadnum+tid].begin(),
-                            global_output_tasks[i*threadnum+tid].end());
-                    global_output_tasks[i*threadnum+tid].clear();
+                    relax(d, d.edgelist[j], new_dist, bins);
+                    relaxations++;
                 }
             }
-            for (unsigned i=0;i<input_tasks.size();i++) 
+        }
+        d.light_left[tid] = (curr_bin < bins.size() && !bins[curr_bin].empty());
+        pthread_barrier_wait (&barrier);
+        bool settled = (std::count(d.light_left.begin(), d.light_left.end(), 1) == 0);
+        if (settled)
+        {
+            // relax heavy edges and look for the next bucket
+            for (size_t i=0;i<heavy.size();i++)
+                relax(d, heavy[i].first, heavy[i].second, bins);
+            relaxations += heavy.size();
+            heavy.clear();
+            d.next_bin[tid] = NO_BUCKET;
+            for (uint64_t b=curr_bin+1;b<bins.size();b++)
             {
-                vproplist[input_tasks[i]] = update[input_tasks[i]];
+                if (bins[b].empty()) continue;
+                d.next_bin[tid] = b;
+                break;
             }
-            #pragma omp barrier
         }
+        pthread_barrier_wait (&barrier);
+        if (settled)
+            curr_bin = *std::min_element(d.next_bin.begin(), d.next_bin.end());
+        if (tid==0)
+        {
+            d.phases++;
+            if (settled) d.buckets++;
+        }
+        if (curr_bin < bins.size())
+        {
+            vector<uint64_t> & bin = bins[curr_bin];
+            for (size_t i=0;i<bin.size();i++)
+            {
+                if (d.vproplist[bin[i]]/d.delta == curr_bin)
+                    front.push(tid, bin[i]);
+            }
+            bin.clear();
+        }
+        pthread_barrier_wait (&barrier);
+        if (tid==0) front.plan();
+        pthread_barrier_wait (&barrier);
+        front.build(tid);
+        pthread_barrier_wait (&barrier);
     }
+#ifdef SIM
+    SIM_END(true);
+#endif    
+    d.relaxations[tid] = relaxations;
+    return NULL;
+}
+
+void delta_SSSP(
+        uint64_t * vertexlist, 
+        uint64_t * edgelist, 
+        uint16_t * vproplist,
+        uint16_t * eproplist,
+        uint64_t vertex_cnt, 
+        uint64_t edge_cnt,
+        uint64_t root, 
+        unsigned threadnum,
+        uint64_t delta)
+{
+    double t1, t2;
+    
+    t1 = timer::get_usec();
+    
+    // initializzation
+    for (unsigned i=0; i<vertex_cnt; i++)
+    {
+        vproplist[i] = MY_INFINITY;
+    }
+    vproplist[root] = 0;
+
+    delta_t d;
+    d.vertexlist = vertexlist;
+    d.edgelist = edgelist;
+    d.vproplist = vproplist;
+    d.eproplist = eproplist;
+    d.delta = delta;
+    d.front.init(vertex_cnt, threadnum);
+    d.front.push(0, root);
+    d.front.advance();
+    d.light_left.assign(threadnum, 0);
+    d.next_bin.assign(threadnum, NO_BUCKET);
+    d.relaxations.assign(threadnum, 0);
+    d.phases = 0;
+    d.buckets = 0;
+
+    t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+    cout<<"== initialization time: "<<t2-t1<<" sec\n";
+#else
+    (void)t1;
+    (void)t2;
 #endif
+    t1 = timer::get_usec();
+
+    pthread_barrier_init (&barrier, NULL, threadnum);
+    struct delta_arg_t args[threadnum];
+    for (unsigned t=0;t<threadnum;t++)
+    {
+        args[t].d = &d;
+        args[t].tid = t;
+    }
+#ifndef USE_OMP
+    pthread_t thread[threadnum];
+    pthread_attr_t attr; 
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+    for(unsigned t=1; t<threadnum; t++) 
+    {
+        int rc = pthread_create(&thread[t], &attr, delta_work, (&(args[t]))); 
+        if (rc) 
+        {
+            printf("ERROR; return code from pthread_create() is %d\n", rc);
+            exit(-1);
+        }
+    }
+
+    delta_work((void*) &(args[0]));
+
+    pthread_attr_destroy(&attr);
+    for(unsigned t=1; t<threadnum; t++) 
+    {
+        void* status;
+        int rc = pthread_join(thread[t], &status);
+        if (rc) 
+        {
+            printf("ERROR; return code from pthread_join() is %d\n", rc);
+            exit(-1);
+        }
+    }
+#else
+    #pragma omp parallel num_threads(threadnum)
+    {
+        delta_work((void*) &(args[omp_get_thread_num()]));
+    }
+#endif
+    pthread_barrier_destroy (&barrier);
     t2 = timer::get_usec();
 #ifndef ENABLE_VERIFY
     cout<<"== traversal time: "<<t2-t1<<" sec\n";
+    uint64_t total=0;
+    for (unsigned t=0;t<threadnum;t++)
+        total += d.relaxations[t];
+    cout<<"== relaxations: "<<total
+        <<"  ("<<total/(double)max(edge_cnt,(uint64_t)1)<<" per edge)\n";
+    cout<<"== phases: "<<d.phases<<"  buckets: "<<d.buckets<<"\n";
 #endif
-    delete[] locks;
 }
@@ -2,8 +2,11 @@
 #include <string>
 #include <vector>
 #include <queue>
+#include <limits>
+#include <algorithm>
 #include <stdint.h>
 #include "common.h"
+#include "frontier.h"
 
 #ifdef USE_OMP
 #include "omp.h"
@@ -32,7 +35,7 @@ inline unsigned vertex_distributor(uint64_t vid, unsigned threadnum)
 
 void seq_init(
         uint64_t * vertexlist,
-        int16_t * vproplist,
+        int64_t * vproplist,
         uint64_t vertex_cnt,
         unsigned kcore,
         vector<bool>& removed, 
@@ -43,7 +46,7 @@ void seq_init(
     {
         vproplist[i] = vertexlist[i+1]-vertexlist[i];
         
-        if (vproplist[i] < (int16_t)kcore) 
+        if (vproplist[i] < (int64_t)kcore) 
         {
             process_q.push(i);
             removed[i] = true;
@@ -54,7 +57,7 @@ void seq_init(
 void seq_kcore_process(
         uint64_t * vertexlist, 
         uint64_t * edgelist, 
-        int16_t * vproplist,
+        int64_t * vproplist,
         uint64_t vertex_cnt, 
         uint64_t edge_cnt,
         unsigned kcore,
@@ -77,14 +80,9 @@ void seq_kcore_process(
                 uint64_t dest_vid = edgelist[j];
                 if (removed[dest_vid]==false)
                 {
-#ifdef HMC
-                    if (HMC_ADD_16B(&(vproplist[dest_vid]), -1)==(int16_t)kcore)
-                    {
-#else
                     vproplist[dest_vid]--;
-                    if (vproplist[dest_vid]<(int16_t)kcore)
+                    if (vproplist[dest_vid]<(int64_t)kcore)
                     {
-#endif
                         removed[dest_vid] = true;
                         remove_cnt++;
                         process_q.push(dest_vid);
@@ -99,7 +97,7 @@ void seq_kcore_process(
 unsigned seq_kcore(
         uint64_t * vertexlist, 
         uint64_t * edgelist, 
-        int16_t * vproplist,
+        int64_t * vproplist,
         uint64_t vertex_cnt, 
         uint64_t edge_cnt,
         unsigned kcore) 
@@ -135,51 +133,44 @@ struct arg_t
 {
     uint64_t * vertexlist; 
     uint64_t * edgelist; 
-    int16_t * vproplist;
+    int64_t * vproplist;
     uint64_t vertex_cnt;
     uint64_t edge_cnt;
 
-    vector<vector<uint64_t> > * global_input_tasks_ptr;
-    vector<vector<uint64_t> > * global_output_tasks_ptr;
+    frontier * front_ptr;
     vector<bool> * removed_ptr;
     unsigned * remove_cnt_ptr;
 
     unsigned tid;
     unsigned threadnum;
     unsigned kcore;
-    bool * stop;
 };
 
 void* thread_work(void * t)
 {
     struct arg_t * arg = (struct arg_t *) t;
-    vector<vector<uint64_t> > & global_input_tasks = *(arg->global_input_tasks_ptr);
-    vector<vector<uint64_t> > & global_output_tasks = *(arg->global_output_tasks_ptr);
+    frontier & front = *(arg->front_ptr);
     vector<bool> & removed = *(arg->removed_ptr);
     unsigned & remove_cnt = *(arg->remove_cnt_ptr);
 
     uint64_t * vertexlist = arg->vertexlist; 
     uint64_t * edgelist = arg->edgelist; 
-    int16_t * vproplist = arg->vproplist;
+    int64_t * vproplist = arg->vproplist;
     unsigned tid = arg->tid;
-    bool & stop = *(arg->stop);
     unsigned kcore = arg->kcore;
-    unsigned threadnum = arg->threadnum;
 
-    vector<uint64_t> & input_tasks = global_input_tasks[tid];
 #ifdef SIM
     pthread_barrier_wait (&barrier);
     SIM_BEGIN(true);
 #endif        
-    while(!stop)
+    while(!front.empty())
     {
-        pthread_barrier_wait (&barrier);
-        // process local queue
-        stop = true;
-        
-        for (unsigned i=0;i<input_tasks.size();i++)
+        // process local share of the frontier
+        uint64_t begin, end;
+        front.range(tid, begin, end);
+        for (uint64_t i=begin;i<end;i++)
         {
-            uint64_t vid=input_tasks[i];
+            uint64_t vid=front[i];
             uint32_t edge_start = vertexlist[vid];
             uint32_t edge_end = vertexlist[vid+1];
 
@@ -188,32 +179,19 @@ void* thread_work(void * t)
                 uint64_t dest_vid = edgelist[j];
                 if (removed[dest_vid]==false)
                 {
-#ifdef HMC
-                    if (HMC_ADD_16B(&(vproplist[dest_vid]), -1)==(int16_t)kcore) 
-#else
-                    if (__sync_fetch_and_sub(&(vproplist[dest_vid]), 1)==(int16_t)kcore)
-#endif
+                    if (__sync_fetch_and_sub(&(vproplist[dest_vid]), 1)==(int64_t)kcore)
                     {
                         removed[dest_vid] = true;
                         __sync_fetch_and_add(&remove_cnt, 1);
-                        global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                        front.push(tid, dest_vid);
                     }
                 }
             }
         }
         pthread_barrier_wait (&barrier);
-        input_tasks.clear();
-        for (unsigned i=0;i<threadnum;i++)
-        {
-            if (global_output_tasks[i*threadnum+tid].size()!=0)
-            {
-                stop = false;
-                input_tasks.insert(input_tasks.end(),
-                        global_output_tasks[i*threadnum+tid].begin(),
-                        global_output_tasks[i*threadnum+tid].end());
-                global_output_tasks[i*threadnum+tid].clear();
-            }
-        }
+        if (tid==0) front.plan();
+        pthread_barrier_wait (&barrier);
+        front.build(tid);
         pthread_barrier_wait (&barrier);
     }
 
@@ -230,7 +208,7 @@ void* thread_work(void * t)
 unsigned parallel_kcore(
         uint64_t * vertexlist, 
         uint64_t * edgelist, 
-        int16_t * vproplist,
+        int64_t * vproplist,
         uint64_t vertex_cnt, 
         uint64_t edge_cnt,
         unsigned kcore, 
@@ -243,20 +221,20 @@ unsigned parallel_kcore(
        
     vector<bool> removed(vertex_cnt, false); 
     unsigned remove_cnt = 0;
-    vector<vector<uint64_t> > global_input_tasks(threadnum);
-    vector<vector<uint64_t> > global_output_tasks(threadnum*threadnum);
+    frontier front(vertex_cnt, threadnum);
     // initializzation
     for (unsigned i=0; i<vertex_cnt; i++)
     {
         vproplist[i] = vertexlist[i+1]-vertexlist[i];
         
-        if (vproplist[i] < (int16_t)kcore) 
+        if (vproplist[i] < (int64_t)kcore) 
         {
-            global_input_tasks[vertex_distributor(i, threadnum)].push_back(i);
+            front.push(0, i);
             removed[i] = true;
             remove_cnt++;
         }
     }
+    front.advance();
 
     
     t2 = timer::get_usec();
@@ -270,7 +248,6 @@ unsigned parallel_kcore(
 
     t1 = timer::get_usec();
     
-    bool stop = false;
 #ifndef USE_OMP
     pthread_barrier_init (&barrier, NULL, threadnum);
 
@@ -288,13 +265,11 @@ unsigned parallel_kcore(
         args[t].vertex_cnt = vertex_cnt;
         args[t].edge_cnt = edge_cnt;
 
-        args[t].global_input_tasks_ptr = &global_input_tasks;
-        args[t].global_output_tasks_ptr = &global_output_tasks;
+        args[t].front_ptr = &front;
         args[t].removed_ptr = &removed;
         args[t].remove_cnt_ptr = & remove_cnt;
 
         args[t].tid = t;
-        args[t].stop = &stop;
         args[t].threadnum = threadnum;
         args[t].kcore = kcore;
     }
@@ -324,20 +299,18 @@ unsigned parallel_kcore(
     }
         
 #else    
-    #pragma omp parallel num_threads(threadnum) shared(stop,global_input_tasks,global_output_tasks) 
+    #pragma omp parallel num_threads(threadnum) shared(front) 
     {
         unsigned tid = omp_get_thread_num();
-        vector<uint64_t> & input_tasks = global_input_tasks[tid];
         
-        while(!stop)
+        while(!front.empty())
         {
-            #pragma omp barrier
-            // process local queue
-            stop = true;
-            
-            for (unsigned i=0;i<input_tasks.size();i++)
+            // process local share of the frontier
+            uint64_t begin, end;
+            front.range(tid, begin, end);
+            for (uint64_t i=begin;i<end;i++)
             {
-                uint64_t vid=input_tasks[i];
+                uint64_t vid=front[i];
                 uint32_t edge_start = vertexlist[vid];
                 uint32_t edge_end = vertexlist[vid+1];
 
@@ -346,40 +319,334 @@ unsigned parallel_kcore(
                     uint64_t dest_vid = edgelist[j];
                     if (removed[dest_vid]==false)
                     {
-#ifdef HMC
-                        if (HMC_ADD_16B(&(vproplist[dest_vid]), -1)==(int16_t)kcore)                
-#else
-                        if (__sync_fetch_and_sub(&(vproplist[dest_vid]), 1)==(int16_t)kcore)
-#endif
+                        if (__sync_fetch_and_sub(&(vproplist[dest_vid]), 1)==(int64_t)kcore)
                         {
 
                             removed[dest_vid] = true;
                             __sync_fetch_and_add(&remove_cnt, 1);
-                            global_output_tasks[vertex_distributor(dest_vid,threadnum)+tid*threadnum].push_back(dest_vid);
+                            front.push(tid, dest_vid);
                         }
                     }
                 }
             }
             #pragma omp barrier
-            input_tasks.clear();
-            for (unsigned i=0;i<threadnum;i++)
+            #pragma omp master
+            front.plan();
+            #pragma omp barrier
+            front.build(tid);
+            #pragma omp barrier
+        }
+    }
+#endif
+    t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+    cout<<"== processing time: "<<t2-t1<<" sec\n";
+#endif
+    return remove_cnt;
+}
+
+//==============================================================//
+// full coreness: every vertex gets the largest k of a k-core it belongs
+// to. return the max core
+
+#define NO_CORE 0xffffffff
+
+// batagelj-zaversnik. vertices are kept sorted by current degree in
+// "vert", with "bin" pointing at the first vertex of each degree. the
+// vertex of lowest degree is removed and each neighbor of higher degree
+// is swapped to the front of its bin and moves down one degree, O(m)
+uint32_t bz_coreness(
+        uint64_t * vertexlist, 
+        uint64_t * edgelist, 
+        uint32_t * corelist,
+        uint64_t vertex_cnt)
+{
+    double t1, t2;
+    
+    t1 = timer::get_usec();
+    vector<uint64_t> deg(vertex_cnt), pos(vertex_cnt), vert(vertex_cnt);
+    uint64_t maxdeg = 0;
+    for (uint64_t i=0;i<vertex_cnt;i++)
+    {
+        deg[i] = vertexlist[i+1]-vertexlist[i];
+        maxdeg = max(maxdeg, deg[i]);
+    }
+
+    // counting sort by degree
+    vector<uint64_t> bin(maxdeg+1, 0);
+    for (uint64_t i=0;i<vertex_cnt;i++)
+        bin[deg[i]]++;
+    uint64_t start = 0;
+    for (uint64_t d=0;d<=maxdeg;d++)
+    {
+        uint64_t num = bin[d];
+        bin[d] = start;
+        start += num;
+    }
+    for (uint64_t i=0;i<vertex_cnt;i++)
+    {
+        pos[i] = bin[deg[i]]++;
+        vert[pos[i]] = i;
+    }
+    for (uint64_t d=maxdeg;d>0;d--)
+        bin[d] = bin[d-1];
+    bin[0] = 0;
+    t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+    cout<<"== initialization time: "<<t2-t1<<" sec\n";
+#else
+    (void)t1;
+    (void)t2;
+#endif
+
+    t1 = timer::get_usec();
+#ifdef SIM
+    SIM_BEGIN(true);
+#endif    
+    uint32_t maxcore = 0;
+    for (uint64_t i=0;i<vertex_cnt;i++)
+    {
+        uint64_t vid = vert[i];
+        corelist[vid] = deg[vid];
+        maxcore = max(maxcore, corelist[vid]);
+
+        for (uint64_t j=vertexlist[vid];j<vertexlist[vid+1];j++)
+        {
+            uint64_t u = edgelist[j];
+            if (deg[u] <= deg[vid]) continue;
+
+            uint64_t du = deg[u];
+            uint64_t pu = pos[u];
+            uint64_t pw = bin[du];
+            uint64_t w = vert[pw];
+            if (u != w)
+            {
+                pos[u] = pw;
+                vert[pu] = w;
+                pos[w] = pu;
+                vert[pw] = u;
+            }
+            bin[du]++;
+            deg[u]--;
+        }
+    }
+#ifdef SIM
+    SIM_END(true);
+#endif
+    t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+    cout<<"== processing time: "<<t2-t1<<" sec\n";
+#endif
+    return maxcore;
+}
+
+// parallel peeling. level k removes the remaining vertices of degree
+// <= k in sub-rounds. only the neighbors whose degree just dropped to k
+// join the next sub-round, so a level does not rescan the graph. each
+// level starts with one scan of the remaining vertices, which also finds
+// their minimum degree: k jumps to it, so levels without vertices cost
+// nothing. the list of remaining vertices is compacted when half of it
+// is removed
+struct peel_t
+{
+    uint64_t * vertexlist; 
+    uint64_t * edgelist; 
+    uint32_t * corelist;
+    unsigned threadnum;
+
+    vector<int64_t> deg;
+    vector<uint64_t> remaining;
+    frontier front;
+    vector<int64_t> min_deg;            // per thread: minimum remaining degree
+    vector<vector<uint64_t> > min_vids; // per thread: vertices of that degree
+    uint64_t left;          // vertices without core
+    uint32_t k;             // current level
+};
+
+struct peel_arg_t
+{
+    peel_t * p;
+    unsigned tid;
+};
+
+void* peel_work(void * t)
+{
+    struct peel_arg_t * arg = (struct peel_arg_t *) t;
+    peel_t & p = *(arg->p);
+    frontier & front = p.front;
+    uint32_t * core = p.corelist;
+    unsigned tid = arg->tid;
+
+    pthread_barrier_wait (&barrier);
+#ifdef SIM
+    SIM_BEGIN(true);
+#endif        
+    while (p.left > 0)
+    {
+        uint64_t begin = p.remaining.size()*tid/p.threadnum;
+        uint64_t end = p.remaining.size()*(tid+1)/p.threadnum;
+        int64_t & local_min = p.min_deg[tid];
+        vector<uint64_t> & local_vids = p.min_vids[tid];
+        local_min = numeric_limits<int64_t>::max();
+        local_vids.clear();
+        for (uint64_t i=begin;i<end;i++)
+        {
+            uint64_t vid = p.remaining[i];
+            if (core[vid]!=NO_CORE || p.deg[vid] > local_min) continue;
+            if (p.deg[vid] < local_min) { local_min = p.deg[vid]; local_vids.clear(); }
+            local_vids.push_back(vid);
+        }
+        pthread_barrier_wait (&barrier);
+        if (tid==0)
+        {
+            // remaining degrees are all above the previous level
+            int64_t m = *min_element(p.min_deg.begin(), p.min_deg.end());
+            if (m > (int64_t)p.k) p.k = m;
+        }
+        pthread_barrier_wait (&barrier);
+        if (local_min <= (int64_t)p.k)
+        {
+            for (size_t i=0;i<local_vids.size();i++)
+                front.push(tid, local_vids[i]);
+        }
+        pthread_barrier_wait (&barrier);
+        if (tid==0) front.plan();
+        pthread_barrier_wait (&barrier);
+        front.build(tid);
+        pthread_barrier_wait (&barrier);
+
+        while (!front.empty())
+        {
+            front.range(tid, begin, end);
+            for (uint64_t i=begin;i<end;i++)
             {
-                if (global_output_tasks[i*threadnum+tid].size()!=0)
+                uint64_t vid = front[i];
+                core[vid] = p.k;
+
+                for (uint64_t j=p.vertexlist[vid];j<p.vertexlist[vid+1];j++)
                 {
-                    stop = false;
-                    input_tasks.insert(input_tasks.end(),
-                            global_output_tasks[i*threadnum+tid].begin(),
-                            global_output_tasks[i*threadnum+tid].end());
-                    global_output_tasks[i*threadnum+tid].clear();
+                    uint64_t u = p.edgelist[j];
+                    if (core[u] != NO_CORE) continue;
+                    // a vertex of this level may still be counted down
+                    if (__sync_fetch_and_sub(&(p.deg[u]), 1) == (int64_t)p.k+1)
+                        front.push(tid, u);
                 }
             }
-            #pragma omp barrier
+            pthread_barrier_wait (&barrier);
+            if (tid==0)
+            {
+                p.left -= front.size();     // processed
+                front.plan();
+            }
+            pthread_barrier_wait (&barrier);
+            front.build(tid);
+            pthread_barrier_wait (&barrier);
         }
+
+        if (tid==0)
+        {
+            p.k++;
+            if (p.remaining.size() > 2*p.left)
+            {
+                size_t cnt = 0;
+                for (size_t i=0;i<p.remaining.size();i++)
+                    if (core[p.remaining[i]]==NO_CORE) p.remaining[cnt++] = p.remaining[i];
+                p.remaining.resize(cnt);
+            }
+        }
+        pthread_barrier_wait (&barrier);
+    }
+#ifdef SIM
+    SIM_END(true);
+#endif    
+
+    return NULL;
+}
+
+uint32_t parallel_coreness(
+        uint64_t * vertexlist, 
+        uint64_t * edgelist, 
+        uint32_t * corelist,
+        uint64_t vertex_cnt, 
+        unsigned threadnum)
+{
+    double t1, t2;
+    
+    t1 = timer::get_usec();
+    peel_t p;
+    p.vertexlist = vertexlist;
+    p.edgelist = edgelist;
+    p.corelist = corelist;
+    p.threadnum = threadnum;
+    p.deg.resize(vertex_cnt);
+    p.remaining.resize(vertex_cnt);
+    for (uint64_t i=0;i<vertex_cnt;i++)
+    {
+        p.deg[i] = vertexlist[i+1]-vertexlist[i];
+        p.remaining[i] = i;
+        corelist[i] = NO_CORE;
+    }
+    p.front.init(vertex_cnt, threadnum);
+    p.min_deg.resize(threadnum);
+    p.min_vids.resize(threadnum);
+    p.left = vertex_cnt;
+    p.k = 0;
+    t2 = timer::get_usec();
+#ifndef ENABLE_VERIFY
+    cout<<"== initialization time: "<<t2-t1<<" sec\n";
+#else
+    (void)t1;
+    (void)t2;
+#endif
+
+    t1 = timer::get_usec();
+
+    pthread_barrier_init (&barrier, NULL, threadnum);
+    struct peel_arg_t args[threadnum];
+    for (unsigned t=0;t<threadnum;t++)
+    {
+        args[t].p = &p;
+        args[t].tid = t;
+    }
+#ifndef USE_OMP
+    pthread_t thread[threadnum];
+    pthread_attr_t attr; 
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+    for(unsigned t=1; t<threadnum; t++) 
+    {
+        int rc = pthread_create(&thread[t], &attr, peel_work, (&(args[t]))); 
+        if (rc) 
+        {
+            printf("ERROR; return code from pthread_create() is %d\n", rc);
+            exit(-1);
+        }
+    }
+
+    peel_work((void*) &(args[0]));
+
+    pthread_attr_destroy(&attr);
+    for(unsigned t=1; t<threadnum; t++) 
+    {
+        void* status;
+        int rc = pthread_join(thread[t], &status);
+        if (rc) 
+        {
+            printf("ERROR; return code from pthread_join() is %d\n", rc);
+            exit(-1);
+        }
+    }
+#else
+    #pragma omp parallel num_threads(threadnum)
+    {
+        peel_work((void*) &(args[omp_get_thread_num()]));
     }
 #endif
+    pthread_barrier_destroy (&barrier);
     t2 = timer::get_usec();
 #ifndef ENABLE_VERIFY
     cout<<"== processing time: "<<t2-t1<<" sec\n";
 #endif
-    return remove_cnt;
+    return (p.k>0) ? p.k-1 : 0;
 }
@@ -12,14 +12,22 @@ using namespace std;
 
 extern unsigned seq_kcore(
         uint64_t * vertexlist, 
-        uint64_t * edgelist, int16_t * vproplist,
+        uint64_t * edgelist, int64_t * vproplist,
         uint64_t vertex_cnt, uint64_t edge_cnt,
         unsigned kcore);
 extern unsigned parallel_kcore(
         uint64_t * vertexlist, 
-        uint64_t * edgelist, int16_t * vproplist,
+        uint64_t * edgelist, int64_t * vproplist,
         uint64_t vertex_cnt, uint64_t edge_cnt,
         unsigned kcore, unsigned threadnum);
+extern uint32_t bz_coreness(
+        uint64_t * vertexlist, 
+        uint64_t * edgelist, uint32_t * corelist,
+        uint64_t vertex_cnt);
+extern uint32_t parallel_coreness(
+        uint64_t * vertexlist, 
+        uint64_t * edgelist, uint32_t * corelist,
+        uint64_t vertex_cnt, unsigned threadnum);
 
 class vertex_property
 {
@@ -46,24 +54,33 @@ typedef graph_t::edge_iterator      edge_iterator;
 void arg_init(argument_parser & arg)
 {
     arg.add_arg("kcore","3","kCore k value");
+    arg.add_arg("coreness","0","full coreness of every vertex instead of peeling up to k", false);
 }
 //==============================================================//
 
 
 //==============================================================//
 
-void output(vector<int16_t> & vproplist, unsigned kcore)
+void output(vector<int64_t> & vproplist, unsigned kcore)
 {
     cout<<"kCore Results:\n";
     for(size_t i=0;i<vproplist.size();i++)
     {
         cout<<"== vertex "<<i<<": degree-"<<vproplist[i];
-        if (vproplist[i]<(int16_t)kcore)
+        if (vproplist[i]<(int64_t)kcore)
             cout<<" removed-true\n";
         else
             cout<<" removed-false\n";
     }
 }
+void output_core(vector<uint32_t> & corelist)
+{
+    cout<<"kCore Results:\n";
+    for(size_t i=0;i<corelist.size();i++)
+    {
+        cout<<"== vertex "<<i<<": core-"<<corelist[i]<<"\n";
+    }
+}
 
 //==============================================================//
 int main(int argc, char * argv[])
@@ -93,6 +110,8 @@ int main(int argc, char * argv[])
     size_t kcore,threadnum;
     arg.get_value("kcore",kcore);
     arg.get_value("threadnum",threadnum);
+    bool coreness;
+    arg.get_value("coreness",coreness);
     
     double t1, t2;
     
@@ -120,15 +139,32 @@ int main(int argc, char * argv[])
 #endif
 
     //================================================//
-    vector<int16_t> vproplist(vertex_num, 0);
+    vector<int64_t> vproplist(vertex_num, 0);
     vector<bool> rmlist(vertex_num, false);
+    vector<uint32_t> corelist;
+    if (coreness) corelist.resize(vertex_num);
     //================================================//
     
-    unsigned remove_cnt;
+    unsigned remove_cnt = 0;
+    uint32_t maxcore = 0;
     t1 = timer::get_usec();
     //================================================//
 
-    if (threadnum==1)
+    if (coreness)
+    {
+        if (threadnum==1)
+            maxcore = bz_coreness(&(vertexlist[0]), 
+                &(edgelist[0]), &(corelist[0]), 
+                vertexlist.size()-1);
+        else
+            maxcore = parallel_coreness(&(vertexlist[0]), 
+                &(edgelist[0]), &(corelist[0]), 
+                vertexlist.size()-1, threadnum);
+        // vertices outside of the k-core
+        for (size_t i=0;i<corelist.size();i++)
+            if (corelist[i] < kcore) remove_cnt++;
+    }
+    else if (threadnum==1)
         remove_cnt = seq_kcore(&(vertexlist[0]), 
             &(edgelist[0]), &(vproplist[0]), 
             vertexlist.size()-1, edgelist.size(),
@@ -145,6 +181,7 @@ int main(int argc, char * argv[])
     cout<<"\nkCore finish: \n";
     cout<<"== kcore: "<<kcore<<"\n";
     cout<<"== remove #: "<<remove_cnt<<"\n";
+    if (coreness) cout<<"== max core: "<<maxcore<<"\n";
     cout<<"== "<<vertex_num<<" vertices  "<<edge_num<<" edges\n";
 #ifndef ENABLE_VERIFY
     cout<<"== time: "<<t2-t1<<" sec\n";
@@ -152,7 +189,10 @@ int main(int argc, char * argv[])
 
 #ifdef ENABLE_OUTPUT
     cout<<"\n";
-    output(vproplist, kcore);
+    if (coreness)
+        output_core(corelist);
+    else
+        output(vproplist, kcore);
 #endif
 
     cout<<"==================================================================\n";
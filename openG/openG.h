@@ -10,15 +10,24 @@
 #include <stdint.h>
 #include <assert.h>
 #include <string>
+#include <cstring>
 #include <fstream>
+#include <deque>
+#include <limits>
+#include <cstdlib>
+#include <algorithm>
 
 #include "openG_storage.h"
 #include "openG_property.h"
 #include "openG_graph.h"
+#include "openG_file.h"
+#include "openG_snapshot.h"
 
 namespace openG
 {
 
+#define CSV_UNRESOLVED (std::numeric_limits<uint64_t>::max())
+
 
 template<class VPROP, class EPROP, class CONFIG=openG_configure<VPROP,EPROP> >
 class Graph: public adjacency_list<typename CONFIG::vertex_t, typename CONFIG::edge_t, typename CONFIG::vertexlist_t>
@@ -37,6 +46,7 @@ template<class VPROP, class EPROP, class CONFIG=openG_configure<VPROP,EPROP> >
 class extGraph: public Graph<VPROP, EPROP, CONFIG>
 {
     typedef Graph<VPROP, EPROP, CONFIG> base_t;
+    typedef typename CONFIG::vertex_t vertex_t;
 public:
     extGraph(Directness_t d=DIRECTED):base_t(d) {}
 
@@ -44,6 +54,7 @@ public:
     typedef typename base_t::vertex_iterator    vertex_iterator;
     typedef typename base_t::vproperty_t        vproperty_t;
     typedef typename base_t::eproperty_t        eproperty_t;
+    typedef typename base_t::shared_eproperty_t shared_eproperty_t;
 
     void add_vertex_key(uint64_t vid, std::string key)
     {
@@ -61,6 +72,291 @@ public:
         _id2key.erase(it);
     }
 
+    // external key of a vertex, from the key maps or the opened snapshot
+    bool get_vertex_key(uint64_t vid, std::string& key)
+    {
+        std::tr1::unordered_map<uint64_t, std::string>::iterator it;
+        it = _id2key.find(vid);
+        if (it != _id2key.end())
+        {
+            key = it->second;
+            return true;
+        }
+        if (!_snapshot.is_open()) return false;
+
+        // snapshot vertex slots are in ascending id order
+        const uint64_t * vids = _snapshot.template section<uint64_t>(_snapshot.header().vid_pos);
+        const uint64_t * end = vids + _snapshot.header().vertex_num;
+        const uint64_t * pos = std::lower_bound(vids, end, vid);
+        if (pos == end || *pos != vid) return false;
+
+        key = _snapshot.key(pos - vids);
+        return true;
+    }
+
+    // vertex id of an external key, from the key maps or the opened snapshot
+    bool get_vertex_id(const std::string& key, uint64_t& vid)
+    {
+        std::tr1::unordered_map<std::string, uint64_t>::iterator it;
+        it = _key2id.find(key);
+        if (it != _key2id.end())
+        {
+            vid = it->second;
+            return true;
+        }
+        if (!_snapshot.is_open()) return false;
+
+        uint64_t slot = _snapshot.find_key(key);
+        if (slot == _snapshot.header().vertex_num) return false;
+
+        vid = _snapshot.template section<uint64_t>(_snapshot.header().vid_pos)[slot];
+        return true;
+    }
+
+    /**
+    *   @brief save graph structure, properties and vertex keys into a
+    *          binary snapshot file (layout in openG_snapshot.h).
+    *          property columns are only saved for trivially copyable
+    *          property types
+    *   @param filename     snapshot file name
+    *   @return bool: true if success
+    */
+    //===================================================================//
+    bool save_snapshot(std::string filename)
+    {
+        bool save_vprop = __has_trivial_copy(vproperty_t);
+        bool save_eprop = __has_trivial_copy(eproperty_t);
+        uint64_t vprop_size = save_vprop ? sizeof(vproperty_t) : 0;
+        uint64_t eprop_size = save_eprop ? sizeof(eproperty_t) : 0;
+
+        std::vector<uint64_t> vids, offsets, targets, eids, key_offsets;
+        std::vector<char> vprops, eprops;
+        std::string keys;
+
+        for (vertex_iterator vit=this->vertices_begin(); vit!=this->vertices_end(); vit++)
+        {
+            vids.push_back(vit->id());
+            offsets.push_back(targets.size());
+            for (edge_iterator eit=vit->out_edges_begin(); eit!=vit->out_edges_end(); eit++)
+            {
+                targets.push_back(eit->target());
+                eids.push_back(eit->id());
+                if (save_eprop)
+                {
+                    const char * ptr = (const char*)&(eit->property());
+                    eprops.insert(eprops.end(), ptr, ptr+eprop_size);
+                }
+            }
+            if (save_vprop)
+            {
+                const char * ptr = (const char*)&(vit->property());
+                vprops.insert(vprops.end(), ptr, ptr+vprop_size);
+            }
+
+            std::string key;
+            key_offsets.push_back(keys.size());
+            if (get_vertex_key(vit->id(), key)) keys.append(key);
+        }
+        offsets.push_back(targets.size());
+        key_offsets.push_back(keys.size());
+
+        // in edges as positions of their out edge, so opening does not
+        // have to transpose the graph
+        std::vector<uint64_t> in_offsets, in_edges;
+        std::vector<uint64_t> epos(this->_eid_gen, BULK_NO_VERTEX);
+        for (size_t e=0;e<eids.size();e++)
+            if (eids[e] < epos.size()) epos[eids[e]] = e;
+        for (vertex_iterator vit=this->vertices_begin(); vit!=this->vertices_end(); vit++)
+        {
+            in_offsets.push_back(in_edges.size());
+            if (this->_directness == UNDIRECTED) continue;
+            for (edge_iterator eit=vit->in_edges_begin(); eit!=vit->in_edges_end(); eit++)
+            {
+                if (eit->id() < epos.size() && epos[eit->id()] != BULK_NO_VERTEX)
+                    in_edges.push_back(epos[eit->id()]);
+            }
+        }
+        in_offsets.push_back(in_edges.size());
+
+        std::vector<uint64_t> key_order(vids.size());
+        for (size_t i=0;i<key_order.size();i++) key_order[i] = i;
+        std::sort(key_order.begin(), key_order.end(), snapshot_key_less(keys, key_offsets));
+
+        snapshot_header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, SNAPSHOT_MAGIC, 8);
+        header.version      = SNAPSHOT_VERSION;
+        header.directness   = this->_directness;
+        header.vertex_num   = vids.size();
+        header.edge_num     = targets.size();
+        header.vid_gen      = this->_vid_gen;
+        header.eid_gen      = this->_eid_gen;
+        header.vprop_size   = vprop_size;
+        header.eprop_size   = eprop_size;
+
+        uint64_t pos = snapshot_align(sizeof(header));
+        header.vid_pos          = pos; pos = snapshot_align(pos + vids.size()*sizeof(uint64_t));
+        header.offsets_pos      = pos; pos = snapshot_align(pos + offsets.size()*sizeof(uint64_t));
+        header.targets_pos      = pos; pos = snapshot_align(pos + targets.size()*sizeof(uint64_t));
+        header.eids_pos         = pos; pos = snapshot_align(pos + eids.size()*sizeof(uint64_t));
+        header.in_offsets_pos   = pos; pos = snapshot_align(pos + in_offsets.size()*sizeof(uint64_t));
+        header.in_edges_pos     = pos; pos = snapshot_align(pos + in_edges.size()*sizeof(uint64_t));
+        header.eprops_pos       = pos; pos = snapshot_align(pos + eprops.size());
+        header.vprops_pos       = pos; pos = snapshot_align(pos + vprops.size());
+        header.key_offsets_pos  = pos; pos = snapshot_align(pos + key_offsets.size()*sizeof(uint64_t));
+        header.keys_pos         = pos; pos = snapshot_align(pos + keys.size());
+        header.key_order_pos    = pos; pos = snapshot_align(pos + key_order.size()*sizeof(uint64_t));
+        header.file_size        = pos;
+
+        std::ofstream ofs(filename.c_str(), std::ofstream::binary);
+        if (!ofs.is_open())
+        {
+            std::cerr<<"cannot open snapshot file: "<<filename<<std::endl;
+            return false;
+        }
+        snapshot_write(ofs, &header, sizeof(header));
+        snapshot_write(ofs, vids.data(), vids.size()*sizeof(uint64_t));
+        snapshot_write(ofs, offsets.data(), offsets.size()*sizeof(uint64_t));
+        snapshot_write(ofs, targets.data(), targets.size()*sizeof(uint64_t));
+        snapshot_write(ofs, eids.data(), eids.size()*sizeof(uint64_t));
+        snapshot_write(ofs, in_offsets.data(), in_offsets.size()*sizeof(uint64_t));
+        snapshot_write(ofs, in_edges.data(), in_edges.size()*sizeof(uint64_t));
+        snapshot_write(ofs, eprops.data(), eprops.size());
+        snapshot_write(ofs, vprops.data(), vprops.size());
+        snapshot_write(ofs, key_offsets.data(), key_offsets.size()*sizeof(uint64_t));
+        snapshot_write(ofs, keys.data(), keys.size());
+        snapshot_write(ofs, key_order.data(), key_order.size()*sizeof(uint64_t));
+
+        return ofs.good();
+    }
+
+    /**
+    *   @brief build the graph from a snapshot file written by
+    *          save_snapshot. the file is mmap-ed read-only and stays
+    *          mapped. only the vertex key dictionary is used in place
+    *          (zero-copy, pages shared with other processes mapping the
+    *          same file): keys are looked up in it instead of being
+    *          loaded into the key maps. vertices, edges and properties
+    *          are copied into the graph storage, which is private to the
+    *          process. the copy skips text parsing and fills each edge
+    *          list in one pass, in parallel over vertices. the graph must
+    *          be empty and have the same directness as the snapshot.
+    *          undirected twin edges get separate copies of their property.
+    *          a file whose sections or indices are out of range is
+    *          rejected before anything is copied
+    *   @param filename     snapshot file name
+    *   @param threadnum    threads filling edge lists and properties
+    *   @return bool: true if success
+    */
+    //===================================================================//
+    bool open_snapshot(std::string filename, unsigned threadnum=1)
+    {
+        if (this->_vertex_num != 0)
+        {
+            std::cerr<<"graph not empty when opening snapshot\n";
+            return false;
+        }
+        if (!_snapshot.open(filename))
+        {
+            std::cerr<<"cannot open or invalid snapshot file: "<<filename<<std::endl;
+            return false;
+        }
+
+        const snapshot_header & header = _snapshot.header();
+        if (header.directness != (uint32_t)this->_directness ||
+            (header.vprop_size != 0 && header.vprop_size != sizeof(vproperty_t)) ||
+            (header.eprop_size != 0 && header.eprop_size != sizeof(eproperty_t)))
+        {
+            std::cerr<<"snapshot does not match graph type: "<<filename<<std::endl;
+            _snapshot.close();
+            return false;
+        }
+        if (!snapshot_consistent())
+        {
+            std::cerr<<"corrupt snapshot file: "<<filename<<std::endl;
+            _snapshot.close();
+            return false;
+        }
+        if (threadnum == 0) threadnum = 1;
+
+        const uint64_t * vids    = _snapshot.template section<uint64_t>(header.vid_pos);
+        const uint64_t * offsets = _snapshot.template section<uint64_t>(header.offsets_pos);
+        const uint64_t * targets = _snapshot.template section<uint64_t>(header.targets_pos);
+        const uint64_t * eids    = _snapshot.template section<uint64_t>(header.eids_pos);
+        const uint64_t * in_offsets = _snapshot.template section<uint64_t>(header.in_offsets_pos);
+        const uint64_t * in_edges   = _snapshot.template section<uint64_t>(header.in_edges_pos);
+        const char * vprops      = _snapshot.template section<char>(header.vprops_pos);
+        const char * eprops      = _snapshot.template section<char>(header.eprops_pos);
+        uint64_t vnum = header.vertex_num;
+        uint64_t edge_num = header.edge_num;
+
+        this->_vertices.reserve(vnum);
+        for (uint64_t i=0; i<vnum; i++)
+        {
+            this->_vertices.emplace_back(vids[i]);
+            if (header.vprop_size != 0)
+                this->_vertices.back().set_property(*((const vproperty_t*)(vprops + i*header.vprop_size)));
+        }
+        this->_vertex_num = vnum;
+        this->_vid_gen = header.vid_gen;
+        this->_eid_gen = header.eid_gen;
+
+        // vertex slot i of the snapshot is vlist[i], storage may have
+        // moved vertices while pushing, so collect them afterwards
+        std::vector<vertex_t*> vlist(vnum);
+        for (uint64_t i=0; i<vnum; i++)
+            vlist[i] = &(*(this->find_vertex(vids[i])));
+
+        std::vector<shared_eproperty_t> eprop_list(edge_num);
+        uint64_t pbase = this->_eproperties.extend(edge_num);
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(threadnum)
+#endif
+        for (uint64_t e=0; e<edge_num; e++)
+        {
+            if (header.eprop_size != 0)
+                eprop_list[e] = this->_eproperties.make_at(pbase+e,
+                                    *((const eproperty_t*)(eprops + e*header.eprop_size)));
+            else
+                eprop_list[e] = this->_eproperties.make_at(pbase+e, eproperty_t());
+        }
+
+        // source vertex of each edge position, for the in edges
+        std::vector<uint64_t> sources;
+        if (this->_directness == DIRECTED)
+        {
+            sources.resize(edge_num);
+#ifdef _OPENMP
+            #pragma omp parallel for num_threads(threadnum) schedule(dynamic,256)
+#endif
+            for (uint64_t i=0; i<vnum; i++)
+                for (uint64_t e=offsets[i]; e<offsets[i+1]; e++)
+                    sources[e] = vids[i];
+        }
+
+        // reserving may allocate from a shared edge slab, keep it serial
+        for (uint64_t i=0; i<vnum; i++)
+            vlist[i]->reserve_edges(in_offsets[i+1]-in_offsets[i], offsets[i+1]-offsets[i]);
+
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(threadnum) schedule(dynamic,64)
+#endif
+        for (uint64_t i=0; i<vnum; i++)
+        {
+            vertex_t * vp = vlist[i];
+            for (uint64_t e=offsets[i]; e<offsets[i+1]; e++)
+                vp->add_out_edge(eids[e], targets[e], eprop_list[e]);
+            for (uint64_t k=in_offsets[i]; k<in_offsets[i+1]; k++)
+            {
+                uint64_t e = in_edges[k];
+                vp->add_in_edge(eids[e], sources[e], eprop_list[e]);
+            }
+        }
+        this->_edge_num = edge_num;
+
+        return true;
+    }
+
 
     /**
     *   @brief load vertices from a csv file into graph. If the
@@ -332,6 +628,178 @@ public:
         return edge_num;
     }
 
+    /**
+    *   @brief parallel version of load_csv_edges. the file is mmap-ed
+    *          and split into one byte range per thread on line
+    *          boundaries. each thread tokenizes its range without
+    *          copying cells and resolves keys in its own dictionary,
+    *          the dictionaries are merged afterward and edges are
+    *          added by build_from_edge_list. vertex ids and edge
+    *          order are the same as with load_csv_edges
+    *   @param filename     csv file name
+    *   @param has_header   if csv file has header
+    *   @param separators   separators used in the csv file
+    *   @param srcpos       column # of src vertex key (starting
+    *                       from 0)
+    *   @param destpos      column # of dest vertex key (starting
+    *                       from 0)
+    *   @param threadnum    number of loading threads. the chunks are
+    *                       processed one after another if the
+    *                       includer is not built with -fopenmp
+    *   @param dag_check    if true, checking new edges for DAG
+    *                       requirements
+    *   @return long int: if sucess, return number of processed
+    *                       edges. Otherwise, return -1.
+    */
+    //===================================================================//
+    long int load_csv_edges_parallel(std::string filename, bool has_header, std::string separators,
+                            size_t srcpos, size_t destpos, unsigned threadnum, bool dag_check=false, int weightpos=-1)
+    {
+        mapped_file file;
+        if (!file.open(filename))
+        {
+            std::cerr<<"cannot open csv file: "<<filename<<std::endl;
+            return -1;
+        }
+        if (threadnum == 0) threadnum = 1;
+
+        csv_tokenizer tokenizer(separators);
+        const char * end = file.data() + file.size();
+        const char * data = file.data();
+
+        // get csv file header
+        const char * line = data;
+        while (line<end && *line=='#') line = csv_tokenizer::next_line(line, end);
+        std::vector<csv_cell> header;
+        std::deque<std::string> header_arena;
+        size_t column_num = tokenizer.split(line, csv_tokenizer::next_line(line, end),
+                                            header, header_arena);
+        if (has_header) data = csv_tokenizer::next_line(line, end);
+
+        // split data lines into byte ranges on line boundaries
+        std::vector<const char*> bounds(threadnum+1);
+        for (unsigned t=0;t<threadnum;t++)
+        {
+            const char * pos = data + (end-data)*(uint64_t)t/threadnum;
+            bounds[t] = (t==0) ? data : csv_tokenizer::next_line(pos-1, end);
+        }
+        bounds[threadnum] = end;
+
+        // tokenize and resolve keys locally
+        std::vector<csv_chunk> chunks(threadnum);
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(threadnum) schedule(static,1)
+#endif
+        for (unsigned t=0;t<threadnum;t++)
+        {
+            csv_chunk & chunk = chunks[t];
+            std::vector<csv_cell> cells;
+            for (const char * pos=bounds[t]; pos<bounds[t+1]; )
+            {
+                const char * eol = csv_tokenizer::next_line(pos, bounds[t+1]);
+                if (*pos == '#' || tokenizer.split(pos, eol, cells, chunk.arena) == 0)
+                {
+                    pos = eol;
+                    continue;
+                }
+                pos = eol;
+
+                if (cells.size() > column_num || srcpos >= cells.size() || destpos >= cells.size())
+                {
+                    chunk.bad_lines++;
+                    continue;
+                }
+#ifdef EDGE_WEIGHT
+                if (weightpos > 0 && (size_t)weightpos >= cells.size())
+                {
+                    chunk.bad_lines++;
+                    continue;
+                }
+                if (weightpos > 0)
+                    chunk.weight.push_back(csv_atoi(cells[weightpos]));
+#endif
+                chunk.src.push_back(chunk.local_key(cells[srcpos]));
+                chunk.dest.push_back(chunk.local_key(cells[destpos]));
+            }
+
+            // keys already in the graph
+            chunk.gid.resize(chunk.keys.size(), CSV_UNRESOLVED);
+            for (size_t i=0;i<chunk.keys.size();i++)
+            {
+                std::tr1::unordered_map<std::string, uint64_t>::iterator iter;
+                iter = _key2id.find(chunk.keys[i].str());
+                if (iter != _key2id.end()) chunk.gid[i] = iter->second;
+            }
+        }
+
+        // merge dictionaries, new vertices in order of first appearance
+        size_t bad_lines=0;
+        for (unsigned t=0;t<threadnum;t++)
+        {
+            csv_chunk & chunk = chunks[t];
+            bad_lines += chunk.bad_lines;
+            for (size_t i=0;i<chunk.keys.size();i++)
+            {
+                if (chunk.gid[i] != CSV_UNRESOLVED) continue;
+
+                std::string key = chunk.keys[i].str();
+                std::tr1::unordered_map<std::string, uint64_t>::iterator iter;
+                iter = _key2id.find(key);
+                if (iter != _key2id.end())
+                {
+                    chunk.gid[i] = iter->second;
+                    continue;
+                }
+                vertex_iterator vit = this->add_vertex();
+                _key2id[key] = vit->id();
+                _id2key[vit->id()] = key;
+                chunk.gid[i] = vit->id();
+            }
+        }
+        if (bad_lines > 0)
+            std::cerr<<bad_lines<<" wrong data lines in csv file\n";
+
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(threadnum) schedule(static,1)
+#endif
+        for (unsigned t=0;t<threadnum;t++)
+        {
+            csv_chunk & chunk = chunks[t];
+            for (size_t i=0;i<chunk.src.size();i++)
+            {
+                chunk.src[i] = chunk.gid[chunk.src[i]];
+                chunk.dest[i] = chunk.gid[chunk.dest[i]];
+            }
+        }
+
+        // add edges in file order
+        std::vector<std::pair<uint64_t,uint64_t> > edges;
+        std::vector<eproperty_t> eprops;
+        for (unsigned t=0;t<threadnum;t++)
+        {
+            csv_chunk & chunk = chunks[t];
+            for (size_t i=0;i<chunk.src.size();i++)
+            {
+                if (dag_check && chunk.src[i]>=chunk.dest[i])
+                    continue; // ensure DAG property
+
+                edges.push_back(std::make_pair(chunk.src[i], chunk.dest[i]));
+#ifdef EDGE_WEIGHT
+                if (weightpos > 0)
+                {
+                    eprops.push_back(eproperty_t());
+                    eprops.back().weight = chunk.weight[i];
+                }
+#endif
+            }
+        }
+
+        if (eprops.empty())
+            return this->build_from_edge_list(edges.begin(), edges.end(), threadnum);
+        else
+            return this->build_from_edge_list(edges.begin(), edges.end(), eprops, threadnum);
+    }
+
     // convert property graph structure to a CSR graph
     void to_CSR_Graph(std::vector<uint64_t> & vertexlist,
                       std::vector<uint64_t> & edgelist)
@@ -448,9 +916,93 @@ public:
         return true;
     }
 protected:
+    // the opened snapshot (sections already bounds checked by
+    // snapshot_file) has edge lists that stay inside the edge sections
+    // and vertex ids open_snapshot can insert. the O(V+E) scan is cheap
+    // next to copying the edges
+    bool snapshot_consistent(void)
+    {
+        const snapshot_header & header = _snapshot.header();
+        const uint64_t * vids    = _snapshot.template section<uint64_t>(header.vid_pos);
+        const uint64_t * offsets = _snapshot.template section<uint64_t>(header.offsets_pos);
+        const uint64_t * targets = _snapshot.template section<uint64_t>(header.targets_pos);
+        const uint64_t * eids    = _snapshot.template section<uint64_t>(header.eids_pos);
+        const uint64_t * in_offsets = _snapshot.template section<uint64_t>(header.in_offsets_pos);
+        const uint64_t * in_edges   = _snapshot.template section<uint64_t>(header.in_edges_pos);
+        uint64_t vnum = header.vertex_num;
+        uint64_t edge_num = header.edge_num;
+        // undirected snapshots have no in edges
+        uint64_t in_num = (header.directness == DIRECTED) ? edge_num : 0;
+
+        // ascending ids are unique, get_vertex_key also relies on the order
+        for (uint64_t i=0; i<vnum; i++)
+        {
+            if (vids[i] >= header.vid_gen) return false;
+            if (i > 0 && vids[i] <= vids[i-1]) return false;
+        }
+        if (offsets[0] != 0 || offsets[vnum] != edge_num) return false;
+        if (in_offsets[0] != 0 || in_offsets[vnum] != in_num) return false;
+        for (uint64_t i=0; i<vnum; i++)
+        {
+            if (offsets[i] > offsets[i+1]) return false;
+            if (in_offsets[i] > in_offsets[i+1]) return false;
+        }
+        for (uint64_t e=0; e<edge_num; e++)
+        {
+            if (targets[e] >= header.vid_gen) return false;
+            if (eids[e] >= header.eid_gen) return false;
+        }
+        for (uint64_t k=0; k<in_num; k++)
+            if (in_edges[k] >= edge_num) return false;
+        return true;
+    }
+
     std::tr1::unordered_map<std::string, uint64_t> _key2id;
     std::tr1::unordered_map<uint64_t, std::string> _id2key;
+
+    snapshot_file _snapshot;
+
+    // per-thread state of load_csv_edges_parallel
+    class csv_chunk
+    {
+    public:
+        csv_chunk():bad_lines(0){}
+
+        uint64_t local_key(const csv_cell& cell)
+        {
+            std::tr1::unordered_map<csv_cell, uint64_t, csv_cell_hash>::iterator iter;
+            iter = key_index.find(cell);
+            if (iter != key_index.end()) return iter->second;
+
+            key_index[cell] = keys.size();
+            keys.push_back(cell);
+            return keys.size()-1;
+        }
+
+        std::tr1::unordered_map<csv_cell, uint64_t, csv_cell_hash> key_index;
+        std::vector<csv_cell> keys;     // local key index -> key
+        std::vector<uint64_t> gid;      // local key index -> vertex id
+        std::vector<uint64_t> src;
+        std::vector<uint64_t> dest;
+        std::vector<int> weight;
+        std::deque<std::string> arena;
+        size_t bad_lines;
+    };
+
+    static int csv_atoi(const csv_cell& cell)
+    {
+        return atoi(cell.str().c_str());
+    }
 private:
+    void snapshot_write(std::ofstream& ofs, const void * data, uint64_t bytes)
+    {
+        static const char padding[SNAPSHOT_ALIGN] = {0};
+
+        ofs.write((const char*)data, bytes);
+        uint64_t pos = ofs.tellp();
+        ofs.write(padding, snapshot_align(pos) - pos);
+    }
+
     size_t csv_nextCell(std::string& line, std::string sepr, std::string& ret, size_t pos=0)
     {
         sepr.append("\r\n");
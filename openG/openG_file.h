@@ -0,0 +1,176 @@
+#ifndef OPENG_FILE_H
+#define OPENG_FILE_H
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstring>
+#include <stdint.h>
+
+namespace openG
+{
+
+// read-only memory mapping of a whole file
+class mapped_file
+{
+public:
+    mapped_file():_addr(NULL),_size(0){}
+    ~mapped_file(){close();}
+
+    bool open(const std::string& filename)
+    {
+        close();
+
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void * addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) return false;
+
+        _addr = (char*)addr;
+        _size = st.st_size;
+        return true;
+    }
+
+    void close(void)
+    {
+        if (_addr != NULL) munmap(_addr, _size);
+        _addr = NULL;
+        _size = 0;
+    }
+
+    bool is_open(void){return _addr!=NULL;}
+    const char * data(void){return _addr;}
+    size_t size(void){return _size;}
+protected:
+    char * _addr;
+    size_t _size;
+private:
+    mapped_file(const mapped_file&);
+    mapped_file& operator=(const mapped_file&);
+};
+
+// a csv cell pointing into the mapped file, no copy
+class csv_cell
+{
+public:
+    csv_cell():ptr(NULL),len(0){}
+    csv_cell(const char * p, size_t l):ptr(p),len(l){}
+
+    std::string str(void) const {return std::string(ptr,len);}
+
+    bool operator==(const csv_cell& rhs) const
+    {
+        return len==rhs.len && memcmp(ptr,rhs.ptr,len)==0;
+    }
+
+    const char * ptr;
+    size_t len;
+};
+
+// FNV-1a hash of a csv cell
+class csv_cell_hash
+{
+public:
+    size_t operator()(const csv_cell& c) const
+    {
+        uint64_t h = 14695981039346656037ULL;
+        for (size_t i=0;i<c.len;i++)
+        {
+            h ^= (unsigned char)c.ptr[i];
+            h *= 1099511628211ULL;
+        }
+        return h;
+    }
+};
+
+// splits csv lines of a byte range into cells. follows the rules of
+// extGraph::csv_nextCell: runs of separators are skipped, a cell may be
+// quoted and "" in a quoted cell is a quote mark
+class csv_tokenizer
+{
+public:
+    csv_tokenizer(const std::string& separators)
+    {
+        memset(_is_sepr, 0, sizeof(_is_sepr));
+        for (size_t i=0;i<separators.size();i++)
+            _is_sepr[(unsigned char)separators[i]] = true;
+        _is_sepr[(unsigned char)'\r'] = true;
+    }
+
+    // position after the end of the line starting at pos
+    static const char * next_line(const char * pos, const char * end)
+    {
+        const char * ret = (const char*)memchr(pos, '\n', end-pos);
+        return (ret==NULL) ? end : ret+1;
+    }
+
+    // split [line, end-of-line) into cells. unescaped copies of quoted
+    // cells containing "" are kept in "arena". return # of cells
+    size_t split(const char * line, const char * eol, std::vector<csv_cell>& cells,
+                 std::deque<std::string>& arena)
+    {
+        cells.clear();
+        const char * pos = line;
+        while (true)
+        {
+            while (pos<eol && (*pos=='\n' || _is_sepr[(unsigned char)*pos])) pos++;
+            if (pos >= eol) break;
+
+            if (*pos == '\"')
+            {
+                const char * head = ++pos;
+                bool escaped = false;
+                while (pos<eol)
+                {
+                    if (*pos=='\"')
+                    {
+                        if (pos+1<eol && pos[1]=='\"') {escaped=true; pos+=2; continue;}
+                        break;
+                    }
+                    pos++;
+                }
+                if (escaped)
+                {
+                    arena.push_back(std::string());
+                    std::string & s = arena.back();
+                    for (const char * p=head; p<pos; p++)
+                    {
+                        s.push_back(*p);
+                        if (*p=='\"') p++;
+                    }
+                    cells.push_back(csv_cell(s.data(), s.size()));
+                }
+                else
+                    cells.push_back(csv_cell(head, pos-head));
+                if (pos<eol) pos++; // closing quote
+            }
+            else
+            {
+                const char * head = pos;
+                while (pos<eol && *pos!='\n' && !_is_sepr[(unsigned char)*pos]) pos++;
+                cells.push_back(csv_cell(head, pos-head));
+            }
+        }
+        return cells.size();
+    }
+protected:
+    bool _is_sepr[256];
+};
+
+}//end of namespace openG
+
+#endif
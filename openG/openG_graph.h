@@ -6,20 +6,23 @@
 #include <iterator>
 #include <list>
 #include <vector>
+#include <algorithm>
+#include <limits>
 #include <stdint.h>
 #include <assert.h>
 
 #include "openG_storage.h"
+#include "openG_lock.h"
 //#include "openG_property.h"
-#ifdef SIM
-#include "SIM.h"
-#endif
 namespace openG
 {
 
-#ifdef SIM
-#define LOCKSZ 2000000
-#endif
+// vertex lock stripes of concurrent mode
+#define MIN_LOCK_STRIPES    1024
+#define MAX_LOCK_STRIPES    (1<<22)
+#define SIM_LOCK_STRIPES    (1<<16)
+
+#define BULK_NO_VERTEX (std::numeric_limits<uint64_t>::max())
 
 enum Directness_t
 {
@@ -28,13 +31,38 @@ enum Directness_t
 };
 
 
+// each edge property is a separate heap object shared via shared_ptr
+template<class EPROP>
+class shared_eproperty_pool
+{
+public:
+    typedef typename std::tr1::shared_ptr<EPROP>  handle_t;
+    static const bool concurrent_make = true;
+
+    handle_t make(const EPROP& prop)
+    {
+        handle_t ret(new EPROP(prop));
+        return ret;
+    }
+
+    // bulk construction: extend() reserves n properties and returns the
+    // first index, make_at() may then run in parallel for each index
+    uint64_t extend(uint64_t n){return 0;}
+    handle_t make_at(uint64_t idx, const EPROP& prop)
+    {
+        return make(prop);
+    }
+};
+
 template<class EPROP>
 class edge
 {
 public:
     typedef EPROP eproperty_t;
     typedef typename std::tr1::shared_ptr<EPROP>  shared_eproperty_t;
+    typedef shared_eproperty_pool<EPROP>          eproperty_pool_t;
 
+    edge():_eid(0),_vid(0){}
     edge(uint64_t eid, uint64_t vid):_eid(eid),_vid(vid){}
     edge(uint64_t eid, uint64_t vid, const eproperty_t& prop):_eid(eid),_vid(vid)
     {
@@ -87,6 +115,119 @@ protected:
     shared_eproperty_t _eproperty; // edge property
 };
 
+template<class EPROP>
+class eproperty_column;
+
+// reference to one slot of an eproperty_column
+template<class EPROP>
+class column_eproperty_ref
+{
+public:
+    column_eproperty_ref():_column(NULL),_slot(0){}
+    column_eproperty_ref(eproperty_column<EPROP>* c, uint64_t s):_column(c),_slot(s){}
+
+    eproperty_column<EPROP> * _column;
+    uint64_t _slot;
+};
+
+// edge properties stored as one array indexed by edge slot.
+// slots of deleted edges are not reused
+template<class EPROP>
+class eproperty_column : public std::vector<EPROP>
+{
+public:
+    typedef column_eproperty_ref<EPROP> handle_t;
+    static const bool concurrent_make = false;
+
+    handle_t make(const EPROP& prop)
+    {
+        this->push_back(prop);
+        return handle_t(this, this->size()-1);
+    }
+
+    uint64_t extend(uint64_t n)
+    {
+        uint64_t ret = this->size();
+        this->resize(ret + n);
+        return ret;
+    }
+    handle_t make_at(uint64_t idx, const EPROP& prop)
+    {
+        (*this)[idx] = prop;
+        return handle_t(this, idx);
+    }
+};
+
+// edge referring to its property by slot in a per-graph column.
+// twin edges (undirected out-edge pair, directed in/out pair) share a slot
+template<class EPROP>
+class column_edge
+{
+public:
+    typedef EPROP eproperty_t;
+    typedef column_eproperty_ref<EPROP> shared_eproperty_t;
+    typedef eproperty_column<EPROP>     eproperty_pool_t;
+
+    column_edge():_eid(0),_vid(0){}
+    column_edge(uint64_t eid, uint64_t vid):_eid(eid),_vid(vid){}
+    column_edge(uint64_t eid, uint64_t vid, shared_eproperty_t& prop)
+        :_eid(eid),_vid(vid),_eproperty(prop){}
+
+    uint64_t id(void)
+    {
+        return _eid;
+    }
+    uint64_t target(void)
+    {
+        return _vid;
+    }
+    uint64_t slot(void)
+    {
+        return _eproperty._slot;
+    }
+    eproperty_t & property(void)
+    {
+        assert(_eproperty._column!=NULL);
+        return (*(_eproperty._column))[_eproperty._slot];
+    }
+
+    void set_property(const eproperty_t & prop)
+    {
+        property() = prop;
+    }
+    void set_property(shared_eproperty_t& prop)
+    {
+        _eproperty = prop;
+    }
+
+    bool has_property(void)
+    {
+        return (_eproperty._column!=NULL);
+    }
+    shared_eproperty_t& shared_property(void)
+    {
+        return _eproperty;
+    }
+protected:
+    uint64_t _eid; // edge id
+    uint64_t _vid; // id of source/target vertex
+    shared_eproperty_t _eproperty; // slot of edge property
+};
+
+// true if edge insertion into one vertex may move the edges of others
+template<class VERTEXLIST>
+class shared_edge_memory
+{
+public:
+    static const bool value = false;
+};
+template<class T, class SLAB>
+class shared_edge_memory<storage::flat_vertex_storage<T,SLAB> >
+{
+public:
+    static const bool value = true;
+};
+
 template<class VPROP, class EDGE, class edgelist_t>
 class vertex
 {
@@ -178,6 +319,13 @@ public:
         return iter;
     }
 
+    // make room for in_num/out_num more edges before bulk insertion
+    void reserve_edges(uint64_t in_num, uint64_t out_num)
+    {
+        if (in_num > 0) in_edges.reserve(in_edges.size() + in_num);
+        if (out_num > 0) out_edges.reserve(out_edges.size() + out_num);
+    }
+
     //================= Delete Edge =================//
 
     // delete edge with given eid
@@ -236,6 +384,17 @@ public:
         return ret;
     }
 
+    // delete all edges whose source/destination vertex is set in the
+    // bitmap "vmask" (indexed by vertex id), one pass over the edge list
+    uint64_t delete_in_edge_mask(const std::vector<uint64_t>& vmask)
+    {
+        return delete_edge_mask(in_edges, vmask);
+    }
+    uint64_t delete_out_edge_mask(const std::vector<uint64_t>& vmask)
+    {
+        return delete_edge_mask(out_edges, vmask);
+    }
+
     //================= Find Edge =================//
     edge_iterator find_in_edge(uint64_t eid)
     {
@@ -263,7 +422,46 @@ public:
         }
     }
 
+    //================= Edge Slab =================//
+    // only used by flat_vertex_storage (FLAT_CSR_DYN layout)
+    template<class SLAB>
+    void attach_edge_slab(SLAB* slab)
+    {
+        in_edges.attach(slab);
+        out_edges.attach(slab);
+    }
+    void release_edges(void)
+    {
+        in_edges.clear();
+        out_edges.clear();
+    }
+    template<class SLAB>
+    void relocate_edges(SLAB* slab, uint64_t slack)
+    {
+        in_edges.relocate(slab, slack);
+        out_edges.relocate(slab, slack);
+    }
+
 protected:
+    uint64_t delete_edge_mask(edgelist_t& edges, const std::vector<uint64_t>& vmask)
+    {
+        uint64_t ret=0;
+        edge_iterator iter = edges.begin();
+        while (iter != edges.end()) 
+        {
+            uint64_t targ = iter->target();
+            if ((targ>>6) >= vmask.size() || (vmask[targ>>6] & (1ULL<<(targ&63)))==0) 
+            {
+                iter++;
+                continue;
+            }
+
+            iter = edges.erase(iter);
+            ret++;
+        }
+        return ret;
+    }
+
     uint64_t _id;
     vproperty_t _vproperty;
 
@@ -280,18 +478,22 @@ public:
     typedef typename vertexlist_t::iterator vertex_iterator;
     typedef typename VERTEX::vproperty_t vproperty_t;
     typedef typename EDGE::eproperty_t eproperty_t;
+    typedef typename EDGE::shared_eproperty_t shared_eproperty_t;
+    typedef typename EDGE::eproperty_pool_t eproperty_pool_t;
 
     adjacency_list(Directness_t d=DIRECTED):_directness(d),
-        _vid_gen(0),_eid_gen(0),_vertex_num(0),_edge_num(0)
+        _vid_gen(0),_eid_gen(0),_vertex_num(0),_edge_num(0),_concurrent(false)
     {
 #ifdef SIM
-        memset(locks,0,sizeof(bool)*LOCKSZ);
+        set_concurrent(true, SIM_LOCK_STRIPES);
 #endif
     }
 
     Directness_t get_directness(void){return _directness;}
     uint64_t vertex_num(void){return _vertex_num;}
     uint64_t edge_num(void){return _edge_num;}
+    // all vertex ids are below this bound, for arrays indexed by id
+    uint64_t vid_bound(void){return _vid_gen;}
 
     vertex_iterator vertices_begin(void){return _vertices.begin();}
     vertex_iterator vertices_end(void){return _vertices.end();}
@@ -299,22 +501,51 @@ public:
     // for compatibility with IBM SystemG internal version
     uint64_t num_vertices(void){return _vertex_num;}
     uint64_t num_edges(void){return _edge_num;}
+
+    //================= Concurrent Mutation =================//
+    // when enabled, add/delete of vertices and edges may be called from
+    // several threads. edge lists are guarded by vertex locks striped
+    // over vertex ids, changes of the vertex set by a reader/writer lock.
+    // layouts whose edge insertion may move memory shared by all vertices
+    // (FLAT_CSR_DYN, column edge properties) insert edges exclusively.
+    // traversal concurrent with mutation is not supported. "stripes" is
+    // rounded up to a power of two, 0 sizes it to the current graph
+    void set_concurrent(bool enable, uint64_t stripes=0)
+    {
+#ifdef SIM
+        // simulation builds always model the locking
+        if (!enable && _concurrent) return;
+#endif
+        _concurrent = enable;
+        if (!enable) return;
+
+        if (stripes == 0)
+            stripes = std::min(std::max(_vid_gen, (uint64_t)MIN_LOCK_STRIPES),
+                               (uint64_t)MAX_LOCK_STRIPES);
+        _vlocks.resize(stripes);
+    }
+    bool is_concurrent(void){return _concurrent;}
+
     //================= Add Vertex =================//
     vertex_iterator add_vertex(void)
     {
-        _vertices.push_back(VERTEX(gen_vid()));
+        exclusive_lock();
+        _vertices.emplace_back(gen_vid());
         _vertex_num++;
         vertex_iterator iter = _vertices.end();
         iter--;
+        exclusive_unlock();
         return iter;
     }
     vertex_iterator add_vertex(const vproperty_t & vprop)
     {
-        _vertices.push_back(VERTEX(gen_vid()));
+        exclusive_lock();
+        _vertices.emplace_back(gen_vid());
         _vertex_num++;
         vertex_iterator iter = _vertices.end();
         iter--;
         iter->set_property(vprop);
+        exclusive_unlock();
         return iter;
     }
 
@@ -324,143 +555,218 @@ public:
         return _vertices.find(vid);
     }
 
+    //================= Compact Vertices =================//
+    // only available with dense vertex storage (DVV_ILE, FLAT_CSR_DYN).
+    // drop tombstones of deleted vertices. invalidates vertex iterators
+    void compact_vertices(void)
+    {
+        exclusive_lock();
+        _vertices.compact();
+        exclusive_unlock();
+    }
+
+    //================= Compact Edges =================//
+    // only available with FLAT_CSR_DYN layout. pack edge segments
+    // and reclaim slab space left by relocated/deleted segments
+    void compact_edges(uint64_t slack=0)
+    {
+        exclusive_lock();
+        _vertices.compact_edges(slack);
+        exclusive_unlock();
+    }
+
     //================= Delete Vertex =================//
     vertex_iterator delete_vertex(uint64_t vid)
     {
+        shared_lock();
         vertex_iterator viter = this->find_vertex(vid);
-        if (viter == _vertices.end()) return viter;
+        if (viter == _vertices.end())
+        {
+            shared_unlock();
+            return _vertices.end();
+        }
+
+        // neighbors are copied first, the edge lists of this vertex
+        // may change while the neighbors are updated
+        std::vector<uint64_t> preds, succs;
+        vertex_lock(vid);
+        for (edge_iterator eit=viter->in_edges_begin();
+              eit!=viter->in_edges_end();eit++) 
+            preds.push_back(eit->target());
+        for (edge_iterator eit=viter->out_edges_begin();
+              eit!=viter->out_edges_end();eit++) 
+            succs.push_back(eit->target());
+        vertex_unlock(vid);
 
-        _vertex_num--;
         if (_directness == UNDIRECTED) 
         {
             // undirected graph doesn't have in_edges
             // only need to remove target verices' corresponding out_edges
-            for (edge_iterator eit=viter->out_edges_begin();
-                  eit!=viter->out_edges_end();eit++) 
+            for (size_t i=0;i<succs.size();i++) 
             {
-                vertex_iterator vit2 = this->find_vertex(eit->target());
-                assert(vit2!=_vertices.end());
+                vertex_iterator vit2 = this->find_vertex(succs[i]);
+                if (vit2 == _vertices.end()) continue;
 
-                _edge_num -= vit2->delete_out_edge_v(vid);
+                vertex_lock(succs[i]);
+                uint64_t cnt = vit2->delete_out_edge_v(vid);
+                vertex_unlock(succs[i]);
+                sub_edge_num(cnt);
             }
-
-            return _vertices.erase(vid);
         }
         else if (_directness == DIRECTED) 
         {
             // remove out_edges of source vertices
-            for (edge_iterator eit=viter->in_edges_begin();
-                  eit!=viter->in_edges_end();eit++) 
+            for (size_t i=0;i<preds.size();i++) 
             {
-                uint64_t targ = eit->target();
-                vertex_iterator vit2 = this->find_vertex(targ);
-                assert(vit2!=_vertices.end());
-#ifdef SIM
-                SIM_LOCK(&(locks[targ]));
-#endif
-                _edge_num -= vit2->delete_out_edge_v(vid);
-#ifdef SIM
-                SIM_UNLOCK(&(locks[targ]));
-#endif
+                vertex_iterator vit2 = this->find_vertex(preds[i]);
+                if (vit2 == _vertices.end()) continue;
+
+                vertex_lock(preds[i]);
+                uint64_t cnt = vit2->delete_out_edge_v(vid);
+                vertex_unlock(preds[i]);
+                sub_edge_num(cnt);
             }
             // remove in_edges of destination vertices
-            for (edge_iterator eit=viter->out_edges_begin();
-                  eit!=viter->out_edges_end();eit++) 
+            for (size_t i=0;i<succs.size();i++) 
             {
-                uint64_t targ = eit->target();
-                vertex_iterator vit2 = this->find_vertex(targ);
-                assert(vit2!=_vertices.end());
-#ifdef SIM
-                SIM_LOCK(&(locks[targ]));
-#endif
+                vertex_iterator vit2 = this->find_vertex(succs[i]);
+                if (vit2 == _vertices.end()) continue;
+
+                vertex_lock(succs[i]);
                 vit2->delete_in_edge_v(vid);
-#ifdef SIM
-                SIM_UNLOCK(&(locks[targ]));
-#endif
+                vertex_unlock(succs[i]);
             }
-#ifdef SIM
-                SIM_LOCK(&(locks[vid]));
-#endif
-            vertex_iterator ret = _vertices.erase(vid);
-#ifdef SIM
-                SIM_UNLOCK(&(locks[vid]));
-#endif
-            return ret;
         }
+        shared_unlock();
 
-        // should not reach here
-        assert(0);
+        exclusive_lock();
+        vertex_iterator ret = this->find_vertex(vid);
+        if (ret != _vertices.end())
+        {
+            // own out edges (self loops were removed above)
+            sub_edge_num(live_out_edges(ret));
+            ret = _vertices.erase(ret);
+            _vertex_num--;
+        }
+        exclusive_unlock();
+        return ret;
+    }
+
+    //================= Delete Vertices =================//
+    // delete a batch of vertices. the batch is marked dead first, then
+    // the incident edges are removed in one parallel sweep over the
+    // live neighbors, scanning each neighbor's edge lists only once.
+    // the sweep is serial if the includer is not built with -fopenmp.
+    // vertex storages with tombstones (IVV_*, DVV_ILE, FLAT_CSR_DYN) are
+    // not compacted, call compact_vertices()/compact_edges() when
+    // convenient. return # of deleted vertices
+    uint64_t delete_vertices(const std::vector<uint64_t>& vids, unsigned threadnum=1)
+    {
+        if (threadnum == 0) threadnum = 1;
+        exclusive_lock();
+
+        // bitmap of the batch, small enough to stay in cache
+        std::vector<uint64_t> dead((_vid_gen+63)/64, 0);
+        std::vector<VERTEX*> victims;
+        for (size_t i=0;i<vids.size();i++)
+        {
+            if (vids[i] >= _vid_gen || is_marked(dead, vids[i])) continue;
+            vertex_iterator vit = this->find_vertex(vids[i]);
+            if (vit == _vertices.end()) continue;
+
+            dead[vids[i]>>6] |= 1ULL<<(vids[i]&63);
+            victims.push_back(&(*vit));
+        }
+
+        uint64_t removed = sweep_neighbors(dead, victims, threadnum);
+        for (size_t i=0;i<victims.size();i++)
+            removed += live_out_edges(victims[i]);
+        for (size_t i=0;i<victims.size();i++)
+            _vertices.erase(victims[i]->id());
+
+        _edge_num -= removed;
+        _vertex_num -= victims.size();
+        exclusive_unlock();
+        return victims.size();
     }
 
     //================= Add Edge =================//
     bool add_edge(uint64_t src, uint64_t dest, edge_iterator& eiter)
     {
+        return add_edge(src, dest, eproperty_t(), eiter);
+    }
+    // add an edge with property "eprop". in concurrent mode, this is the
+    // race free way to set the property of a new edge
+    bool add_edge(uint64_t src, uint64_t dest, const eproperty_t& eprop, edge_iterator& eiter)
+    {
+        bool exclusive = _concurrent && exclusive_edge_insertion();
+        if (exclusive) exclusive_lock();
+        else shared_lock();
+
         vertex_iterator src_iter = this->find_vertex(src);
         vertex_iterator dest_iter = this->find_vertex(dest);
         if (src_iter == _vertices.end() ||
-            dest_iter == _vertices.end()) return false;
+            dest_iter == _vertices.end()) 
+        {
+            if (exclusive) exclusive_unlock();
+            else shared_unlock();
+            return false;
+        }
+
+        shared_eproperty_t prop = _eproperties.make(eprop);
+        uint64_t eid = gen_eid();
+        if (!exclusive) vertex_lock(src);
+        eiter = src_iter->add_out_edge(eid, dest, prop);
+        if (!exclusive) vertex_unlock(src);
 
         if (_directness == UNDIRECTED) 
         {
-            uint64_t eid;
-            eproperty_t eprop;
-            eid = gen_eid();
-#ifdef SIM
-            SIM_LOCK(&(locks[src]));
-#endif      
-            eiter = src_iter->add_out_edge(eid, dest, eprop);
-#ifdef SIM
-            SIM_UNLOCK(&(locks[src]));
-#endif
-#ifdef SIM
-            __sync_fetch_and_add(&_edge_num,1);
-#else
-            _edge_num++;
-#endif
-
+            uint64_t src_eid = eid;
             eid = gen_eid();
-#ifdef SIM
-            SIM_LOCK(&(locks[dest]));
-#endif
-            dest_iter->add_out_edge(eid, src, eiter->shared_property());
-#ifdef SIM
-            SIM_UNLOCK(&(locks[dest]));
-#endif
-#ifdef SIM
-            __sync_fetch_and_add(&_edge_num,1);
-#else
-            _edge_num++;
-#endif
-            return true;
+            if (!exclusive) vertex_lock(dest);
+            dest_iter->add_out_edge(eid, src, prop);
+            // a self loop may have moved the edge list (FLAT_CSR_DYN)
+            if (src == dest) eiter = src_iter->find_out_edge(src_eid);
+            if (!exclusive) vertex_unlock(dest);
+            add_edge_num(2);
         }
-        else if (_directness == DIRECTED) 
+        else
         {
-            uint64_t eid;
-            eproperty_t eprop;
-            eid = gen_eid();
-#ifdef SIM
-            SIM_LOCK(&(locks[src]));
-#endif
-            eiter = src_iter->add_out_edge(eid, dest, eprop);
-#ifdef SIM
-            SIM_UNLOCK(&(locks[src]));
-#endif
-#ifdef SIM
-            SIM_LOCK(&(locks[dest]));
-#endif
-            dest_iter->add_in_edge(eid, src, eiter->shared_property());
-#ifdef SIM
-            SIM_UNLOCK(&(locks[dest]));
-#endif
-#ifdef SIM
-            __sync_fetch_and_add(&_edge_num,1);
-#else
-            _edge_num++;
-#endif
-            return true;
+            if (!exclusive) vertex_lock(dest);
+            dest_iter->add_in_edge(eid, src, prop);
+            if (!exclusive) vertex_unlock(dest);
+            add_edge_num(1);
         }
-        
-        return false;
+
+        if (exclusive) exclusive_unlock();
+        else shared_unlock();
+        return true;
+    }
+
+    //================= Bulk Build =================//
+    // add a whole edge list at once instead of calling add_edge per edge.
+    // ITER is a random access iterator over std::pair<uint64_t,uint64_t>
+    // (src vid, dest vid). end points are resolved, edges are counted and
+    // scattered into per-vertex buckets in parallel, and each edge list is
+    // reserved once and filled by one thread. edges with unknown end
+    // points are skipped. the graph is the same as after calling add_edge
+    // in input order, or in (src, dest) order if sort_by_source is set.
+    // threadnum only has an effect if the includer is built with -fopenmp.
+    // return # of added edges
+    template<class ITER>
+    uint64_t build_from_edge_list(ITER begin, ITER end, unsigned threadnum=1,
+                                  bool sort_by_source=false)
+    {
+        return bulk_build(begin, end, (const eproperty_t*)NULL, threadnum, sort_by_source);
+    }
+    // same as above, edge i gets property props[i]
+    template<class ITER>
+    uint64_t build_from_edge_list(ITER begin, ITER end, const std::vector<eproperty_t>& props,
+                                  unsigned threadnum=1, bool sort_by_source=false)
+    {
+        assert(props.size() >= (size_t)(end-begin));
+        return bulk_build(begin, end, props.empty() ? NULL : &(props[0]),
+                          threadnum, sort_by_source);
     }
 
 
@@ -487,81 +793,385 @@ public:
     {
         vertex_iterator src_iter, dest_iter;
         edge_iterator eiter;
+        bool ret = false;
 
+        shared_lock();
         src_iter = this->find_vertex(src);
-        if (src_iter == _vertices.end()) return false;
-        eiter = src_iter->find_out_edge(eid);
-        if (eiter == src_iter->out_edges_end()) return false;
-        dest_iter = this->find_vertex(eiter->target());
-        if (dest_iter == _vertices.end()) return false;
-
-        if (_directness == UNDIRECTED) 
-        {
-            next_eiter = src_iter->delete_out_edge(eid);
-            dest_iter->delete_out_edge(eid);
-            _edge_num--;
-            return true;
-        }
-        else if (_directness == DIRECTED) 
+        if (src_iter != _vertices.end())
         {
-            next_eiter = src_iter->delete_out_edge(eid);
-            dest_iter->delete_in_edge(eid);
-            _edge_num--;
-            return true;
+            vertex_lock(src);
+            eiter = src_iter->find_out_edge(eid);
+            if (eiter != src_iter->out_edges_end())
+            {
+                uint64_t dest = eiter->target();
+                next_eiter = src_iter->delete_out_edge(eid);
+                ret = true;
+                vertex_unlock(src);
+
+                dest_iter = this->find_vertex(dest);
+                if (dest_iter != _vertices.end())
+                {
+                    vertex_lock(dest);
+                    if (_directness == UNDIRECTED) 
+                        dest_iter->delete_out_edge(eid);
+                    else
+                        dest_iter->delete_in_edge(eid);
+                    vertex_unlock(dest);
+                }
+                sub_edge_num(1);
+            }
+            else
+                vertex_unlock(src);
         }
-        return false;
+        shared_unlock();
+        return ret;
     }
     bool delete_edge_v(uint64_t src, uint64_t dest)
     {
         vertex_iterator src_iter, dest_iter;
 
+        shared_lock();
         src_iter = this->find_vertex(src);
-        if (src_iter == _vertices.end()) return false;
         dest_iter = this->find_vertex(dest);
-        if (dest_iter == _vertices.end()) return false;
+        if (src_iter == _vertices.end() || dest_iter == _vertices.end())
+        {
+            shared_unlock();
+            return false;
+        }
 
+        uint64_t cnt;
         if (_directness == UNDIRECTED) 
         {
-            _edge_num -= src_iter->delete_out_edge_v(dest);
-            _edge_num -= dest_iter->delete_out_edge_v(src);
-
-            return true;
+            vertex_lock(src);
+            cnt = src_iter->delete_out_edge_v(dest);
+            vertex_unlock(src);
+            sub_edge_num(cnt);
+            vertex_lock(dest);
+            cnt = dest_iter->delete_out_edge_v(src);
+            vertex_unlock(dest);
+            sub_edge_num(cnt);
         }
-        else if (_directness == DIRECTED) 
+        else
         {
-            _edge_num -= src_iter->delete_out_edge(dest);
-            _edge_num -= dest_iter->delete_in_edge(src);
-
-            return true;
+            vertex_lock(src);
+            cnt = src_iter->delete_out_edge_v(dest);
+            vertex_unlock(src);
+            sub_edge_num(cnt);
+            vertex_lock(dest);
+            dest_iter->delete_in_edge_v(src);
+            vertex_unlock(dest);
         }
-
-        return false;
+        shared_unlock();
+        return true;
     }
 protected:
     // local functions
     uint64_t gen_vid(void)
     {
-#ifdef SIM
-        return __sync_fetch_and_add(&_vid_gen, 1);
-#else
+        if (_concurrent) return __sync_fetch_and_add(&_vid_gen, 1);
+
         uint64_t ret = _vid_gen;
         _vid_gen++;
         return ret;
-#endif
     }
     uint64_t gen_eid(void)
     {
-#ifdef SIM
-        return __sync_fetch_and_add(&_eid_gen, 1);
-#else
+        if (_concurrent) return __sync_fetch_and_add(&_eid_gen, 1);
+
         uint64_t ret = _eid_gen;
         _eid_gen++;
         return ret;
+    }
+    void add_edge_num(uint64_t n)
+    {
+        if (_concurrent) __sync_fetch_and_add(&_edge_num, n);
+        else _edge_num += n;
+    }
+    void sub_edge_num(uint64_t n)
+    {
+        if (n == 0) return;
+        if (_concurrent) __sync_fetch_and_sub(&_edge_num, n);
+        else _edge_num -= n;
+    }
+
+    // remove the edges from live vertices to the "dead" batch. each
+    // neighbor is visited once: predecessors of the batch get their out
+    // edges swept, successors their in edges. return # of removed edges
+    uint64_t sweep_neighbors(const std::vector<uint64_t>& dead,
+                             const std::vector<VERTEX*>& victims, unsigned threadnum)
+    {
+        std::vector<uint64_t> sweep_out(dead.size(), 0), sweep_in(dead.size(), 0);
+        std::vector<uint64_t>& succ_sweep = (_directness == DIRECTED) ? sweep_in : sweep_out;
+        std::vector<uint64_t> nbrs;
+        for (size_t i=0;i<victims.size();i++)
+        {
+            VERTEX * vp = victims[i];
+            for (edge_iterator eit=vp->in_edges_begin();eit!=vp->in_edges_end();eit++)
+            {
+                uint64_t targ = eit->target();
+                if (is_marked(dead, targ)) continue;
+                if (!is_marked(sweep_out, targ) && !is_marked(sweep_in, targ)) nbrs.push_back(targ);
+                sweep_out[targ>>6] |= 1ULL<<(targ&63);
+            }
+            for (edge_iterator eit=vp->out_edges_begin();eit!=vp->out_edges_end();eit++)
+            {
+                uint64_t targ = eit->target();
+                if (is_marked(dead, targ)) continue;
+                if (!is_marked(sweep_out, targ) && !is_marked(sweep_in, targ)) nbrs.push_back(targ);
+                succ_sweep[targ>>6] |= 1ULL<<(targ&63);
+            }
+        }
+
+        uint64_t removed=0;
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(threadnum) schedule(dynamic,64) reduction(+:removed)
 #endif
+        for (size_t i=0;i<nbrs.size();i++)
+        {
+            vertex_iterator vit = this->find_vertex(nbrs[i]);
+            if (is_marked(sweep_out, nbrs[i])) removed += vit->delete_out_edge_mask(dead);
+            if (is_marked(sweep_in, nbrs[i])) vit->delete_in_edge_mask(dead);
+        }
+        return removed;
     }
+    bool is_marked(const std::vector<uint64_t>& bitmap, uint64_t vid)
+    {
+        return (bitmap[vid>>6] & (1ULL<<(vid&63))) != 0;
+    }
+
+    // out_edges_size() of indexed vector storage includes deleted edges
+    template<class VPTR>
+    uint64_t live_out_edges(VPTR vp)
+    {
+        uint64_t ret=0;
+        for (edge_iterator eit=vp->out_edges_begin();eit!=vp->out_edges_end();eit++)
+            ret++;
+        return ret;
+    }
+
+    // locking of concurrent mode, no-ops otherwise.
+    // vertex set changes hold the exclusive lock, edge list changes
+    // hold the shared lock plus the lock of the modified vertex
+    void shared_lock(void){if (_concurrent) _vset_lock.read_lock();}
+    void shared_unlock(void){if (_concurrent) _vset_lock.read_unlock();}
+    void exclusive_lock(void){if (_concurrent) _vset_lock.write_lock();}
+    void exclusive_unlock(void){if (_concurrent) _vset_lock.write_unlock();}
+    void vertex_lock(uint64_t vid){if (_concurrent) _vlocks.lock(vid);}
+    void vertex_unlock(uint64_t vid){if (_concurrent) _vlocks.unlock(vid);}
+
+    // edge insertion may reallocate memory shared by all vertices
+    bool exclusive_edge_insertion(void)
+    {
+        return shared_edge_memory<vertexlist_t>::value ||
+               !eproperty_pool_t::concurrent_make;
+    }
+
+    template<class ITER>
+    uint64_t bulk_build(ITER begin, ITER end, const eproperty_t* props,
+                        unsigned threadnum, bool sort_by_source)
+    {
+        if (threadnum == 0) threadnum = 1;
+        uint64_t input_num = end - begin;
+        exclusive_lock();
+
+        // dense vertex index
+        std::vector<VERTEX*> vlist;
+        std::vector<uint64_t> vindex(_vid_gen, BULK_NO_VERTEX);
+        for (vertex_iterator vit=_vertices.begin(); vit!=_vertices.end(); vit++)
+        {
+            if (vit->id() >= vindex.size())
+                vindex.resize(vit->id()+1, BULK_NO_VERTEX);
+            vindex[vit->id()] = vlist.size();
+            vlist.push_back(&(*vit));
+        }
+        uint64_t vnum = vlist.size();
+
+        std::vector<uint64_t> src(input_num), dest(input_num);
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(threadnum)
+#endif
+        for (uint64_t i=0;i<input_num;i++)
+        {
+            uint64_t s = begin[i].first;
+            uint64_t d = begin[i].second;
+            src[i] = (s < vindex.size()) ? vindex[s] : BULK_NO_VERTEX;
+            dest[i] = (d < vindex.size()) ? vindex[d] : BULK_NO_VERTEX;
+            if (src[i] == BULK_NO_VERTEX || dest[i] == BULK_NO_VERTEX)
+                src[i] = dest[i] = BULK_NO_VERTEX;
+        }
+
+        // insertion order of the valid edges
+        std::vector<uint64_t> order;
+        if (sort_by_source)
+        {
+            std::vector<uint64_t> offsets;
+            bulk_bucket(src, vnum, threadnum, offsets, order);
+#ifdef _OPENMP
+            #pragma omp parallel for num_threads(threadnum) schedule(dynamic,256)
+#endif
+            for (uint64_t v=0;v<vnum;v++)
+            {
+                bulk_dest_less<ITER> less(begin);
+                std::stable_sort(order.begin()+offsets[v], order.begin()+offsets[v+1], less);
+            }
+        }
+        else
+        {
+            order.reserve(input_num);
+            for (uint64_t i=0;i<input_num;i++)
+                if (src[i] != BULK_NO_VERTEX) order.push_back(i);
+        }
+        uint64_t edge_num = order.size();
+
+        std::vector<shared_eproperty_t> eprops(edge_num);
+        uint64_t pbase = _eproperties.extend(edge_num);
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(threadnum)
+#endif
+        for (uint64_t r=0;r<edge_num;r++)
+        {
+            eprops[r] = _eproperties.make_at(pbase+r,
+                            (props==NULL) ? eproperty_t() : props[order[r]]);
+        }
+
+        // bucket edge ends per vertex. in each bucket, items are in
+        // insertion order, the same order add_edge would append them
+        uint64_t eid_base = _eid_gen;
+        std::vector<uint64_t> out_keys, in_keys;
+        std::vector<uint64_t> out_offsets, out_items, in_offsets, in_items;
+        if (_directness == UNDIRECTED)
+        {
+            // item 2r: out edge of src, item 2r+1: out edge of dest
+            out_keys.resize(2*edge_num);
+#ifdef _OPENMP
+            #pragma omp parallel for num_threads(threadnum)
+#endif
+            for (uint64_t r=0;r<edge_num;r++)
+            {
+                out_keys[2*r] = src[order[r]];
+                out_keys[2*r+1] = dest[order[r]];
+            }
+            bulk_bucket(out_keys, vnum, threadnum, out_offsets, out_items);
+            in_offsets.assign(vnum+1, 0);
+        }
+        else
+        {
+            out_keys.resize(edge_num);
+            in_keys.resize(edge_num);
+#ifdef _OPENMP
+            #pragma omp parallel for num_threads(threadnum)
+#endif
+            for (uint64_t r=0;r<edge_num;r++)
+            {
+                out_keys[r] = src[order[r]];
+                in_keys[r] = dest[order[r]];
+            }
+            bulk_bucket(out_keys, vnum, threadnum, out_offsets, out_items);
+            bulk_bucket(in_keys, vnum, threadnum, in_offsets, in_items);
+        }
+
+        // reserving may allocate from a shared edge slab, keep it serial
+        for (uint64_t v=0;v<vnum;v++)
+        {
+            vlist[v]->reserve_edges(in_offsets[v+1]-in_offsets[v],
+                                    out_offsets[v+1]-out_offsets[v]);
+        }
+
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(threadnum) schedule(dynamic,64)
+#endif
+        for (uint64_t v=0;v<vnum;v++)
+        {
+            VERTEX * vp = vlist[v];
+            for (uint64_t k=out_offsets[v];k<out_offsets[v+1];k++)
+            {
+                uint64_t item = out_items[k];
+                if (_directness == UNDIRECTED)
+                {
+                    uint64_t r = item/2;
+                    uint64_t targ = (item%2==0) ? begin[order[r]].second : begin[order[r]].first;
+                    vp->add_out_edge(eid_base+item, targ, eprops[r]);
+                }
+                else
+                {
+                    vp->add_out_edge(eid_base+item, begin[order[item]].second, eprops[item]);
+                }
+            }
+            for (uint64_t k=in_offsets[v];k<in_offsets[v+1];k++)
+            {
+                uint64_t item = in_items[k];
+                vp->add_in_edge(eid_base+item, begin[order[item]].first, eprops[item]);
+            }
+        }
+
+        if (_directness == UNDIRECTED)
+        {
+            _eid_gen += 2*edge_num;
+            _edge_num += 2*edge_num;
+        }
+        else
+        {
+            _eid_gen += edge_num;
+            _edge_num += edge_num;
+        }
+        exclusive_unlock();
+        return edge_num;
+    }
+
+    // parallel counting sort of items 0..n-1 into buckets keys[i].
+    // bucket b gets items[offsets[b]..offsets[b+1]) in ascending order.
+    // items with key BULK_NO_VERTEX are dropped
+    void bulk_bucket(const std::vector<uint64_t>& keys, uint64_t bucket_num, unsigned threadnum,
+                     std::vector<uint64_t>& offsets, std::vector<uint64_t>& items)
+    {
+        uint64_t n = keys.size();
+        offsets.assign(bucket_num+1, 0);
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(threadnum)
+#endif
+        for (uint64_t i=0;i<n;i++)
+        {
+            if (keys[i] != BULK_NO_VERTEX)
+                __sync_fetch_and_add(&(offsets[keys[i]+1]), 1);
+        }
+        for (uint64_t b=0;b<bucket_num;b++)
+            offsets[b+1] += offsets[b];
+
+        std::vector<uint64_t> cursor(offsets.begin(), offsets.end()-1);
+        items.resize(offsets[bucket_num]);
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(threadnum)
+#endif
+        for (uint64_t i=0;i<n;i++)
+        {
+            if (keys[i] != BULK_NO_VERTEX)
+                items[__sync_fetch_and_add(&(cursor[keys[i]]), 1)] = i;
+        }
+
+#ifdef _OPENMP
+        #pragma omp parallel for num_threads(threadnum) schedule(dynamic,256)
+#endif
+        for (uint64_t b=0;b<bucket_num;b++)
+            std::sort(items.begin()+offsets[b], items.begin()+offsets[b+1]);
+    }
+
+    // orders input edges by dest vid
+    template<class ITER>
+    class bulk_dest_less
+    {
+    public:
+        bulk_dest_less(ITER begin):_begin(begin){}
+        bool operator()(uint64_t a, uint64_t b)
+        {
+            return _begin[a].second < _begin[b].second;
+        }
+    protected:
+        ITER _begin;
+    };
 protected:
     // local variables
     vertexlist_t _vertices;
+    eproperty_pool_t _eproperties;
     
     Directness_t _directness; 
     uint64_t _vid_gen;
@@ -569,9 +1179,10 @@ protected:
 
     uint64_t _vertex_num;
     uint64_t _edge_num;
-#ifdef SIM
-    bool locks[LOCKSZ];
-#endif
+
+    bool _concurrent;
+    rw_spinlock _vset_lock;
+    vertex_locks _vlocks;
 };
 
 
@@ -0,0 +1,115 @@
+#ifndef OPENG_LOCK_H
+#define OPENG_LOCK_H
+
+#include <vector>
+#include <stdint.h>
+#include <sched.h>
+#ifdef SIM
+#include "SIM.h"
+#endif
+
+namespace openG
+{
+
+// spins before a waiting thread yields its cpu
+#define SPIN_YIELD_COUNT 1024
+
+inline void spin_wait(unsigned & cnt)
+{
+    if (++cnt < SPIN_YIELD_COUNT) return;
+    cnt = 0;
+    sched_yield();
+}
+
+// test-and-test-and-set spinlock on a bool, the lock word of SIM_LOCK
+inline void spin_lock(bool * l)
+{
+#ifdef SIM
+    SIM_LOCK(l);
+#else
+    unsigned cnt=0;
+    while (__sync_lock_test_and_set(l, 1))
+    {
+        while (*((volatile bool*)l)) spin_wait(cnt);
+    }
+#endif
+}
+
+inline void spin_unlock(bool * l)
+{
+#ifdef SIM
+    SIM_UNLOCK(l);
+#else
+    __sync_lock_release(l);
+#endif
+}
+
+// spinlocks striped over vertex ids. the stripe # is a power of two,
+// so any vertex id maps to a lock
+class vertex_locks
+{
+public:
+    vertex_locks():_mask(0){}
+
+    void resize(uint64_t n)
+    {
+        uint64_t num=1;
+        while (num < n) num <<= 1;
+        _locks.assign(num, lock_t());
+        _mask = num - 1;
+    }
+    uint64_t size(void){return _locks.size();}
+
+    void lock(uint64_t vid){spin_lock(&(_locks[vid & _mask].flag));}
+    void unlock(uint64_t vid){spin_unlock(&(_locks[vid & _mask].flag));}
+protected:
+    class lock_t
+    {
+    public:
+        lock_t():flag(false){}
+        bool flag;
+    };
+    std::vector<lock_t> _locks;
+    uint64_t _mask;
+};
+
+// reader/writer spinlock. a waiting writer blocks new readers
+class rw_spinlock
+{
+public:
+    rw_spinlock():_state(0),_writers(0){}
+
+    void read_lock(void)
+    {
+        unsigned cnt=0;
+        while (true)
+        {
+            while (_writers > 0 || _state < 0) spin_wait(cnt);
+            int32_t s = _state;
+            if (s >= 0 && __sync_bool_compare_and_swap(&_state, s, s+1)) return;
+        }
+    }
+    void read_unlock(void)
+    {
+        __sync_fetch_and_sub(&_state, 1);
+    }
+
+    void write_lock(void)
+    {
+        unsigned cnt=0;
+        __sync_fetch_and_add(&_writers, 1);
+        while (!__sync_bool_compare_and_swap(&_state, 0, -1)) spin_wait(cnt);
+        __sync_fetch_and_sub(&_writers, 1);
+    }
+    void write_unlock(void)
+    {
+        __sync_lock_release(&_state);
+    }
+protected:
+    volatile int32_t _state;    // # of readers, -1 if held by a writer
+    volatile int32_t _writers;  // # of waiting writers
+};
+
+}//end of namespace openG
+
+#endif
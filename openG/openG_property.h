@@ -22,90 +22,150 @@ enum GLayout
     IVV_IVE=2,  //  vertexlist->indexed_vector  edgelist->indexed_vector
     VV_VE=3,    //  vertexlist->vector          edgelist->vector
     ILV_IVE=4,  //  vertexlist->indexed_list    edgelist->indexed_vector
-    IVV_ILE=5
+    IVV_ILE=5,
+    FLAT_CSR_DYN=6, //  vertexlist->dense_vector    edgelist->segments of one edge slab
+    DVV_ILE=7       //  vertexlist->dense_vector    edgelist->indexed_list
+};
+
+enum EPLayout
+{
+    EP_SHARED=0,    //  one shared_ptr heap object per edge property
+    EP_COLUMN=1     //  edge properties in one column array indexed by slot
+};
+
+#ifdef EPROP_COLUMN
+#define DEFAULT_EPLAYOUT EP_COLUMN
+#else
+#define DEFAULT_EPLAYOUT EP_SHARED
+#endif
+
+template<class EPROP, EPLayout P>
+class edge_selector;
+
+template<class EPROP>
+class edge_selector<EPROP,EP_SHARED>
+{
+public:
+    typedef typename openG::edge<EPROP>         edge_t;
+};
+template<class EPROP>
+class edge_selector<EPROP,EP_COLUMN>
+{
+public:
+    typedef typename openG::column_edge<EPROP>  edge_t;
 };
 
 #ifdef TRAITS_LL
-template<class VPROP, class EPROP, GLayout L=ILV_ILE>
+template<class VPROP, class EPROP, GLayout L=ILV_ILE, EPLayout P=DEFAULT_EPLAYOUT>
 class openG_configure;
 #elif defined(TRAITS_VV)
-template<class VPROP, class EPROP, GLayout L=IVV_IVE>
+template<class VPROP, class EPROP, GLayout L=IVV_IVE, EPLayout P=DEFAULT_EPLAYOUT>
 class openG_configure;
 #elif defined(TRAITS_LV)
-template<class VPROP, class EPROP, GLayout L=ILV_IVE>
+template<class VPROP, class EPROP, GLayout L=ILV_IVE, EPLayout P=DEFAULT_EPLAYOUT>
 class openG_configure;
 #elif defined(TRAITS_VL)
-template<class VPROP, class EPROP, GLayout L=IVV_ILE>
+template<class VPROP, class EPROP, GLayout L=IVV_ILE, EPLayout P=DEFAULT_EPLAYOUT>
 class openG_configure;
 #elif defined(TRAITS_LL_S) 
-template<class VPROP, class EPROP, GLayout L=LV_LE>
+template<class VPROP, class EPROP, GLayout L=LV_LE, EPLayout P=DEFAULT_EPLAYOUT>
+class openG_configure;
+#elif defined(TRAITS_DL)
+template<class VPROP, class EPROP, GLayout L=DVV_ILE, EPLayout P=DEFAULT_EPLAYOUT>
+class openG_configure;
+#elif defined(TRAITS_FLAT)
+template<class VPROP, class EPROP, GLayout L=FLAT_CSR_DYN, EPLayout P=DEFAULT_EPLAYOUT>
 class openG_configure;
 #else
-template<class VPROP, class EPROP, GLayout L=ILV_ILE>
+template<class VPROP, class EPROP, GLayout L=ILV_ILE, EPLayout P=DEFAULT_EPLAYOUT>
 class openG_configure;
 #endif
 
 
-template<class VPROP, class EPROP>
-class openG_configure<VPROP,EPROP,ILV_ILE>
+template<class VPROP, class EPROP, EPLayout P>
+class openG_configure<VPROP,EPROP,ILV_ILE,P>
 {
 public:
     typedef VPROP       vproperty_t;
     typedef EPROP       eproperty_t;
 
-    typedef typename openG::edge<eproperty_t>                       edge_t;
+    typedef typename edge_selector<eproperty_t,P>::edge_t           edge_t;
     typedef typename openG::storage::indexed_list_storage<edge_t>   edgelist_t;
     typedef typename openG::vertex<vproperty_t, edge_t, edgelist_t> vertex_t;
     typedef typename openG::storage::indexed_list_storage<vertex_t> vertexlist_t;
 };
-template<class VPROP, class EPROP>
-class openG_configure<VPROP,EPROP,IVV_IVE>
+template<class VPROP, class EPROP, EPLayout P>
+class openG_configure<VPROP,EPROP,IVV_IVE,P>
 {
 public:
     typedef VPROP       vproperty_t;
     typedef EPROP       eproperty_t;
 
-    typedef typename openG::edge<eproperty_t>                       edge_t;
+    typedef typename edge_selector<eproperty_t,P>::edge_t           edge_t;
     typedef typename openG::storage::indexed_vector_storage<edge_t>   edgelist_t;
     typedef typename openG::vertex<vproperty_t, edge_t, edgelist_t> vertex_t;
     typedef typename openG::storage::indexed_vector_storage<vertex_t> vertexlist_t;
 };
-template<class VPROP, class EPROP>
-class openG_configure<VPROP,EPROP,ILV_IVE>
+template<class VPROP, class EPROP, EPLayout P>
+class openG_configure<VPROP,EPROP,ILV_IVE,P>
 {
 public:
     typedef VPROP       vproperty_t;
     typedef EPROP       eproperty_t;
 
-    typedef typename openG::edge<eproperty_t>                       edge_t;
+    typedef typename edge_selector<eproperty_t,P>::edge_t           edge_t;
     typedef typename openG::storage::indexed_vector_storage<edge_t>   edgelist_t;
     typedef typename openG::vertex<vproperty_t, edge_t, edgelist_t> vertex_t;
     typedef typename openG::storage::indexed_list_storage<vertex_t> vertexlist_t;
 };
-template<class VPROP, class EPROP>
-class openG_configure<VPROP,EPROP,IVV_ILE>
+template<class VPROP, class EPROP, EPLayout P>
+class openG_configure<VPROP,EPROP,IVV_ILE,P>
 {
 public:
     typedef VPROP       vproperty_t;
     typedef EPROP       eproperty_t;
 
-    typedef typename openG::edge<eproperty_t>                       edge_t;
+    typedef typename edge_selector<eproperty_t,P>::edge_t           edge_t;
     typedef typename openG::storage::indexed_list_storage<edge_t>   edgelist_t;
     typedef typename openG::vertex<vproperty_t, edge_t, edgelist_t> vertex_t;
     typedef typename openG::storage::indexed_vector_storage<vertex_t> vertexlist_t;
 };
-template<class VPROP, class EPROP>
-class openG_configure<VPROP,EPROP,LV_LE>
+template<class VPROP, class EPROP, EPLayout P>
+class openG_configure<VPROP,EPROP,LV_LE,P>
 {
 public:
     typedef VPROP       vproperty_t;
     typedef EPROP       eproperty_t;
 
-    typedef typename openG::edge<eproperty_t>                       edge_t;
+    typedef typename edge_selector<eproperty_t,P>::edge_t           edge_t;
     typedef typename openG::storage::list_storage<edge_t>   edgelist_t;
     typedef typename openG::vertex<vproperty_t, edge_t, edgelist_t> vertex_t;
     typedef typename openG::storage::list_storage<vertex_t> vertexlist_t;
 };
+template<class VPROP, class EPROP, EPLayout P>
+class openG_configure<VPROP,EPROP,DVV_ILE,P>
+{
+public:
+    typedef VPROP       vproperty_t;
+    typedef EPROP       eproperty_t;
+
+    typedef typename edge_selector<eproperty_t,P>::edge_t           edge_t;
+    typedef typename openG::storage::indexed_list_storage<edge_t>   edgelist_t;
+    typedef typename openG::vertex<vproperty_t, edge_t, edgelist_t> vertex_t;
+    typedef typename openG::storage::dense_vector_storage<vertex_t> vertexlist_t;
+};
+template<class VPROP, class EPROP, EPLayout P>
+class openG_configure<VPROP,EPROP,FLAT_CSR_DYN,P>
+{
+public:
+    typedef VPROP       vproperty_t;
+    typedef EPROP       eproperty_t;
+
+    typedef typename edge_selector<eproperty_t,P>::edge_t           edge_t;
+    typedef typename openG::storage::flat_edge_storage<edge_t>      edgelist_t;
+    typedef typename openG::vertex<vproperty_t, edge_t, edgelist_t> vertex_t;
+    typedef typename openG::storage::flat_vertex_storage<vertex_t, typename edgelist_t::slab_t> vertexlist_t;
+};
 }
 
 #endif
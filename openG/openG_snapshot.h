@@ -0,0 +1,201 @@
+#ifndef OPENG_SNAPSHOT_H
+#define OPENG_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <stdint.h>
+
+#include "openG_file.h"
+
+namespace openG
+{
+
+#define SNAPSHOT_MAGIC      "OPENGSNP"
+#define SNAPSHOT_VERSION    2
+#define SNAPSHOT_ALIGN      8
+
+// On-disk layout of a graph snapshot. All sections start at a
+// SNAPSHOT_ALIGN aligned byte offset from the beginning of the file.
+//
+//  header
+//  vid         uint64[vertex_num]      vertex id of each vertex slot
+//  offsets     uint64[vertex_num+1]    CSR offsets of out edges
+//  targets     uint64[edge_num]        target vertex id of each edge
+//  eids        uint64[edge_num]        edge id of each edge
+//  in_offsets  uint64[vertex_num+1]    CSR offsets of in edges, all 0 if undirected
+//  in_edges    uint64[]                out edge position of each in edge
+//  eprops      eprop_size*edge_num     raw edge property column
+//  vprops      vprop_size*vertex_num   raw vertex property column
+//  key_offsets uint64[vertex_num+1]    key of slot i is keys[key_offsets[i]..[i+1])
+//  keys        char[]                  concatenated external vertex keys
+//  key_order   uint64[vertex_num]      slots sorted by key, for key lookup
+//
+// eprop_size/vprop_size are 0 if the property type is not trivially
+// copyable and its column was not saved.
+struct snapshot_header
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t directness;
+
+    uint64_t vertex_num;
+    uint64_t edge_num;
+    uint64_t vid_gen;
+    uint64_t eid_gen;
+    uint64_t vprop_size;
+    uint64_t eprop_size;
+
+    uint64_t vid_pos;
+    uint64_t offsets_pos;
+    uint64_t targets_pos;
+    uint64_t eids_pos;
+    uint64_t in_offsets_pos;
+    uint64_t in_edges_pos;
+    uint64_t eprops_pos;
+    uint64_t vprops_pos;
+    uint64_t key_offsets_pos;
+    uint64_t keys_pos;
+    uint64_t key_order_pos;
+    uint64_t file_size;
+};
+
+inline uint64_t snapshot_align(uint64_t pos)
+{
+    return (pos + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+}
+
+// orders vertex slots by their key in a concatenated key buffer
+class snapshot_key_less
+{
+public:
+    snapshot_key_less(const std::string& k, const std::vector<uint64_t>& o)
+        :_keys(k),_offsets(o){}
+
+    bool operator()(uint64_t a, uint64_t b)
+    {
+        return _keys.compare(_offsets[a], _offsets[a+1]-_offsets[a],
+                             _keys, _offsets[b], _offsets[b+1]-_offsets[b]) < 0;
+    }
+protected:
+    const std::string & _keys;
+    const std::vector<uint64_t> & _offsets;
+};
+
+// read-only memory mapping of a snapshot file
+class snapshot_file : public mapped_file
+{
+public:
+    snapshot_file():mapped_file(){}
+
+    bool open(const std::string& filename)
+    {
+        if (!mapped_file::open(filename)) return false;
+
+        if (!valid())
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    const snapshot_header & header(void)
+    {
+        return *((const snapshot_header*)_addr);
+    }
+
+    template<class T>
+    const T * section(uint64_t pos)
+    {
+        return (const T*)(_addr + pos);
+    }
+
+    // external key of vertex slot i
+    std::string key(uint64_t slot)
+    {
+        const uint64_t * key_offsets = section<uint64_t>(header().key_offsets_pos);
+        const char * keys = section<char>(header().keys_pos);
+        return std::string(keys+key_offsets[slot], key_offsets[slot+1]-key_offsets[slot]);
+    }
+
+    // binary search on key_order. return vertex slot or vertex_num
+    uint64_t find_key(const std::string& key)
+    {
+        const uint64_t * key_order = section<uint64_t>(header().key_order_pos);
+        uint64_t lo=0, hi=header().vertex_num;
+        while (lo < hi)
+        {
+            uint64_t mid = lo + (hi-lo)/2;
+            int cmp = key_compare(key_order[mid], key);
+            if (cmp == 0) return key_order[mid];
+            if (cmp < 0) lo = mid+1;
+            else hi = mid;
+        }
+        return header().vertex_num;
+    }
+protected:
+    // checks the header and that every section lies within the file,
+    // and the key dictionary used in place by key() and find_key().
+    // the graph sections are checked by openG::open_snapshot
+    bool valid(void)
+    {
+        if (_size < sizeof(snapshot_header)) return false;
+
+        const snapshot_header & h = header();
+        if (memcmp(h.magic, SNAPSHOT_MAGIC, 8) != 0) return false;
+        if (h.version != SNAPSHOT_VERSION) return false;
+        if (h.file_size != _size) return false;
+
+        // vertex_num is bounded by the file size first, so vnum+1 does
+        // not overflow
+        uint64_t vnum = h.vertex_num;
+        if (!fits(h.vid_pos, vnum, sizeof(uint64_t))) return false;
+        if (!fits(h.offsets_pos, vnum+1, sizeof(uint64_t))) return false;
+        if (!fits(h.targets_pos, h.edge_num, sizeof(uint64_t))) return false;
+        if (!fits(h.eids_pos, h.edge_num, sizeof(uint64_t))) return false;
+        if (!fits(h.in_offsets_pos, vnum+1, sizeof(uint64_t))) return false;
+        if (!fits(h.eprops_pos, h.edge_num, h.eprop_size)) return false;
+        if (!fits(h.vprops_pos, vnum, h.vprop_size)) return false;
+        if (!fits(h.key_offsets_pos, vnum+1, sizeof(uint64_t))) return false;
+        if (!fits(h.key_order_pos, vnum, sizeof(uint64_t))) return false;
+
+        // sections whose length is stored in another section
+        const uint64_t * in_offsets = section<uint64_t>(h.in_offsets_pos);
+        if (!fits(h.in_edges_pos, in_offsets[vnum], sizeof(uint64_t))) return false;
+        const uint64_t * key_offsets = section<uint64_t>(h.key_offsets_pos);
+        if (!fits(h.keys_pos, key_offsets[vnum], 1)) return false;
+
+        if (key_offsets[0] != 0) return false;
+        for (uint64_t i=0;i<vnum;i++)
+            if (key_offsets[i] > key_offsets[i+1]) return false;
+        const uint64_t * key_order = section<uint64_t>(h.key_order_pos);
+        for (uint64_t i=0;i<vnum;i++)
+            if (key_order[i] >= vnum) return false;
+        return true;
+    }
+
+    // count elements of elem_size bytes starting at pos are in the file
+    bool fits(uint64_t pos, uint64_t count, uint64_t elem_size)
+    {
+        if (pos < sizeof(snapshot_header) || pos > _size) return false;
+        if (pos % SNAPSHOT_ALIGN != 0) return false;
+        return elem_size == 0 || count <= (_size - pos) / elem_size;
+    }
+
+    int key_compare(uint64_t slot, const std::string& key)
+    {
+        const uint64_t * key_offsets = section<uint64_t>(header().key_offsets_pos);
+        const char * keys = section<char>(header().keys_pos);
+        size_t len = key_offsets[slot+1]-key_offsets[slot];
+        int ret = memcmp(keys+key_offsets[slot], key.data(), std::min(len, key.size()));
+        if (ret != 0) return ret;
+        if (len == key.size()) return 0;
+        return (len < key.size()) ? -1 : 1;
+    }
+};
+
+}//end of namespace openG
+
+#endif
@@ -6,6 +6,10 @@
 #include <iterator>
 #include <list>
 #include <vector>
+#include <algorithm>
+#include <limits>
+#include <stdint.h>
+#include <assert.h>
 
 namespace openG
 {
@@ -51,6 +55,12 @@ public:
         base_t::push_back(val);
     }
 
+    // construct a new element from its id in place
+    void emplace_back(uint64_t id)
+    {
+        base_t::emplace_back(id);
+    }
+
     iterator erase(iterator iter)
     {
         if (iter == this->end()) return this->end();
@@ -207,6 +217,13 @@ public:
         _index.clear();
     }
 
+    void reserve(size_t n)
+    {
+        base_t::reserve(n);
+        _flags.reserve(n);
+        _index.rehash(n);
+    }
+
     void push_back(const value_type& val)
     {
         base_t::push_back(val);
@@ -215,6 +232,14 @@ public:
         _index[(const_cast<value_type&>(val)).id()] = this->size() - 1;
     }
 
+    void emplace_back(uint64_t id)
+    {
+        base_t::emplace_back(id);
+        _flags.push_back(true);
+
+        _index[id] = this->size() - 1;
+    }
+
     iterator erase(iterator iter)
     {
         if (iter == this->end()) return this->end();
@@ -246,6 +271,103 @@ protected:
     std::tr1::unordered_map<size_t, size_t> _index;
 };  // end of indexed_vector_storage class
 
+#define DENSE_NO_SLOT (std::numeric_limits<size_t>::max())
+
+// indexed vector with a direct id->slot table instead of a hash index.
+// assumes dense ids (e.g. generated by adjacency_list::gen_vid).
+// deleted slots are tombstoned until compact() is called
+template <class T>
+class dense_vector_storage : public indexed_vector_storage<T>
+{
+    typedef indexed_vector_storage<T> base_t;
+    typedef std::vector<T> data_t;
+public:
+    typedef typename base_t::iterator iterator;
+    typedef typename base_t::const_iterator const_iterator;
+    typedef typename base_t::value_type value_type;
+
+    dense_vector_storage() : base_t() {}
+
+    iterator find(const size_t& id)
+    {
+        if (id >= _slot.size() || _slot[id] == DENSE_NO_SLOT)
+            return this->end();
+        return iterator(this,&(this->_flags),_slot[id]);
+    }
+
+    void clear(void)
+    {
+        base_t::clear();
+        _slot.clear();
+    }
+
+    void push_back(const value_type& val)
+    {
+        size_t id = (const_cast<value_type&>(val)).id();
+
+        data_t::push_back(val);
+        this->_flags.push_back(true);
+
+        if (id >= _slot.size())
+            _slot.resize(id+1, DENSE_NO_SLOT);
+        _slot[id] = this->size() - 1;
+    }
+
+    void emplace_back(uint64_t id)
+    {
+        data_t::emplace_back(id);
+        this->_flags.push_back(true);
+
+        if (id >= _slot.size())
+            _slot.resize(id+1, DENSE_NO_SLOT);
+        _slot[id] = this->size() - 1;
+    }
+
+    iterator erase(iterator iter)
+    {
+        if (iter == this->end()) return this->end();
+        _slot[iter->id()] = DENSE_NO_SLOT;
+        this->invalidate(iter);
+        iter++;
+        return iter;
+    }
+
+    iterator erase(const size_t& id)
+    {
+        iterator iter = this->find(id);
+        if (iter == this->end()) return this->end();
+        return this->erase(iter);
+    }
+
+    // number of tombstoned slots
+    size_t garbage(void){return data_t::size() - live_size();}
+
+    size_t live_size(void)
+    {
+        size_t ret=0;
+        for (size_t i=0;i<this->_flags.size();i++)
+            if (this->_flags[i]) ret++;
+        return ret;
+    }
+
+    // drop tombstoned slots. invalidates all iterators
+    void compact(void)
+    {
+        size_t pos=0;
+        for (size_t i=0;i<this->_flags.size();i++)
+        {
+            if (this->_flags[i]==false) continue;
+            if (pos != i) (*this)[pos] = (*this)[i];
+            _slot[(*this)[pos].id()] = pos;
+            pos++;
+        }
+        data_t::erase(data_t::begin()+pos, data_t::end());
+        this->_flags.assign(pos, true);
+    }
+protected:
+    std::vector<size_t> _slot;
+};  // end of dense_vector_storage class
+
 template <class T>
 class list_storage : public std::list<T>
 {
@@ -258,6 +380,9 @@ public:
 
     list_storage() : base_t() {}
 
+    // lists allocate per node, nothing to reserve
+    void reserve(size_t n){}
+
     iterator find(const size_t& id)
     {
         iterator iter;
@@ -274,6 +399,12 @@ public:
         base_t::push_back(val);
     }
 
+    // construct a new element from its id in place
+    void emplace_back(uint64_t id)
+    {
+        base_t::emplace_back(id);
+    }
+
     iterator erase(iterator iter)
     {
         if (iter == this->end()) return this->end();
@@ -324,6 +455,14 @@ public:
         _index[iter->id()] = iter;
     }
 
+    void emplace_back(uint64_t id)
+    {
+        base_t::emplace_back(id);
+        iterator iter = this->end();
+        iter--;
+        _index[id] = iter;
+    }
+
     iterator erase(iterator iter)
     {
         if (iter == this->end()) return this->end();
@@ -340,11 +479,296 @@ public:
         return base_t::erase(iter);
     }
 
+    void reserve(size_t n)
+    {
+        _index.rehash(n);
+    }
 protected:
     std::tr1::unordered_map<size_t, iterator> _index;
 };//end of indexed_storage class
 
 
+// initial capacity of an edge segment in the flat edge slab
+#define FLAT_INIT_CAPACITY 4
+
+// one contiguous edge array shared by all vertices of a graph.
+// each vertex owns segments [offset, offset+capacity) in it
+template <class T>
+class edge_slab : public std::vector<T>
+{
+    typedef std::vector<T> base_t;
+
+public:
+    edge_slab() : base_t(), _garbage(0) {}
+
+    // append a new segment at the slab tail, return its offset
+    uint64_t allocate(uint64_t capacity)
+    {
+        uint64_t offset = this->size();
+        base_t::resize(offset + capacity);
+        return offset;
+    }
+
+    // grow the segment in place if it sits at the slab tail
+    bool extend(uint64_t offset, uint64_t capacity, uint64_t new_capacity)
+    {
+        if (offset + capacity != this->size()) return false;
+        base_t::resize(offset + new_capacity);
+        return true;
+    }
+
+    // mark a dead segment, it is reclaimed only by compaction
+    void release(uint64_t offset, uint64_t capacity)
+    {
+        for (uint64_t i=offset; i<offset+capacity; i++)
+            (*this)[i] = T();
+        _garbage += capacity;
+    }
+
+    uint64_t garbage(void){return _garbage;}
+
+    void clear(void)
+    {
+        base_t::clear();
+        _garbage = 0;
+    }
+
+    void swap(edge_slab& rhs)
+    {
+        base_t::swap(rhs);
+        std::swap(_garbage, rhs._garbage);
+    }
+protected:
+    uint64_t _garbage;
+};  // end of edge_slab class
+
+// edge list as a segment of a shared edge_slab.
+// class T must have a member function id() and a default constructor
+template <class T>
+class flat_edge_storage
+{
+public:
+    typedef edge_slab<T> slab_t;
+
+    //================ iterator ===============//
+    // slab position based, so that it stays valid when other
+    // segments grow and the slab is reallocated
+    class new_iterator
+    {
+    public:
+        new_iterator():_slab(NULL),_pos(0){}
+        new_iterator(slab_t* s, uint64_t p):_slab(s),_pos(p){}
+
+        new_iterator& operator++(int x){_pos++; return *this;}
+        new_iterator& operator++(){_pos++; return *this;}
+        new_iterator& operator--(int x){_pos--; return *this;}
+        new_iterator& operator--(){_pos--; return *this;}
+
+        bool operator==(const new_iterator& rhs)
+        {
+            return (this->_pos==rhs._pos && this->_slab==rhs._slab);
+        }
+        bool operator!=(const new_iterator& rhs)
+        {
+            return (this->_pos!=rhs._pos || this->_slab!=rhs._slab);
+        }
+
+        T* operator->()
+        {
+            return &((*_slab)[_pos]);
+        }
+        T& operator*()
+        {
+            return (*_slab)[_pos];
+        }
+
+        uint64_t curpos()
+        {
+            return _pos;
+        }
+    protected:
+        slab_t * _slab;
+        uint64_t _pos;
+    };
+
+    typedef new_iterator iterator;
+    typedef new_iterator const_iterator;
+    typedef T value_type;
+
+    flat_edge_storage():_slab(NULL),_offset(0),_size(0),_capacity(0){}
+
+    void attach(slab_t* slab){_slab = slab;}
+
+    iterator begin(void){return new_iterator(_slab,_offset);}
+    iterator end(void){return new_iterator(_slab,_offset+_size);}
+
+    size_t size(void){return _size;}
+    size_t capacity(void){return _capacity;}
+    bool empty(void){return _size==0;}
+
+    iterator find(const size_t& id)
+    {
+        for (uint64_t i=_offset; i<_offset+_size; i++)
+        {
+            if ((*_slab)[i].id() == id) return new_iterator(_slab,i);
+        }
+        return this->end();
+    }
+
+    void push_back(const value_type& val)
+    {
+        assert(_slab != NULL);
+        if (_size == _capacity) grow();
+
+        (*_slab)[_offset+_size] = val;
+        _size++;
+    }
+
+    // keep edge order, shift the rest of the segment
+    iterator erase(iterator iter)
+    {
+        if (iter == this->end()) return this->end();
+
+        uint64_t last = _offset + _size - 1;
+        for (uint64_t i=iter.curpos(); i<last; i++)
+            (*_slab)[i] = (*_slab)[i+1];
+        (*_slab)[last] = T();
+        _size--;
+
+        return iter;
+    }
+
+    iterator erase(const size_t& id)
+    {
+        iterator iter = this->find(id);
+        if (iter == this->end()) return this->end();
+        return this->erase(iter);
+    }
+
+    void clear(void)
+    {
+        if (_capacity > 0) _slab->release(_offset, _capacity);
+        _offset = 0;
+        _size = 0;
+        _capacity = 0;
+    }
+
+    // make room for n edges. allocates in the shared slab,
+    // so it must not run concurrently with other segments
+    void reserve(size_t n)
+    {
+        assert(_slab != NULL);
+        if (n > _capacity) resize_capacity(n);
+    }
+
+    // move the segment into another slab, leaving "slack" free slots
+    void relocate(slab_t* dest, uint64_t slack)
+    {
+        uint64_t new_capacity = (_size==0) ? 0 : _size + slack;
+        uint64_t new_offset = dest->allocate(new_capacity);
+        for (uint64_t i=0; i<_size; i++)
+            (*dest)[new_offset+i] = (*_slab)[_offset+i];
+
+        _slab = dest;
+        _offset = new_offset;
+        _capacity = new_capacity;
+    }
+protected:
+    void grow(void)
+    {
+        resize_capacity((_capacity==0) ? FLAT_INIT_CAPACITY : _capacity*2);
+    }
+
+    void resize_capacity(uint64_t new_capacity)
+    {
+        if (_capacity > 0 && _slab->extend(_offset, _capacity, new_capacity))
+        {
+            _capacity = new_capacity;
+            return;
+        }
+
+        uint64_t new_offset = _slab->allocate(new_capacity);
+        for (uint64_t i=0; i<_size; i++)
+            (*_slab)[new_offset+i] = (*_slab)[_offset+i];
+        if (_capacity > 0) _slab->release(_offset, _capacity);
+
+        _offset = new_offset;
+        _capacity = new_capacity;
+    }
+
+    slab_t * _slab;
+    uint64_t _offset;
+    uint32_t _size;
+    uint32_t _capacity;
+};  // end of flat_edge_storage class
+
+// vertex storage owning the edge slab of all its vertices.
+// class T must provide attach_edge_slab/release_edges/relocate_edges
+template <class T, class SLAB>
+class flat_vertex_storage : public dense_vector_storage<T>
+{
+    typedef dense_vector_storage<T> base_t;
+public:
+    typedef typename base_t::iterator iterator;
+    typedef typename base_t::const_iterator const_iterator;
+    typedef typename base_t::value_type value_type;
+
+    flat_vertex_storage() : base_t() {}
+
+    void clear(void)
+    {
+        base_t::clear();
+        _slab.clear();
+    }
+
+    void push_back(const value_type& val)
+    {
+        base_t::push_back(val);
+        this->back().attach_edge_slab(&_slab);
+    }
+
+    void emplace_back(uint64_t id)
+    {
+        base_t::emplace_back(id);
+        this->back().attach_edge_slab(&_slab);
+    }
+
+    iterator erase(iterator iter)
+    {
+        if (iter == this->end()) return this->end();
+        iter->release_edges();
+        return base_t::erase(iter);
+    }
+
+    iterator erase(const size_t& id)
+    {
+        iterator iter = this->find(id);
+        if (iter == this->end()) return this->end();
+        iter->release_edges();
+        return base_t::erase(iter);
+    }
+
+    // number of dead slots in the edge slab
+    uint64_t edge_garbage(void){return _slab.garbage();}
+
+    // pack all live edge segments into a fresh slab in vertex order
+    void compact_edges(uint64_t slack=0)
+    {
+        SLAB packed;
+        for (iterator iter=this->begin(); iter!=this->end(); iter++)
+            iter->relocate_edges(&packed, slack);
+
+        _slab.swap(packed);
+        for (iterator iter=this->begin(); iter!=this->end(); iter++)
+            iter->attach_edge_slab(&_slab);
+    }
+protected:
+    SLAB _slab;
+private:
+    // vertices keep a pointer to _slab, copying is not allowed
+    flat_vertex_storage(const flat_vertex_storage&);
+    flat_vertex_storage& operator=(const flat_vertex_storage&);
+};  // end of flat_vertex_storage class
 
 }//end of namespace storage
 }//end of namespace openG
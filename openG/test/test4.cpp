@@ -0,0 +1,122 @@
+#include <iostream>
+#include <tr1/memory>
+
+#include <vector>
+#include <list>
+#include <set>
+#include "openG.h"
+
+using namespace std;
+
+// FLAT_CSR_DYN layout: edges in one slab, vertices in dense storage.
+// checked against reference adjacency sets after insertion, deletion
+// and compaction
+
+class prop
+{
+public:
+    prop():A(0),B(0){}
+    prop(size_t a, size_t b):A(a),B(b){}
+
+    size_t A;
+    size_t B;
+};
+
+typedef openG::openG_configure<prop,prop,openG::FLAT_CSR_DYN> config_t;
+typedef openG::Graph<prop,prop,config_t>    graph_t;
+typedef graph_t::vertex_iterator   vertex_iterator;
+typedef graph_t::edge_iterator     edge_iterator;
+
+size_t NV=50;
+size_t NE=1000;
+
+vector<multiset<uint64_t> > out_edges;
+vector<multiset<uint64_t> > in_edges;
+vector<bool> alive;
+
+bool check(graph_t& g)
+{
+    for (vertex_iterator vit=g.vertices_begin();vit!=g.vertices_end();vit++)
+    {
+        if (vit->id()>=NV || !alive[vit->id()]) return false;
+
+        multiset<uint64_t> tmp;
+        for (edge_iterator eit=vit->out_edges_begin();eit!=vit->out_edges_end();eit++)
+        {
+            tmp.insert(eit->target());
+            if (eit->property().A!=vit->id() || eit->property().B!=eit->target())
+                return false;
+        }
+        if (tmp != out_edges[vit->id()]) return false;
+
+        tmp.clear();
+        for (edge_iterator eit=vit->in_edges_begin();eit!=vit->in_edges_end();eit++)
+            tmp.insert(eit->target());
+        if (tmp != in_edges[vit->id()]) return false;
+    }
+    return true;
+}
+
+// the id->slot table: deleted ids are not found, live ids find themselves
+bool check_ids(graph_t& g)
+{
+    size_t live=0;
+    for (size_t v=0;v<NV;v++)
+    {
+        if (!alive[v])
+        {
+            if (g.find_vertex(v)!=g.vertices_end()) return false;
+            continue;
+        }
+        live++;
+        if (g.find_vertex(v)==g.vertices_end() || g.find_vertex(v)->id()!=v)
+            return false;
+    }
+    return g.num_vertices()==live;
+}
+
+int main(int argc, char * argv[])
+{
+    graph_t g(openG::DIRECTED);
+
+    out_edges.resize(NV);
+    in_edges.resize(NV);
+    alive.assign(NV, true);
+    for (size_t i=0;i<NV;i++)
+        g.add_vertex();
+
+    for (size_t i=0;i<NE;i++)
+    {
+        uint64_t src = rand()%NV;
+        uint64_t dest = rand()%NV;
+        edge_iterator eit;
+        if (g.add_edge(src,dest,eit)) 
+            eit->set_property(prop(src,dest));
+        out_edges[src].insert(dest);
+        in_edges[dest].insert(src);
+    }
+    cout<<"=============================================="<<endl;
+    cout<<"Insert:  "<<(check(g)?"PASS":"FAIL")<<endl;
+
+    for (int i=0;i<10;i++) 
+    {
+        uint64_t vid = rand()%NV;
+        g.delete_vertex(vid);
+        alive[vid] = false;
+        for (size_t j=0;j<NV;j++)
+        {
+            out_edges[j].erase(vid);
+            in_edges[j].erase(vid);
+        }
+        out_edges[vid].clear();
+        in_edges[vid].clear();
+    }
+    cout<<"Delete:  "<<(check(g)?"PASS":"FAIL")<<endl;
+    cout<<"Find:    "<<(check_ids(g)?"PASS":"FAIL")<<endl;
+
+    g.compact_edges();
+    g.compact_vertices();
+    cout<<"Compact: "<<(check(g)?"PASS":"FAIL")<<endl;
+    cout<<"Find:    "<<(check_ids(g)?"PASS":"FAIL")<<endl;
+    cout<<"=============================================="<<endl;
+}
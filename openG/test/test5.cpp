@@ -0,0 +1,111 @@
+#include <iostream>
+#include <tr1/memory>
+
+#include <vector>
+#include <list>
+#include <algorithm>
+#include "openG.h"
+
+using namespace std;
+
+// build_from_edge_list: the bulk built graph must be identical to the
+// one built by add_edge, including edge ids, edge order and properties
+
+class prop
+{
+public:
+    prop():A(0),B(0){}
+    prop(size_t a, size_t b):A(a),B(b){}
+
+    size_t A;
+    size_t B;
+};
+
+typedef openG::Graph<prop,prop>     graph_t;
+typedef graph_t::vertex_iterator   vertex_iterator;
+typedef graph_t::edge_iterator     edge_iterator;
+
+size_t NV=50;
+size_t NE=1000;
+
+bool same_edges(edge_iterator a, edge_iterator a_end, edge_iterator b, edge_iterator b_end)
+{
+    for (;a!=a_end && b!=b_end;a++,b++)
+    {
+        if (a->id()!=b->id() || a->target()!=b->target()) return false;
+        if (a->property().A!=b->property().A || a->property().B!=b->property().B)
+            return false;
+    }
+    return a==a_end && b==b_end;
+}
+
+bool same(graph_t& g1, graph_t& g2)
+{
+    if (g1.num_vertices()!=g2.num_vertices() || g1.num_edges()!=g2.num_edges())
+        return false;
+    for (vertex_iterator vit=g1.vertices_begin();vit!=g1.vertices_end();vit++)
+    {
+        vertex_iterator vit2 = g2.find_vertex(vit->id());
+        if (vit2==g2.vertices_end()) return false;
+        if (!same_edges(vit->out_edges_begin(),vit->out_edges_end(),
+                        vit2->out_edges_begin(),vit2->out_edges_end()))
+            return false;
+        if (!same_edges(vit->in_edges_begin(),vit->in_edges_end(),
+                        vit2->in_edges_begin(),vit2->in_edges_end()))
+            return false;
+    }
+    return true;
+}
+
+// add_edge reference. edges with unknown vertices are skipped
+void incremental(graph_t& g, vector<pair<uint64_t,uint64_t> >& edges)
+{
+    for (size_t i=0;i<edges.size();i++)
+    {
+        edge_iterator eit;
+        if (g.add_edge(edges[i].first,edges[i].second,eit))
+            eit->set_property(prop(edges[i].first,edges[i].second));
+    }
+}
+
+bool test(openG::Directness_t d, bool sort_by_source, unsigned threadnum)
+{
+    vector<pair<uint64_t,uint64_t> > edges;
+    vector<prop> props;
+    for (size_t i=0;i<NE;i++)
+    {
+        uint64_t src = rand()%(NV+2);  // some vertices do not exist
+        uint64_t dest = rand()%(NV+2);
+        edges.push_back(make_pair(src,dest));
+        props.push_back(prop(src,dest));
+    }
+
+    graph_t g1(d), g2(d);
+    for (size_t i=0;i<NV;i++)
+    {
+        g1.add_vertex();
+        g2.add_vertex();
+    }
+    // existing edges are kept
+    incremental(g1, edges);
+    incremental(g2, edges);
+
+    vector<pair<uint64_t,uint64_t> > sorted(edges);
+    if (sort_by_source) stable_sort(sorted.begin(), sorted.end());
+    incremental(g1, sorted);
+    g2.build_from_edge_list(edges.begin(), edges.end(), props, threadnum, sort_by_source);
+
+    return same(g1, g2);
+}
+
+int main(int argc, char * argv[])
+{
+    cout<<"=============================================="<<endl;
+    cout<<"Directed:            "<<(test(openG::DIRECTED,false,1)?"PASS":"FAIL")<<endl;
+    cout<<"Undirected:          "<<(test(openG::UNDIRECTED,false,1)?"PASS":"FAIL")<<endl;
+    cout<<"Directed sorted:     "<<(test(openG::DIRECTED,true,1)?"PASS":"FAIL")<<endl;
+    cout<<"Undirected sorted:   "<<(test(openG::UNDIRECTED,true,1)?"PASS":"FAIL")<<endl;
+    cout<<"Directed parallel:   "<<(test(openG::DIRECTED,false,4)?"PASS":"FAIL")<<endl;
+    cout<<"Undirected parallel: "<<(test(openG::UNDIRECTED,true,4)?"PASS":"FAIL")<<endl;
+    cout<<"=============================================="<<endl;
+}
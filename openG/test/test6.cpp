@@ -0,0 +1,115 @@
+#include <iostream>
+#include <tr1/memory>
+
+#include <vector>
+#include <list>
+#include <set>
+#include "openG.h"
+
+using namespace std;
+
+// concurrent mode: edges added and vertices deleted from several
+// threads must leave the same adjacency as the serial operations
+
+class prop
+{
+public:
+    prop():A(0),B(0){}
+    prop(size_t a, size_t b):A(a),B(b){}
+
+    size_t A;
+    size_t B;
+};
+
+typedef openG::Graph<prop,prop>     graph_t;
+typedef graph_t::vertex_iterator   vertex_iterator;
+typedef graph_t::edge_iterator     edge_iterator;
+
+size_t NV=200;
+size_t NE=20000;
+int THREADS=4;
+
+vector<multiset<uint64_t> > out_edges;
+vector<multiset<uint64_t> > in_edges;
+
+bool check(graph_t& g, openG::Directness_t d)
+{
+    size_t vnum=0;
+    for (vertex_iterator vit=g.vertices_begin();vit!=g.vertices_end();vit++)
+    {
+        multiset<uint64_t> tmp;
+        for (edge_iterator eit=vit->out_edges_begin();eit!=vit->out_edges_end();eit++)
+        {
+            tmp.insert(eit->target());
+            if (eit->property().A+eit->property().B != vit->id()+eit->target())
+                return false;
+        }
+        if (tmp != out_edges[vit->id()]) return false;
+
+        tmp.clear();
+        for (edge_iterator eit=vit->in_edges_begin();eit!=vit->in_edges_end();eit++)
+            tmp.insert(eit->target());
+        if (d==openG::DIRECTED && tmp != in_edges[vit->id()]) return false;
+        vnum++;
+    }
+    return vnum==g.num_vertices();
+}
+
+bool test(openG::Directness_t d)
+{
+    graph_t g(d);
+    out_edges.assign(NV, multiset<uint64_t>());
+    in_edges.assign(NV, multiset<uint64_t>());
+    for (size_t i=0;i<NV;i++)
+        g.add_vertex();
+
+    vector<pair<uint64_t,uint64_t> > edges;
+    for (size_t i=0;i<NE;i++)
+    {
+        uint64_t src = rand()%NV;
+        uint64_t dest = rand()%NV;
+        edges.push_back(make_pair(src,dest));
+        out_edges[src].insert(dest);
+        in_edges[dest].insert(src);
+        if (d==openG::UNDIRECTED) out_edges[dest].insert(src);
+    }
+
+    g.set_concurrent(true);
+    #pragma omp parallel for num_threads(THREADS)
+    for (size_t i=0;i<NE;i++)
+    {
+        edge_iterator eit;
+        g.add_edge(edges[i].first, edges[i].second,
+                   prop(edges[i].first,edges[i].second), eit);
+    }
+    bool ret = check(g, d) && g.num_edges()==((d==openG::DIRECTED)?NE:2*NE);
+
+    vector<uint64_t> victims;
+    for (size_t i=0;i<NV/4;i++)
+        victims.push_back(rand()%NV);
+    #pragma omp parallel for num_threads(THREADS)
+    for (size_t i=0;i<victims.size();i++)
+        g.delete_vertex(victims[i]);
+    g.set_concurrent(false);
+
+    for (size_t i=0;i<victims.size();i++)
+    {
+        uint64_t vid = victims[i];
+        for (size_t j=0;j<NV;j++)
+        {
+            out_edges[j].erase(vid);
+            in_edges[j].erase(vid);
+        }
+        out_edges[vid].clear();
+        in_edges[vid].clear();
+    }
+    return ret && check(g, d);
+}
+
+int main(int argc, char * argv[])
+{
+    cout<<"=============================================="<<endl;
+    cout<<"Directed:   "<<(test(openG::DIRECTED)?"PASS":"FAIL")<<endl;
+    cout<<"Undirected: "<<(test(openG::UNDIRECTED)?"PASS":"FAIL")<<endl;
+    cout<<"=============================================="<<endl;
+}
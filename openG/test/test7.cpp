@@ -0,0 +1,108 @@
+#include <iostream>
+#include <tr1/memory>
+
+#include <vector>
+#include <list>
+#include <set>
+#include "openG.h"
+
+using namespace std;
+
+// delete_vertices: deleting a batch must leave the same graph as
+// deleting the vertices one by one, with exact edge counts
+
+class prop
+{
+public:
+    prop():A(0),B(0){}
+    prop(size_t a, size_t b):A(a),B(b){}
+
+    size_t A;
+    size_t B;
+};
+
+typedef openG::Graph<prop,prop>     graph_t;
+typedef graph_t::vertex_iterator   vertex_iterator;
+typedef graph_t::edge_iterator     edge_iterator;
+
+size_t NV=200;
+size_t NE=4000;
+
+uint64_t count_edges(graph_t& g)
+{
+    uint64_t ret=0;
+    for (vertex_iterator vit=g.vertices_begin();vit!=g.vertices_end();vit++)
+    {
+        for (edge_iterator eit=vit->out_edges_begin();eit!=vit->out_edges_end();eit++)
+            ret++;
+    }
+    return ret;
+}
+
+bool same(graph_t& g1, graph_t& g2)
+{
+    if (g1.num_vertices()!=g2.num_vertices() || g1.num_edges()!=g2.num_edges())
+        return false;
+    if (g1.num_edges()!=count_edges(g1) || g2.num_edges()!=count_edges(g2))
+        return false;
+    for (vertex_iterator vit=g1.vertices_begin();vit!=g1.vertices_end();vit++)
+    {
+        vertex_iterator vit2 = g2.find_vertex(vit->id());
+        if (vit2==g2.vertices_end()) return false;
+
+        multiset<uint64_t> a, b;
+        for (edge_iterator eit=vit->out_edges_begin();eit!=vit->out_edges_end();eit++)
+            a.insert(eit->id());
+        for (edge_iterator eit=vit2->out_edges_begin();eit!=vit2->out_edges_end();eit++)
+            b.insert(eit->id());
+        if (a!=b) return false;
+
+        a.clear();
+        b.clear();
+        for (edge_iterator eit=vit->in_edges_begin();eit!=vit->in_edges_end();eit++)
+            a.insert(eit->id());
+        for (edge_iterator eit=vit2->in_edges_begin();eit!=vit2->in_edges_end();eit++)
+            b.insert(eit->id());
+        if (a!=b) return false;
+    }
+    return true;
+}
+
+bool test(openG::Directness_t d, unsigned threadnum)
+{
+    graph_t g1(d), g2(d);
+    for (size_t i=0;i<NV;i++)
+    {
+        g1.add_vertex();
+        g2.add_vertex();
+    }
+    for (size_t i=0;i<NE;i++)
+    {
+        uint64_t src = rand()%NV;
+        uint64_t dest = rand()%NV;
+        edge_iterator eit;
+        g1.add_edge(src,dest,eit);
+        g2.add_edge(src,dest,eit);
+    }
+
+    // duplicates and unknown ids are ignored
+    vector<uint64_t> victims;
+    for (size_t i=0;i<NV/4;i++)
+        victims.push_back(rand()%(NV+10));
+
+    for (size_t i=0;i<victims.size();i++)
+        g1.delete_vertex(victims[i]);
+    g2.delete_vertices(victims, threadnum);
+
+    return same(g1, g2);
+}
+
+int main(int argc, char * argv[])
+{
+    cout<<"=============================================="<<endl;
+    cout<<"Directed:            "<<(test(openG::DIRECTED,1)?"PASS":"FAIL")<<endl;
+    cout<<"Undirected:          "<<(test(openG::UNDIRECTED,1)?"PASS":"FAIL")<<endl;
+    cout<<"Directed parallel:   "<<(test(openG::DIRECTED,4)?"PASS":"FAIL")<<endl;
+    cout<<"Undirected parallel: "<<(test(openG::UNDIRECTED,4)?"PASS":"FAIL")<<endl;
+    cout<<"=============================================="<<endl;
+}